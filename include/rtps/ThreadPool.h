@@ -29,14 +29,19 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/communication/PacketInfo.h"
 #include "rtps/communication/UdpDriver.h"
 #include "rtps/config.h"
+#include "rtps/storages/LockFreeCircularBuffer.h"
 #include "rtps/storages/PBufWrapper.h"
 #include "rtps/storages/ThreadSafeCircularBuffer.h"
+#include "rtps/utils/TimerWheel.h"
 
 #include <array>
+#include <atomic>
+#include <type_traits>
 
 namespace rtps {
 
 class Writer;
+class Reader;
 
 class ThreadPool {
 public:
@@ -51,39 +56,71 @@ public:
 
   void clearQueues();
   bool addWorkload(Writer *workload);
+  //! Queues protocol responses of a reader, e.g. ACKNACKs, which are sent by
+  //! the writer threads ahead of the writer workloads
+  bool addControlWorkload(Reader *reader);
   bool addNewPacket(PacketInfo &&packet);
 
   static void readCallback(void *arg, udp_pcb *pcb, pbuf *p,
                            const ip_addr_t *addr, Ip4Port_t port);
+  //! Receive callback for drivers that deliver complete packets
+  static void packetCallback(void *arg, PacketInfo &packet);
 
   bool addBuiltinPort(const Ip4Port_t &port);
 
+  TimerWheel &getTimerWheel() { return m_timers; }
+
 private:
   receiveJumppad_fp m_receiveJumppad;
   void *m_callee;
   bool m_running = false;
   std::array<sys_thread_t, Config::THREAD_POOL_NUM_WRITERS> m_writers;
   std::array<sys_thread_t, Config::THREAD_POOL_NUM_READERS> m_readers;
+  TimerWheel m_timers;
 
   std::array<Ip4Port_t, 2 * Config::MAX_NUM_PARTICIPANTS> m_builtinPorts;
   size_t m_builtinPortsIdx = 0;
 
   sys_sem_t m_readerNotificationSem;
   sys_sem_t m_writerNotificationSem;
+  // Set while a wakeup is pending, so a burst causes a single signal
+  std::atomic<bool> m_readerWakeupPending{false};
+  std::atomic<bool> m_writerWakeupPending{false};
 
   void updateDiagnostics();
 
-  using BufferUsertrafficOutgoing = ThreadSafeCircularBuffer<
-      Writer *, Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC>;
-  using BufferMetatrafficOutgoing = ThreadSafeCircularBuffer<
-      Writer *, Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_METATRAFFIC>;
-  using BufferUsertrafficIncoming = ThreadSafeCircularBuffer<
-      PacketInfo, Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC>;
-  using BufferMetatrafficIncoming = ThreadSafeCircularBuffer<
-      PacketInfo, Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_METATRAFFIC>;
-
-  BufferUsertrafficOutgoing m_outgoingUserTraffic;
-  BufferMetatrafficOutgoing m_outgoingMetaTraffic;
+  // Each queue can use any of ThreadSafeCircularBuffer, MpmcCircularBuffer
+  // and SpscCircularBuffer. Workloads are added from arbitrary user threads.
+  // Packets are only added from the receiving thread of the driver (the
+  // tcpip thread for lwIP), so a single reader thread turns the incoming
+  // queues into SPSC queues.
+  template <typename T, uint16_t SIZE>
+  using IncomingQueue = typename std::conditional<
+      Config::THREAD_POOL_NUM_READERS == 1, SpscCircularBuffer<T, SIZE>,
+      MpmcCircularBuffer<T, SIZE>>::type;
+
+  struct Workload {
+    Writer *writer;
+    uint32_t enqueuedAt; // sys_now()
+  };
+  using BufferOutgoing =
+      MpmcCircularBuffer<Workload,
+                         Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC>;
+  using BufferUsertrafficIncoming =
+      IncomingQueue<PacketInfo,
+                    Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC>;
+  using BufferMetatrafficIncoming =
+      IncomingQueue<PacketInfo,
+                    Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_METATRAFFIC>;
+
+  using BufferControl =
+      MpmcCircularBuffer<Reader *,
+                         Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_METATRAFFIC>;
+  BufferControl m_outgoingControl;
+
+  // One queue per writer priority
+  std::array<BufferOutgoing, Config::THREAD_POOL_NUM_PRIORITIES> m_outgoing;
+  std::array<uint8_t, Config::THREAD_POOL_NUM_PRIORITIES> m_skippedRounds{};
 
   BufferUsertrafficIncoming m_incomingUserTraffic;
   BufferMetatrafficIncoming m_incomingMetaTraffic;
@@ -92,7 +129,11 @@ private:
   static void writerThreadFunction(void *arg);
   static void readerThreadFunction(void *arg);
   void doWriterWork();
+  uint32_t doControlWork();
+  uint8_t selectPriority();
+  static void recordQueueingDelay(uint8_t priority, uint32_t delayMs);
   void doReaderWork();
+  static void notify(sys_sem_t &sem, std::atomic<bool> &wakeupPending);
 };
 } // namespace rtps
 
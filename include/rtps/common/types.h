@@ -29,6 +29,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 
 #include <array>
 #include <cstdint>
+#include <cstring>
 #include <initializer_list>
 #include <limits>
 
@@ -224,6 +225,26 @@ struct FragmentNumber_t {
   uint32_t value;
 };
 
+// Same layout as SequenceNumberSet, fragment numbers start at 1
+struct FragmentNumberSet {
+  FragmentNumber_t base = {0};
+  uint32_t numBits = 0;
+  std::array<uint32_t, (SNS_MAX_NUM_BITS / 32)> bitMap{};
+
+  bool isSet(uint32_t bit) const {
+    if (bit >= SNS_MAX_NUM_BITS) {
+      return false;
+    }
+    return (bitMap[bit / 32] & (1u << (31 - bit % 32))) != 0;
+  }
+
+  void set(uint32_t bit) {
+    if (bit < SNS_MAX_NUM_BITS) {
+      bitMap[bit / 32] |= 1u << (31 - bit % 32);
+    }
+  }
+};
+
 struct Count_t {
   int32_t value;
 };
@@ -249,6 +270,50 @@ struct InstanceHandle_t { // TODO
   uint64_t value;
 };
 
+struct KeyHash_t {
+  std::array<uint8_t, 16> value{};
+
+  bool operator==(const KeyHash_t &other) const {
+    return value == other.value;
+  }
+};
+
+enum StatusInfoFlag : uint8_t {
+  STATUS_INFO_DISPOSED = (1 << 0),
+  STATUS_INFO_UNREGISTERED = (1 << 1),
+  STATUS_INFO_FILTERED = (1 << 2)
+};
+
+//! Parameters of the inline QoS of a DATA submessage that readers evaluate
+struct InlineQos_t {
+  bool hasKeyHash = false;
+  bool hasStatusInfo = false;
+  uint8_t statusInfo = 0; // Last octet of PID_STATUS_INFO, the others are 0
+  KeyHash_t keyHash;
+
+  ChangeKind_t getChangeKind() const {
+    if (!hasStatusInfo) {
+      return ChangeKind_t::ALIVE;
+    } else if (statusInfo & STATUS_INFO_DISPOSED) {
+      return ChangeKind_t::NOT_ALIVE_DISPOSED;
+    } else if (statusInfo & STATUS_INFO_UNREGISTERED) {
+      return ChangeKind_t::NOT_ALIVE_UNREGISTERED;
+    }
+    return ChangeKind_t::ALIVE;
+  }
+
+  //! Key hashes of builtin endpoints and participants are their GUIDs
+  Guid_t getGuidFromKeyHash() const {
+    Guid_t guid;
+    memcpy(guid.prefix.id.data(), keyHash.value.data(),
+           guid.prefix.id.size());
+    memcpy(guid.entityId.entityKey.data(), keyHash.value.data() + 12,
+           guid.entityId.entityKey.size());
+    guid.entityId.entityKind = static_cast<EntityKind_t>(keyHash.value[15]);
+    return guid;
+  }
+};
+
 struct ParticipantMessageData { // TODO
 };
 
@@ -0,0 +1,136 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_LINUXUDPDRIVER_H
+#define RTPS_LINUXUDPDRIVER_H
+
+#if defined(__linux__)
+
+#include "lwip/pbuf.h"
+#include "rtps/common/types.h"
+#include "rtps/communication/PacketInfo.h"
+#include "rtps/config.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+
+namespace rtps {
+
+/**
+ * NetworkDriver for Linux hosts using native UDP sockets instead of the lwIP
+ * stack. Packets are received in batches with recvmmsg directly into a ring
+ * of preallocated pbufs and sent in batches with sendmmsg, with every pbuf of
+ * a chain passed as its own iovec. sendPacket() only queues the packet, a
+ * sender thread hands everything queued so far to the kernel at once.
+ *
+ * Can be used for StatefulWriterT, StatelessWriterT, StatefulReaderT and
+ * MessageBatcherT, e.g. with ThreadPool::packetCallback as receive callback.
+ */
+class LinuxUdpDriver {
+
+public:
+  typedef void (*rxFunc_fp)(void *arg, PacketInfo &packet);
+
+  static constexpr uint16_t RX_BATCH_SIZE = 32;
+  static constexpr uint16_t TX_BATCH_SIZE = 32;
+  static constexpr uint16_t RX_BUFFER_SIZE = 1536; // byte
+  static constexpr uint8_t MAX_IOV_PER_PACKET = 8;
+  static constexpr int POLL_TIMEOUT_MS = 100;
+
+  LinuxUdpDriver(rxFunc_fp callback, void *args);
+  ~LinuxUdpDriver();
+
+  LinuxUdpDriver(const LinuxUdpDriver &) = delete;
+  LinuxUdpDriver &operator=(const LinuxUdpDriver &) = delete;
+
+  bool createUdpConnection(Ip4Port_t receivePort);
+  bool joinMultiCastGroup(ip4_addr_t addr);
+  void sendPacket(PacketInfo &info);
+
+  //! Blocks until all queued packets were handed to the kernel
+  void flush();
+
+private:
+  struct Connection {
+    int fd = -1;
+    Ip4Port_t port = 0;
+  };
+
+  struct TxEntry {
+    int fd = -1;
+    sockaddr_in dest{};
+    pbuf *buffer = nullptr;
+  };
+
+  rxFunc_fp m_rxCallback = nullptr;
+  void *m_callbackArgs = nullptr;
+  std::atomic<bool> m_running{true};
+
+  std::mutex m_connMutex;
+  std::array<Connection, Config::MAX_NUM_UDP_CONNECTIONS> m_conns;
+  std::size_t m_numConns = 0;
+  std::array<ip4_addr_t, 4> m_groups;
+  std::size_t m_numGroups = 0;
+
+  // Only used by the receive thread
+  std::array<pbuf *, RX_BATCH_SIZE> m_rxBuffers{};
+  std::array<mmsghdr, RX_BATCH_SIZE> m_rxMsgs;
+  std::array<iovec, RX_BATCH_SIZE> m_rxIov;
+  std::array<sockaddr_in, RX_BATCH_SIZE> m_rxSources;
+  std::array<uint16_t, RX_BATCH_SIZE> m_rxSlots;
+  std::thread m_rxThread;
+
+  std::mutex m_txMutex;
+  std::condition_variable m_txCondition;
+  std::array<TxEntry, TX_BATCH_SIZE> m_txPending;
+  std::size_t m_numTxPending = 0;
+  bool m_txInProgress = false;
+  // Only used by the thread that set m_txInProgress
+  std::array<TxEntry, TX_BATCH_SIZE> m_txBatch;
+  std::array<mmsghdr, TX_BATCH_SIZE> m_txMsgs;
+  std::array<std::array<iovec, MAX_IOV_PER_PACKET>, TX_BATCH_SIZE> m_txIov;
+  std::thread m_txThread;
+
+  int getSocketLocked(Ip4Port_t port);
+  static bool joinGroup(int fd, ip4_addr_t addr);
+
+  void receiveLoop();
+  void receiveBatch(const Connection &conn);
+
+  void sendLoop();
+  void sendPending(std::unique_lock<std::mutex> &lock);
+  void sendBatch(std::size_t count);
+  bool prepareMessage(TxEntry &entry, mmsghdr &msg,
+                      std::array<iovec, MAX_IOV_PER_PACKET> &iov);
+};
+} // namespace rtps
+
+#endif // defined(__linux__)
+
+#endif // RTPS_LINUXUDPDRIVER_H
@@ -0,0 +1,102 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_MESSAGEBATCHER_H
+#define RTPS_MESSAGEBATCHER_H
+
+#include "lwip/sys.h"
+#include "rtps/common/Locator.h"
+#include "rtps/common/types.h"
+#include "rtps/communication/PacketInfo.h"
+#include "rtps/config.h"
+#include "rtps/messages/MessageTypes.h"
+#include "rtps/utils/TimerWheel.h"
+
+#include <array>
+
+namespace rtps {
+
+/**
+ * Collects submessages per destination and sends them as a single RTPS
+ * message, such that header and INFO_TS are only sent once. A message is sent
+ * when the next submessage does not fit into Config::MESSAGE_BATCH_MAX_SIZE,
+ * when it was opened Config::MESSAGE_BATCH_MAX_DELAY_MS ago or when flush() is
+ * called. The delay is enforced by a timer on the given TimerWheel. Without
+ * one, it is only checked on the next add().
+ */
+template <class NetworkDriver> class MessageBatcherT {
+public:
+  ~MessageBatcherT();
+  bool init(NetworkDriver &driver, const GuidPrefix_t &guidPrefix,
+            Ip4Port_t srcPort, TimerWheel *timerWheel);
+  //! Drops pending submessages and stops the timer
+  void reset();
+
+  /**
+   * Serializes a submessage of the given size into the message for the
+   * destination by calling serialize(PBufWrapper &).
+   * @return false if the submessage cannot be batched, e.g. because it is too
+   * large. Pending submessages for the destination have been sent in this case
+   * so the caller can send it on its own without reordering.
+   */
+  template <class Serializer>
+  bool add(const LocatorIPv4 &destination, DataSize_t size,
+           Serializer serialize);
+
+  void flush();
+  void flush(const LocatorIPv4 &destination);
+
+private:
+  struct Batch {
+    PacketInfo packet;
+    TickType_t openedAt = 0;
+    bool inUse = false;
+  };
+
+  NetworkDriver *mp_driver = nullptr;
+  GuidPrefix_t m_guidPrefix = GUIDPREFIX_UNKNOWN;
+  Ip4Port_t m_srcPort = 0;
+  SemaphoreHandle_t m_mutex = nullptr;
+  std::array<Batch, Config::MESSAGE_BATCH_NUM_DESTINATIONS> m_batches;
+
+  TimerWheel *mp_timerWheel = nullptr;
+  Timer m_flushTimer{flushTimerJumppad, this};
+  bool m_flushTimerArmed = false; // Protected by m_mutex
+
+  static constexpr DataSize_t m_prefixSize = Header::getRawSize() +
+                                             SubmessageHeader::getRawSize() +
+                                             sizeof(Time_t);
+
+  Batch *getBatch(const LocatorIPv4 &destination, DataSize_t size);
+  bool open(Batch &batch, const LocatorIPv4 &destination);
+  void send(Batch &batch);
+  static void flushTimerJumppad(void *thisPointer);
+  void flushExpired();
+};
+
+} // namespace rtps
+
+#include "MessageBatcher.tpp"
+
+#endif // RTPS_MESSAGEBATCHER_H
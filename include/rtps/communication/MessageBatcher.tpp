@@ -0,0 +1,248 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "rtps/messages/MessageFactory.h"
+#include "rtps/utils/Lock.h"
+#include "rtps/utils/Log.h"
+
+#if MSG_BATCHER_VERBOSE && RTPS_GLOBAL_VERBOSE
+#include "rtps/utils/printutils.h"
+#define MSG_BATCHER_LOG(...)                                                   \
+  if (true) {                                                                  \
+    printf("[MessageBatcher] ");                                               \
+    printf(__VA_ARGS__);                                                       \
+    printf("\r\n");                                                            \
+  }
+#else
+#define MSG_BATCHER_LOG(...) //
+#endif
+
+namespace rtps {
+
+template <class NetworkDriver>
+MessageBatcherT<NetworkDriver>::~MessageBatcherT() {
+  if (mp_timerWheel != nullptr) {
+    mp_timerWheel->cancel(m_flushTimer);
+  }
+  for (auto &batch : m_batches) {
+    batch.packet.buffer.destroy();
+  }
+}
+
+template <class NetworkDriver>
+bool MessageBatcherT<NetworkDriver>::init(NetworkDriver &driver,
+                                          const GuidPrefix_t &guidPrefix,
+                                          Ip4Port_t srcPort,
+                                          TimerWheel *timerWheel) {
+  if (m_mutex == nullptr && !createMutex(&m_mutex)) {
+    MSG_BATCHER_LOG("Failed to create mutex.");
+    return false;
+  }
+
+  reset();
+  Lock lock{m_mutex};
+  mp_driver = &driver;
+  m_guidPrefix = guidPrefix;
+  m_srcPort = srcPort;
+  mp_timerWheel = timerWheel;
+  return true;
+}
+
+template <class NetworkDriver> void MessageBatcherT<NetworkDriver>::reset() {
+  if (m_mutex == nullptr) {
+    return;
+  }
+  // Not under m_mutex, the timer callback takes it
+  if (mp_timerWheel != nullptr) {
+    mp_timerWheel->cancel(m_flushTimer);
+  }
+
+  Lock lock{m_mutex};
+  m_flushTimerArmed = false;
+  for (auto &batch : m_batches) {
+    batch.packet.buffer.destroy();
+    batch.inUse = false;
+  }
+}
+
+template <class NetworkDriver>
+template <class Serializer>
+bool MessageBatcherT<NetworkDriver>::add(const LocatorIPv4 &destination,
+                                         DataSize_t size,
+                                         Serializer serialize) {
+  if (mp_driver == nullptr) {
+    return false;
+  }
+
+  Lock lock{m_mutex};
+  Batch *batch = getBatch(destination, size);
+  if (batch == nullptr) {
+    return false;
+  }
+
+  serialize(batch->packet.buffer);
+  return true;
+}
+
+template <class NetworkDriver> void MessageBatcherT<NetworkDriver>::flush() {
+  if (mp_driver == nullptr) {
+    return;
+  }
+
+  Lock lock{m_mutex};
+  for (auto &batch : m_batches) {
+    if (batch.inUse) {
+      send(batch);
+    }
+  }
+}
+
+template <class NetworkDriver>
+void MessageBatcherT<NetworkDriver>::flush(const LocatorIPv4 &destination) {
+  if (mp_driver == nullptr) {
+    return;
+  }
+
+  Lock lock{m_mutex};
+  const ip4_addr_t address = destination.getIp4Address();
+  for (auto &batch : m_batches) {
+    if (batch.inUse && batch.packet.destPort == destination.port &&
+        ip4_addr_cmp(&batch.packet.destAddr, &address)) {
+      send(batch);
+    }
+  }
+}
+
+template <class NetworkDriver>
+typename MessageBatcherT<NetworkDriver>::Batch *
+MessageBatcherT<NetworkDriver>::getBatch(const LocatorIPv4 &destination,
+                                         DataSize_t size) {
+  const ip4_addr_t address = destination.getIp4Address();
+  Batch *candidate = nullptr;
+  for (auto &batch : m_batches) {
+    if (batch.inUse && batch.packet.destPort == destination.port &&
+        ip4_addr_cmp(&batch.packet.destAddr, &address)) {
+      const bool expired = (xTaskGetTickCount() - batch.openedAt) >
+                           pdMS_TO_TICKS(Config::MESSAGE_BATCH_MAX_DELAY_MS);
+      if (!expired && batch.packet.buffer.spaceLeft() >= size) {
+        return &batch;
+      }
+      send(batch);
+      candidate = &batch;
+      break;
+    }
+    if (candidate == nullptr && !batch.inUse) {
+      candidate = &batch;
+    }
+  }
+
+  if (m_prefixSize + size > Config::MESSAGE_BATCH_MAX_SIZE) {
+    return nullptr;
+  }
+
+  if (candidate == nullptr) {
+    // All slots taken by other destinations, send the oldest one
+    candidate = &m_batches[0];
+    for (auto &batch : m_batches) {
+      if ((xTaskGetTickCount() - batch.openedAt) >
+          (xTaskGetTickCount() - candidate->openedAt)) {
+        candidate = &batch;
+      }
+    }
+    send(*candidate);
+  }
+
+  if (!open(*candidate, destination)) {
+    return nullptr;
+  }
+  return candidate;
+}
+
+template <class NetworkDriver>
+bool MessageBatcherT<NetworkDriver>::open(Batch &batch,
+                                          const LocatorIPv4 &destination) {
+  batch.packet.buffer.destroy();
+  if (!batch.packet.buffer.reserve(Config::MESSAGE_BATCH_MAX_SIZE)) {
+    MSG_BATCHER_LOG("Failed to allocate message.");
+    return false;
+  }
+
+  batch.packet.srcPort = m_srcPort;
+  batch.packet.destAddr = destination.getIp4Address();
+  batch.packet.destPort = (Ip4Port_t)destination.port;
+  MessageFactory::addHeader(batch.packet.buffer, m_guidPrefix);
+  MessageFactory::addSubMessageTimeStamp(batch.packet.buffer);
+  batch.openedAt = xTaskGetTickCount();
+  batch.inUse = true;
+  if (mp_timerWheel != nullptr && !m_flushTimerArmed) {
+    m_flushTimerArmed = true;
+    mp_timerWheel->schedule(m_flushTimer, Config::MESSAGE_BATCH_MAX_DELAY_MS);
+  }
+  return true;
+}
+
+template <class NetworkDriver>
+void MessageBatcherT<NetworkDriver>::send(Batch &batch) {
+  batch.inUse = false;
+  batch.packet.buffer.shrinkToFit();
+  MSG_BATCHER_LOG("Sending %u bytes.",
+                  static_cast<unsigned int>(batch.packet.buffer.spaceUsed()));
+  mp_driver->sendPacket(batch.packet);
+  batch.packet.buffer.destroy();
+}
+
+template <class NetworkDriver>
+void MessageBatcherT<NetworkDriver>::flushTimerJumppad(void *thisPointer) {
+  static_cast<MessageBatcherT<NetworkDriver> *>(thisPointer)->flushExpired();
+}
+
+//! Sends the batches that reached the maximum delay and rearms the timer for
+//! the oldest of the others
+template <class NetworkDriver>
+void MessageBatcherT<NetworkDriver>::flushExpired() {
+  Lock lock{m_mutex};
+  const TickType_t now = xTaskGetTickCount();
+  const TickType_t maxDelay = pdMS_TO_TICKS(Config::MESSAGE_BATCH_MAX_DELAY_MS);
+  TickType_t nextExpiry = maxDelay;
+  m_flushTimerArmed = false;
+  for (auto &batch : m_batches) {
+    if (!batch.inUse) {
+      continue;
+    }
+    const TickType_t age = now - batch.openedAt;
+    if (age >= maxDelay) {
+      send(batch);
+    } else {
+      m_flushTimerArmed = true;
+      if (maxDelay - age < nextExpiry) {
+        nextExpiry = maxDelay - age;
+      }
+    }
+  }
+  if (m_flushTimerArmed) {
+    mp_timerWheel->schedule(m_flushTimer, nextExpiry * portTICK_PERIOD_MS);
+  }
+}
+
+} // namespace rtps
@@ -0,0 +1,116 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_TOKENBUCKET_H
+#define RTPS_TOKENBUCKET_H
+
+#include "lwip/sys.h"
+
+#include <cstdint>
+
+namespace rtps {
+
+/**
+ * Limits the number of bytes sent per second. The bucket holds up to
+ * burstBytes tokens and is refilled with bytesPerSecond. A send is allowed
+ * as soon as the bucket holds min(bytes, burstBytes) tokens, so samples
+ * larger than the burst may drive it into debt, which is paid back before
+ * anything else is sent. A rate of 0 disables the limit.
+ * Not thread-safe, the owner has to serialize access.
+ */
+class TokenBucket {
+public:
+  TokenBucket(uint32_t bytesPerSecond, uint32_t burstBytes)
+      : m_rate(bytesPerSecond), m_burst(burstBytes), m_tokens(burstBytes) {}
+
+  void configure(uint32_t bytesPerSecond, uint32_t burstBytes) {
+    m_rate = bytesPerSecond;
+    m_burst = burstBytes;
+    m_tokens = burstBytes;
+    m_remainder = 0;
+    m_started = false;
+  }
+
+  bool isLimited() const { return m_rate != 0; }
+
+  bool tryConsume(uint32_t bytes) {
+    if (!isLimited()) {
+      return true;
+    }
+    refill();
+    if (m_tokens < static_cast<int64_t>(getThreshold(bytes))) {
+      return false;
+    }
+    m_tokens -= bytes;
+    return true;
+  }
+
+  //! Time until tryConsume(bytes) succeeds, at least 1 ms
+  uint32_t getWaitTimeMs(uint32_t bytes) {
+    if (!isLimited()) {
+      return 0;
+    }
+    refill();
+    const int64_t missing = getThreshold(bytes) - m_tokens;
+    if (missing <= 0) {
+      return 1;
+    }
+    return static_cast<uint32_t>((missing * 1000 + m_rate - 1) / m_rate);
+  }
+
+private:
+  uint32_t m_rate;
+  uint32_t m_burst;
+  int64_t m_tokens;
+  uint32_t m_lastRefill = 0;
+  uint32_t m_remainder = 0; // Fraction of a token in 1/1000 bytes
+  bool m_started = false;
+
+  uint32_t getThreshold(uint32_t bytes) const {
+    return bytes < m_burst ? bytes : m_burst;
+  }
+
+  void refill() {
+    const uint32_t now = sys_now();
+    if (!m_started) {
+      m_lastRefill = now;
+      m_started = true;
+      return;
+    }
+    // Carry the fraction over, frequent refills would lose it otherwise
+    const uint64_t added =
+        static_cast<uint64_t>(now - m_lastRefill) * m_rate + m_remainder;
+    m_lastRefill = now;
+    m_remainder = static_cast<uint32_t>(added % 1000);
+    m_tokens += static_cast<int64_t>(added / 1000);
+    if (m_tokens >= static_cast<int64_t>(m_burst)) {
+      m_tokens = m_burst;
+      m_remainder = 0;
+    }
+  }
+};
+
+} // namespace rtps
+
+#endif // RTPS_TOKENBUCKET_H
@@ -50,6 +50,9 @@ const uint8_t NUM_WRITERS_PER_PARTICIPANT = 10;
 const uint8_t NUM_READERS_PER_PARTICIPANT = 10;
 const uint8_t NUM_WRITER_PROXIES_PER_READER = 6;
 const uint8_t NUM_READER_PROXIES_PER_WRITER = 6;
+// Slots of the participant index from remote writer GUID to local readers
+// (power of two, about twice the number of matched remote writers)
+const uint32_t REMOTE_WRITER_INDEX_SIZE = 128;
 
 const uint8_t MAX_NUM_UNMATCHED_REMOTE_WRITERS = 50;
 const uint8_t MAX_NUM_UNMATCHED_REMOTE_READERS = 50;
@@ -59,20 +62,58 @@ const uint8_t MAX_NUM_READER_CALLBACKS = 5;
 
 const uint8_t HISTORY_SIZE_STATELESS = 2;
 const uint8_t HISTORY_SIZE_STATEFUL = 10;
+// Writers of keyed topics keep the last SF_WRITER_KEEP_LAST_DEPTH samples of
+// each instance. The history tracks up to SF_WRITER_MAX_INSTANCES instances.
+const uint8_t SF_WRITER_MAX_INSTANCES = 8;
+const uint8_t SF_WRITER_KEEP_LAST_DEPTH = 1;
+// Out-of-order samples a stateful reader keeps until the gap before them is
+// filled. Shared by all writer proxies of the reader.
+const uint8_t SFR_REORDER_BUFFER_SIZE = 8;
 
 const uint8_t MAX_TYPENAME_LENGTH = 64;
 const uint8_t MAX_TOPICNAME_LENGTH = 64;
 
-const int HEARTBEAT_STACKSIZE = 1200;          // byte
 const int THREAD_POOL_WRITER_STACKSIZE = 1100; // byte
 const int THREAD_POOL_READER_STACKSIZE = 3000; // byte
-const uint16_t SPDP_WRITER_STACKSIZE = 1000;    // byte
+// The timer callbacks send heartbeats through the same path as the writer
+// threads and evict participants whose lease expired. The stack is at least
+// the sum of the former heartbeat (1200) and SPDP (1000) thread stacks it
+// replaces and no smaller than THREAD_POOL_WRITER_STACKSIZE.
+const int TIMER_THREAD_STACKSIZE = 2200;       // byte
+
+// All endpoint timers (heartbeats, SPDP resends, lease checks) share one thread
+const int TIMER_THREAD_PRIO = 24;
+const uint32_t TIMER_WHEEL_TICK_MS = 10;
+const uint32_t TIMER_WHEEL_NUM_SLOTS = 64;
 
 const uint16_t SF_WRITER_HB_PERIOD_MS = 4000;
+// While changes are unacknowledged, heartbeats are sent every
+// SF_WRITER_HB_RTT_MULTIPLIER round trip times of the slowest reader, bounded by
+// SF_WRITER_HB_MIN_PERIOD_MS and SF_WRITER_HB_PERIOD_MS / 4. Once everything is
+// acknowledged, the period doubles with every heartbeat up to
+// SF_WRITER_HB_MAX_PERIOD_MS.
+const uint16_t SF_WRITER_HB_MIN_PERIOD_MS = 20;
+const uint16_t SF_WRITER_HB_MAX_PERIOD_MS = 16000;
+const uint8_t SF_WRITER_HB_RTT_MULTIPLIER = 3;
+// Besides the periodic ones, a HEARTBEAT is piggybacked on the DATA of every
+// Nth sample or as soon as the slowest reader has not acknowledged more than
+// the given share of the history.
+const uint8_t SF_WRITER_HB_EVERY_N_SAMPLES = 1;
+const uint8_t SF_WRITER_HB_UNACKED_PERCENT = 50;
+// Changes written with markDisposedAfterWrite are kept this long for
+// retransmissions
+const uint32_t SF_WRITER_DISPOSE_RETENTION_MS = 4000;
+// Reliable readers leaving the HEARTBEATs for outstanding changes unanswered
+// this long are not waited for until they send an ACKNACK again, neither by
+// strictly reliable writers nor by the heartbeat period
+const uint32_t SF_WRITER_READER_RESPONSE_TIMEOUT_MS = 10000;
+// Reliable readers answer HEARTBEATs of a writer at most once in this period,
+// e.g. those piggybacked on a burst of DATA. Later ones are left to the
+// periodic HEARTBEAT, so it needs to be shorter than SF_WRITER_HB_MIN_PERIOD_MS.
+const uint16_t SF_READER_HB_SUPPRESSION_MS = 10;
 const uint16_t SPDP_RESEND_PERIOD_MS = 1000;
 const uint8_t SPDP_CYCLECOUNT_HEARTBEAT =
     2; // skip x SPDP rounds before checking liveliness
-const uint8_t SPDP_WRITER_PRIO = 24;
 const uint8_t SPDP_MAX_NUMBER_FOUND_PARTICIPANTS = 10;
 const uint8_t SPDP_MAX_NUM_LOCATORS = 1;
 const Duration_t SPDP_DEFAULT_REMOTE_LEASE_DURATION = {
@@ -86,18 +127,51 @@ const Duration_t SPDP_LEASE_DURATION = {5, 0};
 
 const int MAX_NUM_UDP_CONNECTIONS = 10;
 
+// Submessages to the same destination are combined into one RTPS message of at
+// most this size (0 disables batching). Needs to fit into the MTU. DATA with
+// larger payloads than MESSAGE_BATCH_MAX_PAYLOAD_SIZE is sent without copying.
+const uint16_t MESSAGE_BATCH_MAX_SIZE = 1400; // byte
+const uint16_t MESSAGE_BATCH_MAX_PAYLOAD_SIZE = 256; // byte
+const uint16_t MESSAGE_BATCH_MAX_DELAY_MS = 5;
+const uint8_t MESSAGE_BATCH_NUM_DESTINATIONS = 4; // per writer
+
+// Samples with larger payloads are sent as DATA_FRAG, one fragment of this size
+// per message. Needs to fit into the MTU together with the message headers.
+const uint16_t FRAGMENT_SIZE = 1024; // byte
+// Fragmented samples each reader reassembles at the same time. The sample
+// buffer is allocated from the lwIP heap when its first fragment arrives.
+const uint8_t FRAG_NUM_SAMPLES_PER_READER = 2;
+const uint16_t FRAG_MAX_SAMPLE_SIZE = 32768; // byte
+
 const int THREAD_POOL_NUM_WRITERS = 1;
 const int THREAD_POOL_NUM_READERS = 1;
 const int THREAD_POOL_WRITER_PRIO = 24;
 const int THREAD_POOL_READER_PRIO = 24;
 const int THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC = 60;
 const int THREAD_POOL_WORKLOAD_QUEUE_LENGTH_METATRAFFIC = 60;
+// Maximum number of elements a worker takes from each queue per iteration
+const int THREAD_POOL_READER_BATCH_SIZE = 8;
+const int THREAD_POOL_WRITER_BATCH_SIZE = 8;
+// Writers are served by priority, 0 being the highest. A waiting priority that
+// was passed over THREAD_POOL_PRIORITY_AGING_ROUNDS times is served next, so a
+// flood on one topic cannot starve the others. Each priority has a workload
+// queue of THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC elements.
+const uint8_t THREAD_POOL_NUM_PRIORITIES = 3;
+const uint8_t THREAD_POOL_BUILTIN_WRITER_PRIORITY = 1;
+const uint8_t THREAD_POOL_DEFAULT_WRITER_PRIORITY = 2;
+const uint8_t THREAD_POOL_PRIORITY_AGING_ROUNDS = 4;
+// A writer is queued at most once. Its progress() sends up to this many
+// changes before it queues itself again behind the other writers.
+const uint8_t WRITER_MAX_CHANGES_PER_PROGRESS = 8;
+// Token bucket limiting the bytes each writer sends, 0 disables it. Changes over
+// budget stay in the history until enough tokens are available.
+const uint32_t WRITER_RATE_LIMIT_BYTES_PER_SEC = 0;
+const uint32_t WRITER_RATE_LIMIT_BURST_BYTES = 8192;
 
 constexpr int OVERALL_HEAP_SIZE =
     THREAD_POOL_NUM_WRITERS * THREAD_POOL_WRITER_STACKSIZE +
     THREAD_POOL_NUM_READERS * THREAD_POOL_READER_STACKSIZE +
-    MAX_NUM_PARTICIPANTS * SPDP_WRITER_STACKSIZE +
-    NUM_STATEFUL_WRITERS * HEARTBEAT_STACKSIZE;
+    TIMER_THREAD_STACKSIZE;
 } // namespace Config
 } // namespace rtps
 
@@ -86,6 +86,9 @@ private:
 
   void handleRemoteEndpointDeletion(const TopicData &topic,
                                     const ReaderCacheChange &change);
+  //! For disposals identifying the endpoint by the key hash inline QoS
+  void handleRemoteEndpointDeletion(const ReaderCacheChange &change);
+  void removeRemoteEndpoint(const Guid_t &guid);
 
   void (*mfp_onNewPublisherCallback)(void *arg) = nullptr;
   void *m_onNewPublisherArgs = nullptr;
@@ -31,6 +31,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/discovery/BuiltInEndpoints.h"
 #include "rtps/discovery/ParticipantProxyData.h"
 #include "rtps/utils/Log.h"
+#include "rtps/utils/TimerWheel.h"
 #include "ucdr/microcdr.h"
 
 #if SPDP_VERBOSE && RTPS_GLOBAL_VERBOSE
@@ -54,14 +55,17 @@ class ReaderCacheChange;
 class SPDPAgent {
 public:
   void init(Participant &participant, BuiltInEndpoints &endpoints);
-  void start();
+  //! Announces the participant periodically and checks the leases of remote
+  //! participants, driven by the given timers
+  void start(TimerWheel &timers);
   void stop();
   SemaphoreHandle_t m_mutex;
 
 private:
   Participant *mp_participant = nullptr;
   BuiltInEndpoints m_buildInEndpoints;
-  bool m_running = false;
+  TimerWheel *mp_timers = nullptr;
+  Timer m_resendTimer{resendTimerJumppad, this};
   std::array<uint8_t, 400> m_outputBuffer{}; // TODO check required size
   std::array<uint8_t, 400> m_inputBuffer{};
   ParticipantProxyData m_proxyDataBuffer{};
@@ -80,7 +84,8 @@ private:
   void addParticipantParameters();
   void endCurrentList();
 
-  static void runBroadcast(void *args);
+  static void resendTimerJumppad(void *thisPointer);
+  void resend();
 };
 } // namespace rtps
 
@@ -86,6 +86,7 @@ struct TopicDataCompressed {
   std::size_t topicHash;
   std::size_t typeHash;
   bool is_reliable;
+  DurabilityKind_t durabilityKind;
   LocatorIPv4 unicastLocator;
   LocatorIPv4 multicastLocator;
 
@@ -98,6 +99,7 @@ struct TopicDataCompressed {
     is_reliable = (topic_data.reliabilityKind == ReliabilityKind_t::RELIABLE)
                       ? true
                       : false;
+    durabilityKind = topic_data.durabilityKind;
     unicastLocator = topic_data.unicastLocator;
     multicastLocator = topic_data.multicastLocator;
   }
@@ -47,10 +47,12 @@ public:
   Participant *createParticipant();
   Writer *createWriter(Participant &part, const char *topicName,
                        const char *typeName, bool reliable,
-                       bool enforceUnicast = false);
+                       bool enforceUnicast = false,
+                       TopicKind_t topicKind = TopicKind_t::NO_KEY);
   Reader *createReader(Participant &part, const char *topicName,
                        const char *typeName, bool reliable,
-                       ip4_addr_t mcastaddress = {0});
+                       ip4_addr_t mcastaddress = {0},
+                       TopicKind_t topicKind = TopicKind_t::NO_KEY);
 
   Writer *writerExists(Participant &part, const char *topicName,
                        const char *typeName, bool reliable);
@@ -30,11 +30,13 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/discovery/SEDPAgent.h"
 #include "rtps/discovery/SPDPAgent.h"
 #include "rtps/messages/MessageReceiver.h"
+#include "rtps/storages/StaticHashIndex.h"
 
 namespace rtps {
 
 class Writer;
 class Reader;
+struct WriterProxy;
 
 class Participant {
 public:
@@ -83,9 +85,21 @@ public:
   //! (Probably) Thread safe if readers cannot be removed
   Reader *getReader(EntityId_t id);
   Reader *getReaderByWriterId(const Guid_t &guid);
+  //! Collects all local readers matched with the remote writer
+  uint32_t getReadersByWriterId(const Guid_t &guid, Reader **readers,
+                                uint32_t maxReaders);
   Reader *getMatchingReader(const TopicData &topicData);
   Reader *getMatchingReader(const TopicDataCompressed &topicData);
 
+  //! Adds the proxy to the reader and makes the reader reachable by the
+  //! writer GUID. All writer proxies of local readers need to be added here.
+  bool addWriterProxyToReader(Reader &reader, const WriterProxy &proxy);
+  //! Adds the proxy to all local readers matching the remote writer
+  uint32_t addWriterProxyToMatchingReaders(const TopicData &writerData,
+                                           const WriterProxy &proxy);
+  uint32_t addWriterProxyToMatchingReaders(const TopicDataCompressed &writerData,
+                                           const WriterProxy &proxy);
+
   bool addNewRemoteParticipant(const ParticipantProxyData &remotePart);
   bool removeRemoteParticipant(const GuidPrefix_t &prefix);
   void removeAllProxiesOfParticipant(const GuidPrefix_t &prefix);
@@ -101,6 +115,8 @@ public:
 
   void addBuiltInEndpoints(BuiltInEndpoints &endpoints);
   void newMessage(const uint8_t *data, DataSize_t size);
+  //! The message may span several pbufs
+  void newMessage(const pbuf *chain);
 
   SPDPAgent &getSPDPAgent();
   void printInfo();
@@ -115,6 +131,21 @@ private:
   std::array<Reader *, Config::NUM_READERS_PER_PARTICIPANT> m_readers = {
       nullptr};
 
+  // Lookup tables for dispatching incoming submessages, protected by m_mutex
+  StaticHashIndex<EntityId_t, Writer *,
+                  hashIndexCapacity(Config::NUM_WRITERS_PER_PARTICIPANT)>
+      m_writerIndex;
+  StaticHashIndex<EntityId_t, Reader *,
+                  hashIndexCapacity(Config::NUM_READERS_PER_PARTICIPANT)>
+      m_readerIndex;
+  StaticHashIndex<Guid_t, Reader *, Config::REMOTE_WRITER_INDEX_SIZE>
+      m_remoteWriterIndex;
+  // Set once a proxy did not fit into the index. Lookups by writer GUID then
+  // fall back to searching the proxies of all readers.
+  bool m_remoteWriterIndexOverflow = false;
+
+  void shareWriterProxiesWithNewReader(Reader &newReader);
+
   SemaphoreHandle_t m_mutex;
   MemoryPool<ParticipantProxyData, Config::SPDP_MAX_NUMBER_FOUND_PARTICIPANTS>
       m_remoteParticipants;
@@ -29,29 +29,47 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/config.h"
 #include "rtps/discovery/TopicData.h"
 #include "rtps/entities/WriterProxy.h"
+#include "rtps/storages/FragmentAssembler.h"
 #include "rtps/storages/MemoryPool.h"
 #include "rtps/storages/PBufWrapper.h"
 #include "semphr.h"
+
+#include <atomic>
 #include <cstring>
 
 namespace rtps {
 
+class ThreadPool;
 struct SubmessageHeartbeat;
 struct SubmessageGap;
+struct SubmessageDataFrag;
 
 class ReaderCacheChange {
 private:
-  const uint8_t *data;
+  // Null if the data spans several pbufs until getData() linearizes it
+  mutable const uint8_t *data;
+  const PBufView m_view;
+  mutable PBufWrapper m_linearized;
 
 public:
   const ChangeKind_t kind;
   const DataSize_t size;
   const Guid_t writerGuid;
   const SequenceNumber_t sn;
+  //! Key hash and status info sent along with the sample, if any
+  const InlineQos_t inlineQos;
+
+  ReaderCacheChange(ChangeKind_t kind, Guid_t &writerGuid, SequenceNumber_t sn,
+                    const uint8_t *data, DataSize_t size,
+                    const InlineQos_t &inlineQos = {})
+      : data(data), kind(kind), size(size), writerGuid(writerGuid), sn(sn),
+        inlineQos(inlineQos){};
 
+  //! References the data in the received pbufs, nothing is copied
   ReaderCacheChange(ChangeKind_t kind, Guid_t &writerGuid, SequenceNumber_t sn,
-                    const uint8_t *data, DataSize_t size)
-      : data(data), kind(kind), size(size), writerGuid(writerGuid), sn(sn){};
+                    const PBufView &view, const InlineQos_t &inlineQos = {})
+      : data(view.getContiguous()), m_view(view), kind(kind), size(view.size),
+        writerGuid(writerGuid), sn(sn), inlineQos(inlineQos){};
 
   ~ReaderCacheChange() =
       default; // No need to free data. It's not owned by this object
@@ -65,13 +83,27 @@ public:
   bool copyInto(uint8_t *buffer, DataSize_t destSize) const {
     if (destSize < size) {
       return false;
-    } else {
+    } else if (data != nullptr) {
       memcpy(buffer, data, size);
       return true;
+    } else {
+      return m_view.copyInto(buffer, destSize);
     }
   }
 
-  const uint8_t *getData() const { return data; }
+  //! Prefer copyInto(), data spanning several pbufs is copied here first
+  const uint8_t *getData() const {
+    if (data == nullptr && m_view.chain != nullptr) {
+      m_linearized = PBufWrapper{pbuf_alloc(PBUF_RAW, size, PBUF_RAM)};
+      if (m_linearized.isValid() &&
+          m_view.copyInto(static_cast<uint8_t *>(
+                              m_linearized.firstElement->payload),
+                          size)) {
+        data = static_cast<const uint8_t *>(m_linearized.firstElement->payload);
+      }
+    }
+    return data;
+  }
 
   const DataSize_t getDataSize() const { return size; }
 };
@@ -95,6 +127,9 @@ public:
                               const GuidPrefix_t &remotePrefix) = 0;
   virtual bool onNewGapMessage(const SubmessageGap &msg,
                                const GuidPrefix_t &remotePrefix) = 0;
+  //! Reassembles the sample, passes it to newChange() once it is complete
+  void onNewDataFrag(const SubmessageDataFrag &msg,
+                     const GuidPrefix_t &remotePrefix, const PBufView &data);
   virtual bool addNewMatchedWriter(const WriterProxy &newProxy) = 0;
   virtual bool removeProxy(const Guid_t &guid);
   virtual void removeAllProxiesOfParticipant(const GuidPrefix_t &guidPrefix);
@@ -114,7 +149,19 @@ public:
 
   virtual bool sendPreemptiveAckNack(const WriterProxy &writer);
 
+  //! Sends the responses queued while processing incoming messages. Intended
+  //! to be called by worker threads
+  virtual void sendPendingResponses() {}
+  //! Called by the thread pool before sendPendingResponses()
+  void onWorkloadDequeued() { m_responsesScheduled = false; }
+
 protected:
+  ThreadPool *mp_threadPool = nullptr;
+  std::atomic<bool> m_responsesScheduled{false};
+  //! Queues the reader at the thread pool unless it is queued already.
+  //! Returns false if there is no thread pool or its queue is full.
+  bool scheduleResponses();
+
   void executeCallbacks(const ReaderCacheChange &cacheChange);
   bool initMutex();
 
@@ -136,7 +183,9 @@ protected:
 
   std::array<callbackElement_t, Config::MAX_NUM_READER_CALLBACKS> m_callbacks;
 
-  // Guards manipulation of the proxies array
+  FragmentAssembler<Config::FRAG_NUM_SAMPLES_PER_READER> m_fragments;
+
+  // Guards manipulation of the proxies array and the fragments
   SemaphoreHandle_t m_proxies_mutex = nullptr;
 
   // Guards manipulation of callback array
@@ -40,6 +40,24 @@ struct ReaderProxy {
   bool unknown_eid = false;
   bool finalFlag = false;
   SequenceNumber_t lastAckNackSequenceNumber = {0, 1};
+  DurabilityKind_t durabilityKind = DurabilityKind_t::VOLATILE;
+
+  // Late joining TRANSIENT_LOCAL readers are sent the retained history on
+  // their own, starting at catchUpSequenceNumber
+  bool catchingUp = false;
+  SequenceNumber_t catchUpSequenceNumber = {0, 1};
+
+  // Round trip time estimated from HEARTBEAT -> ACKNACK pairs, 0 if unknown.
+  // ACKNACKs don't tell which HEARTBEAT they answer. As in Karn's algorithm,
+  // no sample is taken if several HEARTBEATs were unanswered.
+  uint32_t smoothedRttMs = 0;
+  bool heartbeatPending = false;
+  bool severalHeartbeatsPending = false;
+
+  // Readers not answering HEARTBEATs since firstUnansweredHeartbeatMs are
+  // evicted from the acknowledgement tracking until their next ACKNACK
+  uint32_t firstUnansweredHeartbeatMs = 0;
+  bool isResponsive = true;
 
   ReaderProxy()
       : remoteReaderGuid({GUIDPREFIX_UNKNOWN, ENTITYID_UNKNOWN}),
@@ -51,6 +69,37 @@ struct ReaderProxy {
               const LocatorIPv4 &mcastloc, bool reliable)
       : remoteReaderGuid(guid), remoteLocator(loc), is_reliable(reliable),
         remoteMulticastLocator(mcastloc), ackNackCount{0}, finalFlag(false){};
+
+  void onHeartbeatSent(uint32_t nowMs) {
+    if (heartbeatPending) {
+      severalHeartbeatsPending = true;
+      return;
+    }
+    firstUnansweredHeartbeatMs = nowMs;
+    heartbeatPending = true;
+  }
+
+  //! Takes the ACKNACK answering a single heartbeat as a round trip sample
+  void onAckNackReceived(uint32_t nowMs) {
+    const bool ambiguous = severalHeartbeatsPending;
+    severalHeartbeatsPending = false;
+    if (!heartbeatPending) {
+      return;
+    }
+    heartbeatPending = false;
+    if (ambiguous) {
+      return;
+    }
+    const uint32_t sample = nowMs - firstUnansweredHeartbeatMs;
+    if (smoothedRttMs == 0) {
+      smoothedRttMs = sample == 0 ? 1 : sample;
+    } else {
+      smoothedRttMs = (7 * smoothedRttMs + sample) / 8;
+      if (smoothedRttMs == 0) {
+        smoothedRttMs = 1;
+      }
+    }
+  }
 };
 
 } // namespace rtps
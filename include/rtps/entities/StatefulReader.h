@@ -38,7 +38,10 @@ struct SubmessageHeartbeat;
 template <class NetworkDriver> class StatefulReaderT final : public Reader {
 public:
   ~StatefulReaderT() override;
-  bool init(const TopicData &attributes, NetworkDriver &driver);
+  //! Responses to HEARTBEAT and GAP are sent by the thread pool if given,
+  //! otherwise directly from the receiving thread
+  bool init(const TopicData &attributes, NetworkDriver &driver,
+            ThreadPool *threadPool = nullptr);
   void newChange(const ReaderCacheChange &cacheChange) override;
   bool addNewMatchedWriter(const WriterProxy &newProxy) override;
   bool onNewHeartbeat(const SubmessageHeartbeat &msg,
@@ -47,10 +50,28 @@ public:
                        const GuidPrefix_t &remotePrefix) override;
 
   bool sendPreemptiveAckNack(const WriterProxy &writer) override;
+  void sendPendingResponses() override;
 
 private:
   Ip4Port_t m_srcPort; // TODO intended for reuse but buffer not used as such
   NetworkDriver *m_transport;
+
+  struct PendingChange {
+    Guid_t writerGuid;
+    SequenceNumber_t sn;
+    ChangeKind_t kind = ChangeKind_t::INVALID; // INVALID marks a free slot
+    PBufWrapper data;                           // Contiguous copy of payload
+    DataSize_t size = 0;
+    InlineQos_t inlineQos;
+  };
+  std::array<PendingChange, Config::SFR_REORDER_BUFFER_SIZE> m_pendingChanges;
+
+  bool bufferChange(const ReaderCacheChange &cacheChange);
+  bool isChangeBuffered(const Guid_t &writerGuid, const SequenceNumber_t &sn);
+  void deliverBufferedChanges(WriterProxy &proxy);
+
+  void queueAckNack(WriterProxy &writer, const SequenceNumber_t &lastSN);
+  void sendAckNack(WriterProxy &writer);
 };
 
 using StatefulReader = StatefulReaderT<UdpDriver>;
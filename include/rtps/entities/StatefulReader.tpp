@@ -49,14 +49,20 @@ StatefulReaderT<NetworkDriver>::~StatefulReaderT() {}
 
 template <class NetworkDriver>
 bool StatefulReaderT<NetworkDriver>::init(const TopicData &attributes,
-                                          NetworkDriver &driver) {
+                                          NetworkDriver &driver,
+                                          ThreadPool *threadPool) {
   if (!initMutex()) {
     return false;
   }
 
   m_proxies.clear();
+  for (auto &pending : m_pendingChanges) {
+    pending.data.destroy();
+    pending.kind = ChangeKind_t::INVALID;
+  }
   m_attributes = attributes;
   m_transport = &driver;
+  mp_threadPool = threadPool;
   m_srcPort = attributes.unicastLocator.port;
   m_is_initialized_ = true;
   return true;
@@ -82,6 +88,14 @@ void StatefulReaderT<NetworkDriver>::newChange(
         ++proxy.expectedSN;
         SFR_LOG("Done processing SN %u.%u\r\n", (int)cacheChange.sn.high,
                (int)cacheChange.sn.low);
+        deliverBufferedChanges(proxy);
+        return;
+      } else if (proxy.expectedSN < cacheChange.sn &&
+                 bufferChange(cacheChange)) {
+        Diagnostics::StatefulReader::sfr_buffered_out_of_order++;
+        SFR_LOG("Buffering SN %u.%u until %u.%u arrives",
+                (int)cacheChange.sn.high, (int)cacheChange.sn.low,
+                (int)proxy.expectedSN.high, (int)proxy.expectedSN.low);
         return;
       } else {
         Diagnostics::StatefulReader::sfr_unexpected_sn++;
@@ -98,6 +112,91 @@ void StatefulReaderT<NetworkDriver>::newChange(
   }
 }
 
+template <class NetworkDriver>
+bool StatefulReaderT<NetworkDriver>::bufferChange(
+    const ReaderCacheChange &cacheChange) {
+  if (isChangeBuffered(cacheChange.writerGuid, cacheChange.sn)) {
+    return true;
+  }
+
+  PendingChange *slot = nullptr;
+  for (auto &pending : m_pendingChanges) {
+    // Also reclaim slots of writers that were removed in the meantime
+    if (pending.kind != ChangeKind_t::INVALID &&
+        getProxy(pending.writerGuid) == nullptr) {
+      pending.data.destroy();
+      pending.kind = ChangeKind_t::INVALID;
+    }
+    if (slot == nullptr && pending.kind == ChangeKind_t::INVALID) {
+      slot = &pending;
+    }
+  }
+  if (slot == nullptr) {
+    Diagnostics::StatefulReader::sfr_reorder_buffer_full++;
+    return false;
+  }
+
+  // Callbacks expect contiguous data
+  slot->data = PBufWrapper{pbuf_alloc(PBUF_RAW, cacheChange.size, PBUF_RAM)};
+  if (!slot->data.isValid() ||
+      !cacheChange.copyInto(static_cast<uint8_t *>(slot->data.firstElement->payload),
+                            cacheChange.size)) {
+    slot->data.destroy();
+    return false;
+  }
+  slot->writerGuid = cacheChange.writerGuid;
+  slot->sn = cacheChange.sn;
+  slot->kind = cacheChange.kind;
+  slot->size = cacheChange.size;
+  slot->inlineQos = cacheChange.inlineQos;
+  return true;
+}
+
+template <class NetworkDriver>
+bool StatefulReaderT<NetworkDriver>::isChangeBuffered(
+    const Guid_t &writerGuid, const SequenceNumber_t &sn) {
+  for (const auto &pending : m_pendingChanges) {
+    if (pending.kind != ChangeKind_t::INVALID && pending.sn == sn &&
+        pending.writerGuid == writerGuid) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::deliverBufferedChanges(
+    WriterProxy &proxy) {
+  bool delivered = true;
+  while (delivered) {
+    delivered = false;
+    for (auto &pending : m_pendingChanges) {
+      if (pending.kind == ChangeKind_t::INVALID ||
+          !(pending.writerGuid == proxy.remoteWriterGuid)) {
+        continue;
+      }
+      if (pending.sn == proxy.expectedSN) {
+        SFR_LOG("Delivering buffered SN %u.%u", (int)pending.sn.high,
+                (int)pending.sn.low);
+        ReaderCacheChange change{
+            pending.kind, pending.writerGuid, pending.sn,
+            static_cast<const uint8_t *>(pending.data.firstElement->payload),
+            pending.size, pending.inlineQos};
+        executeCallbacks(change);
+        ++proxy.expectedSN;
+        delivered = true;
+      } else if (!(proxy.expectedSN < pending.sn)) {
+        // Skipped by a GAP or HEARTBEAT in the meantime
+      } else {
+        continue;
+      }
+      pending.data.destroy();
+      pending.kind = ChangeKind_t::INVALID;
+    }
+  }
+  m_fragments.removeOlderThan(proxy.remoteWriterGuid, proxy.expectedSN);
+}
+
 template <class NetworkDriver>
 bool StatefulReaderT<NetworkDriver>::addNewMatchedWriter(
     const WriterProxy &newProxy) {
@@ -136,19 +235,9 @@ bool StatefulReaderT<NetworkDriver>::onNewGapMessage(
 
   // Case 1: We are still waiting for messages before gapStart
   if (writer->expectedSN < msg.gapStart) {
-    PacketInfo info;
-    info.srcPort = m_srcPort;
-    info.destAddr = writer->remoteLocator.getIp4Address();
-    info.destPort = writer->remoteLocator.port;
-    rtps::MessageFactory::addHeader(info.buffer,
-                                    m_attributes.endpointGuid.prefix);
     SequenceNumber_t last_valid = msg.gapStart;
     --last_valid;
-    auto missing_sns = writer->getMissing(writer->expectedSN, last_valid);
-    rtps::MessageFactory::addAckNack(info.buffer, msg.writerId, msg.readerId,
-                                     missing_sns, writer->getNextAckNackCount(),
-                                     false);
-    m_transport->sendPacket(info);
+    queueAckNack(*writer, last_valid);
     return true;
   }
 
@@ -168,6 +257,7 @@ bool StatefulReaderT<NetworkDriver>::onNewGapMessage(
       }
     }
 
+    deliverBufferedChanges(*writer);
     return true;
 
   }else{
@@ -182,22 +272,9 @@ bool StatefulReaderT<NetworkDriver>::onNewGapMessage(
 
 		if(msg.gapList.isSet(bit)){
 			writer->expectedSN++;
+			deliverBufferedChanges(*writer);
 		}else{
-		  PacketInfo info;
-		  info.srcPort = m_srcPort;
-		  info.destAddr = writer->remoteLocator.getIp4Address();
-		  info.destPort = writer->remoteLocator.port;
-		  rtps::MessageFactory::addHeader(info.buffer,
-											m_attributes.endpointGuid.prefix);
-		  SequenceNumberSet set;
-		  set.base = writer->expectedSN;
-		  set.numBits = 1;
-		  set.bitMap[0] = set.bitMap[0] |= uint32_t{1} << 31;
-		  rtps::MessageFactory::addAckNack(info.buffer, msg.writerId, msg.readerId,
-											 set, writer->getNextAckNackCount(),
-											 false);
-		  m_transport->sendPacket(info);
-
+		  queueAckNack(*writer, writer->expectedSN);
 		  return true;
 		}
 	  }
@@ -214,8 +291,6 @@ bool StatefulReaderT<NetworkDriver>::onNewHeartbeat(
   if (!m_is_initialized_) {
     return false;
   }
-  PacketInfo info;
-  info.srcPort = m_srcPort;
 
   Guid_t writerProxyGuid;
   writerProxyGuid.prefix = sourceGuidPrefix;
@@ -236,23 +311,84 @@ bool StatefulReaderT<NetworkDriver>::onNewHeartbeat(
   if (writer->expectedSN < msg.firstSN) {
     SFR_LOG("expectedSN < firstSN, advancing expectedSN");
     writer->expectedSN = msg.firstSN;
+    deliverBufferedChanges(*writer);
   }
 
   writer->hbCount.value = msg.count.value;
-  info.destAddr = writer->remoteLocator.getIp4Address();
-  info.destPort = writer->remoteLocator.port;
+  if (writer->isHeartbeatSuppressed(sys_now())) {
+    SFR_LOG("Heartbeat too soon after the last acknack, not answering.");
+    return true;
+  }
+  queueAckNack(*writer, msg.lastSN);
+  return true;
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::queueAckNack(
+    WriterProxy &writer, const SequenceNumber_t &lastSN) {
+  // Requests queued meanwhile are answered by a single ACKNACK
+  if (!writer.ackNackPending || writer.ackNackLastSN < lastSN) {
+    writer.ackNackLastSN = lastSN;
+  }
+  writer.ackNackPending = true;
+  if (!scheduleResponses()) {
+    sendAckNack(writer);
+  }
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::sendPendingResponses() {
+  Lock lock{m_proxies_mutex};
+  if (!m_is_initialized_) {
+    return;
+  }
+  for (auto &writer : m_proxies) {
+    if (writer.ackNackPending) {
+      sendAckNack(writer);
+    }
+  }
+}
+
+template <class NetworkDriver>
+void StatefulReaderT<NetworkDriver>::sendAckNack(WriterProxy &writer) {
+  writer.ackNackPending = false;
+  writer.lastAckNackMs = sys_now();
+  const Guid_t &writerGuid = writer.remoteWriterGuid;
+
+  PacketInfo info;
+  info.srcPort = m_srcPort;
+  info.destAddr = writer.remoteLocator.getIp4Address();
+  info.destPort = writer.remoteLocator.port;
   rtps::MessageFactory::addHeader(info.buffer,
                                   m_attributes.endpointGuid.prefix);
-  auto missing_sns = writer->getMissing(msg.firstSN, msg.lastSN);
+  // Changes kept in the reorder buffer don't need to be sent again. Partially
+  // received ones are requested fragment-wise with NACK_FRAG.
+  auto missing_sns = writer.getMissing(
+      writer.expectedSN, writer.ackNackLastSN,
+      [&](const SequenceNumber_t &sn) {
+        return isChangeBuffered(writerGuid, sn) ||
+               m_fragments.isAssembling(writerGuid, sn);
+      });
   bool final_flag = (missing_sns.numBits == 0);
-  rtps::MessageFactory::addAckNack(info.buffer, msg.writerId, msg.readerId,
-                                   missing_sns, writer->getNextAckNackCount(),
-                                   final_flag);
+  // Requests might have been addressed to ENTITYID_UNKNOWN
+  rtps::MessageFactory::addAckNack(
+      info.buffer, writerGuid.entityId, m_attributes.endpointGuid.entityId,
+      missing_sns, writer.getNextAckNackCount(), final_flag);
+  m_fragments.forEachIncomplete(
+      writerGuid, writer.ackNackLastSN,
+      [&](const SequenceNumber_t &sn, const FragmentNumberSet &missing) {
+        SFR_LOG("Sending nackfrag for SN %u.%u base %u bits %u",
+                (int)sn.high, (int)sn.low, (int)missing.base.value,
+                (int)missing.numBits);
+        rtps::MessageFactory::addNackFrag(
+            info.buffer, writerGuid.entityId,
+            m_attributes.endpointGuid.entityId, sn, missing,
+            writer.getNextAckNackCount());
+      });
 
   SFR_LOG("Sending acknack base %u bits %u .\n", (int)missing_sns.base.low,
           (int)missing_sns.numBits);
   m_transport->sendPacket(info);
-  return true;
 }
 
 template <class NetworkDriver>
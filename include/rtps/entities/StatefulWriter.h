@@ -25,6 +25,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #ifndef RTPS_STATEFULWRITER_H
 #define RTPS_STATEFULWRITER_H
 
+#include "rtps/communication/MessageBatcher.h"
 #include "rtps/entities/ReaderProxy.h"
 #include "rtps/entities/Writer.h"
 #include "rtps/storages/HistoryCacheWithDeletion.h"
@@ -41,21 +42,34 @@ public:
   //! Executes required steps like sending packets. Intended to be called by
   //! worker threads
   void progress() override;
+  void flushBatches() override;
+  //! Readers matched with a TRANSIENT_LOCAL writer are sent the retained
+  //! history if they are TRANSIENT_LOCAL themselves
+  bool addNewMatchedReader(const ReaderProxy &newProxy) override;
+  bool removeProxy(const Guid_t &guid) override;
+  void removeAllProxiesOfParticipant(const GuidPrefix_t &guidPrefix) override;
   const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                DataSize_t size, bool inLineQoS = false,
                                bool markDisposedAfterWrite = false) override;
+  const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
+                               DataSize_t size, const KeyHash_t &key) override;
 
   bool removeFromHistory(const SequenceNumber_t &s);
   void setAllChangesToUnsent() override;
   void onNewAckNack(const SubmessageAckNack &msg,
                     const GuidPrefix_t &sourceGuidPrefix) override;
+  void onNewNackFrag(const SubmessageNackFrag &msg,
+                     const GuidPrefix_t &sourceGuidPrefix) override;
   void reset() override;
   void updateChangeKind(SequenceNumber_t &sequence_number);
 
 private:
   NetworkDriver *m_transport;
+  MessageBatcherT<NetworkDriver> m_batcher;
 
-  HistoryCacheWithDeletion<Config::HISTORY_SIZE_STATEFUL> m_history;
+  HistoryCacheWithDeletion<Config::HISTORY_SIZE_STATEFUL,
+                           Config::SF_WRITER_MAX_INSTANCES>
+      m_history;
 
   /*
    * Cache changes marked as disposeAfterWrite are retained for a short amount
@@ -65,22 +79,62 @@ private:
    * replaced with something more elegant in the future.
    */
   ThreadSafeCircularBuffer<SequenceNumber_t, 10> m_disposeWithDelay;
-  void dropDisposeAfterWriteChanges();
+  Timer m_disposeTimer{disposeTimerJumppad, this};
+  uint32_t dropDisposeAfterWriteChanges();
+  static void disposeTimerJumppad(void *thisPointer);
 
-  sys_thread_t m_heartbeatThread;
+  Timer m_heartbeatTimer{heartbeatTimerJumppad, this};
+  uint32_t m_lastHeartbeatMs = 0;
+  uint32_t m_hbIdlePeriodMs = Config::SF_WRITER_HB_PERIOD_MS;
 
   Count_t m_hbCount{1};
-
-  bool m_running = true;
-  bool m_thread_running = false;
-
+  uint8_t m_samplesSinceHeartbeat = 0;
+
+  // Lowest ACKNACK base of the reliable readers, all changes before it are
+  // acknowledged by every one of them. m_numReadersAtMinAcked of the readers
+  // are at the watermark, none if there is no reliable reader. Both are
+  // updated as ACKNACKs come in and only recomputed once the last reader at
+  // the watermark moves on or a proxy is removed.
+  SequenceNumber_t m_minAckedSequenceNumber = {0, 1};
+  uint32_t m_numReadersAtMinAcked = 0;
+  uint32_t m_numReadersCatchingUp = 0;
+
+  // Signaled when strictly reliable writers may find room in the history
+  sys_sem_t m_historySpaceSem{};
+
+  ReaderProxy *getProxy(const GuidPrefix_t &prefix, const EntityId_t &readerId);
+  SequenceNumber_t getMinAckedSequenceNumber() const;
+  SequenceNumber_t getHighestSentSequenceNumber(const ReaderProxy &proxy) const;
+  void onAcknowledged(ReaderProxy &proxy, const SequenceNumber_t &base);
+  void addToMinAcked(const ReaderProxy &proxy);
+  void recomputeProxyState();
+  const CacheChange *addChange(ChangeKind_t kind, const uint8_t *data,
+                               DataSize_t size, bool inLineQoS,
+                               bool markDisposedAfterWrite,
+                               const KeyHash_t *key);
+  const CacheChange *tryAddChange(const uint8_t *data, DataSize_t size,
+                                  bool inLineQoS, bool markDisposedAfterWrite,
+                                  const KeyHash_t *key, bool &wouldBlock);
+  void releaseAcknowledgedChanges();
+  void evictUnresponsiveReaders();
+  void wakeBlockedWriters();
+  bool sendNextChange();
+  bool sendNextCatchUpChange();
   bool sendData(const ReaderProxy &reader, const CacheChange *next);
-  bool sendDataWRMulticast(const ReaderProxy &reader, const CacheChange *next);
-  static void hbFunctionJumppad(void *thisPointer);
-  void sendHeartBeatLoop();
+  bool isPiggybackHeartbeatDue();
+  bool reachesCatchingUpReader(const LocatorIPv4 &locator);
+  uint32_t sendDataToAllProxies(const CacheChange *next,
+                                const DataDestinations &destinations,
+                                bool &withHeartbeat);
+  static void heartbeatTimerJumppad(void *thisPointer);
+  void onHeartbeatTimer();
+  uint32_t getHeartbeatPeriod(bool &changesOutstanding);
+  void rescheduleHeartbeat();
   void sendHeartBeat();
   void sendGap(const ReaderProxy &reader, const SequenceNumber_t &firstMissing,
                const SequenceNumber_t &nextValid);
+  void handleAckNack(const SubmessageAckNack &msg,
+                     const GuidPrefix_t &sourceGuidPrefix);
 };
 
 using StatefulWriter = StatefulWriterT<UdpDriver>;
@@ -26,7 +26,9 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/entities/StatefulWriter.h"
 #include "rtps/messages/MessageFactory.h"
 #include "rtps/messages/MessageTypes.h"
+#include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Log.h"
+#include <algorithm>
 #include <cstring>
 #include <stdio.h>
 
@@ -46,12 +48,13 @@ using rtps::StatefulWriterT;
 
 template <class NetworkDriver>
 StatefulWriterT<NetworkDriver>::~StatefulWriterT() {
-  m_running = false;
-  while (m_thread_running) {
-    sys_msleep(500); // Required for tests/ Join currently not available /
-    //  increased because Segfault in Tests if(sys_mutex_valid(&m_mutex)){
-    //    sys_mutex_free(&m_mutex);
-    //  }
+  cancelDeferredProgress();
+  if (getTimerWheel() != nullptr) {
+    getTimerWheel()->cancel(m_heartbeatTimer);
+    getTimerWheel()->cancel(m_disposeTimer);
+  }
+  if (sys_sem_valid(&m_historySpaceSem)) {
+    sys_sem_free(&m_historySpaceSem);
   }
 }
 
@@ -70,6 +73,11 @@ bool StatefulWriterT<NetworkDriver>::init(TopicData attributes,
       return false;
     }
   }
+  if (!sys_sem_valid(&m_historySpaceSem) &&
+      sys_sem_new(&m_historySpaceSem, 0) != ERR_OK) {
+    SFW_LOG("Failed to create semaphore.\n");
+    return false;
+  }
 
   m_attributes = attributes;
 
@@ -80,36 +88,28 @@ bool StatefulWriterT<NetworkDriver>::init(TopicData attributes,
 
   m_nextSequenceNumberToSend = {0, 1};
   m_proxies.clear();
+  recomputeProxyState();
 
   m_transport = &driver;
+  if (!m_batcher.init(driver, m_attributes.endpointGuid.prefix, m_srcPort,
+                      getTimerWheel())) {
+    SFW_LOG("Failed to initialize message batching.\n");
+    return false;
+  }
   m_history.clear();
+  m_history.setInstanceDepth(Config::SF_WRITER_KEEP_LAST_DEPTH);
   m_hbCount = {1};
+  m_samplesSinceHeartbeat = 0;
+  m_hbIdlePeriodMs = Config::SF_WRITER_HB_PERIOD_MS;
 
   m_disposeWithDelay.init();
 
-  // Thread already exists, do not create new one (reusing slot case)
   m_is_initialized_ = true;
 
-  if (!m_thread_running) {
-
-    m_running = true;
-    m_thread_running = false;
-
-    if (m_attributes.endpointGuid.entityId ==
-        ENTITYID_SEDP_BUILTIN_PUBLICATIONS_WRITER) {
-      m_heartbeatThread = sys_thread_new("HBThreadPub", hbFunctionJumppad, this,
-                                         Config::HEARTBEAT_STACKSIZE,
-                                         Config::THREAD_POOL_WRITER_PRIO);
-    } else if (m_attributes.endpointGuid.entityId ==
-               ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_WRITER) {
-      m_heartbeatThread = sys_thread_new("HBThreadSub", hbFunctionJumppad, this,
-                                         Config::HEARTBEAT_STACKSIZE,
-                                         Config::THREAD_POOL_WRITER_PRIO);
-    } else {
-      m_heartbeatThread = sys_thread_new("HBThread", hbFunctionJumppad, this,
-                                         Config::HEARTBEAT_STACKSIZE,
-                                         Config::THREAD_POOL_WRITER_PRIO);
-    }
+  // Also rearms the timer when a slot is reused
+  m_lastHeartbeatMs = sys_now();
+  if (getTimerWheel() != nullptr) {
+    getTimerWheel()->schedule(m_heartbeatTimer, m_hbIdlePeriodMs);
   }
 
   return true;
@@ -117,6 +117,12 @@ bool StatefulWriterT<NetworkDriver>::init(TopicData attributes,
 
 template <class NetworkDriver> void StatefulWriterT<NetworkDriver>::reset() {
   m_is_initialized_ = false;
+  cancelDeferredProgress();
+  if (getTimerWheel() != nullptr) {
+    getTimerWheel()->cancel(m_heartbeatTimer);
+    getTimerWheel()->cancel(m_disposeTimer);
+  }
+  m_batcher.reset();
   // TODO
 }
 
@@ -124,33 +130,79 @@ template <class NetworkDriver>
 const rtps::CacheChange *StatefulWriterT<NetworkDriver>::newChange(
     ChangeKind_t kind, const uint8_t *data, DataSize_t size, bool inLineQoS,
     bool markDisposedAfterWrite) {
+  return addChange(kind, data, size, inLineQoS, markDisposedAfterWrite,
+                   nullptr);
+}
+
+template <class NetworkDriver>
+const rtps::CacheChange *
+StatefulWriterT<NetworkDriver>::newChange(ChangeKind_t kind,
+                                          const uint8_t *data, DataSize_t size,
+                                          const KeyHash_t &key) {
+  return addChange(kind, data, size, false, false,
+                   m_topicKind == TopicKind_t::WITH_KEY ? &key : nullptr);
+}
+
+template <class NetworkDriver>
+const rtps::CacheChange *StatefulWriterT<NetworkDriver>::addChange(
+    ChangeKind_t kind, const uint8_t *data, DataSize_t size, bool inLineQoS,
+    bool markDisposedAfterWrite, const KeyHash_t *key) {
   INIT_GUARD()
   if (isIrrelevant(kind)) {
     return nullptr;
   }
 
+  const uint32_t start = sys_now();
+  bool wouldBlock = false;
+  const CacheChange *result = tryAddChange(
+      data, size, inLineQoS, markDisposedAfterWrite, key, wouldBlock);
+  while (wouldBlock) {
+    const uint32_t waited = sys_now() - start;
+    if (waited >= m_maxBlockingTimeMs) {
+      SFW_LOG("History full of unacknowledged changes %s.\r\n",
+              this->m_attributes.topicName);
+      Diagnostics::StatefulWriter::sfw_would_block++;
+      return nullptr;
+    }
+    sys_arch_sem_wait(&m_historySpaceSem, m_maxBlockingTimeMs - waited);
+    result = tryAddChange(data, size, inLineQoS, markDisposedAfterWrite, key,
+                          wouldBlock);
+  }
+  return result;
+}
+
+template <class NetworkDriver>
+const rtps::CacheChange *StatefulWriterT<NetworkDriver>::tryAddChange(
+    const uint8_t *data, DataSize_t size, bool inLineQoS,
+    bool markDisposedAfterWrite, const KeyHash_t *key, bool &wouldBlock) {
+  wouldBlock = false;
   Lock lock{m_mutex};
   if (!m_is_initialized_) {
     return nullptr;
   }
 
-  if (m_history.isFull()) {
-    // Right now we drop elements anyway because we cannot detect non-responding
-    // readers yet. return nullptr;
-    SequenceNumber_t newMin =
-        ++SequenceNumber_t(m_history.getCurrentSeqNumMin());
-    if (m_nextSequenceNumberToSend < newMin) {
-      m_nextSequenceNumberToSend =
-          newMin; // Make sure we have the correct sn to send
+  if (m_history.isFull() && m_strictReliable) {
+    releaseAcknowledgedChanges();
+    const SequenceNumber_t evicted = m_history.getChangeToEvict(key);
+    if (!(evicted == SEQUENCENUMBER_UNKNOWN) &&
+        !(evicted < getMinAckedSequenceNumber())) {
+      wouldBlock = true;
+      return nullptr;
     }
+  } else if (m_history.isFull()) {
+    // Without strict reliability, the oldest changes are overwritten even if
+    // they are not acknowledged yet
     SFW_LOG("History full! Dropping changes %s.\r\n", this->m_attributes.topicName);
   }
 
-  auto *result =
-      m_history.addChange(data, size, inLineQoS, markDisposedAfterWrite);
-  if (mp_threadPool != nullptr) {
-    mp_threadPool->addWorkload(this);
+  // Unsent changes may be dropped, sendNextChange() skips them
+  auto *result = m_history.addChange(data, size, inLineQoS,
+                                     markDisposedAfterWrite, key);
+  if (result == nullptr) {
+    SFW_LOG("Instance limit reached %s.\r\n", this->m_attributes.topicName);
+    return nullptr;
   }
+  scheduleProgress();
 
   SFW_LOG("Adding new data.\n");
 
@@ -160,23 +212,130 @@ const rtps::CacheChange *StatefulWriterT<NetworkDriver>::newChange(
 template <class NetworkDriver> void StatefulWriterT<NetworkDriver>::progress() {
   INIT_GUARD()
   Lock lock{m_mutex};
-  CacheChange *next = m_history.getChangeBySN(m_nextSequenceNumberToSend);
+  // Late joiners catch up first, sharing the budget with the new changes
+  uint8_t numSent = 0;
+  while (numSent < Config::WRITER_MAX_CHANGES_PER_PROGRESS &&
+         sendNextCatchUpChange()) {
+    ++numSent;
+  }
+  const SequenceNumber_t firstUnsent = m_nextSequenceNumberToSend;
+  while (numSent < Config::WRITER_MAX_CHANGES_PER_PROGRESS &&
+         sendNextChange()) {
+    ++numSent;
+  }
+  // Switch from the idle to the active heartbeat period once there is
+  // something to acknowledge
+  if (firstUnsent < m_nextSequenceNumberToSend &&
+      m_hbIdlePeriodMs > Config::SF_WRITER_HB_PERIOD_MS / 4) {
+    rescheduleHeartbeat();
+  }
+  // Let the other writers go first before sending the rest. At worst, the
+  // next round finds nothing left to send.
+  if (numSent == Config::WRITER_MAX_CHANGES_PER_PROGRESS) {
+    scheduleProgress();
+  }
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::addNewMatchedReader(
+    const ReaderProxy &newProxy) {
+  INIT_GUARD()
+  Lock lock{m_mutex};
+  if (!Writer::addNewMatchedReader(newProxy)) {
+    return false;
+  }
+  ReaderProxy *proxy = getProxy(newProxy.remoteReaderGuid.prefix,
+                                newProxy.remoteReaderGuid.entityId);
+  if (proxy == nullptr) {
+    return false;
+  }
+  addToMinAcked(*proxy);
+
+  // Changes from m_nextSequenceNumberToSend on reach the reader with
+  // everyone else
+  if (m_attributes.durabilityKind == DurabilityKind_t::VOLATILE ||
+      proxy->durabilityKind == DurabilityKind_t::VOLATILE ||
+      m_history.isEmpty() ||
+      !(m_history.getCurrentSeqNumMin() < m_nextSequenceNumberToSend)) {
+    return true;
+  }
+  proxy->catchingUp = true;
+  proxy->catchUpSequenceNumber = m_history.getCurrentSeqNumMin();
+  ++m_numReadersCatchingUp;
+  SFW_LOG("Late joiner catches up from SN %u.",
+          (int)proxy->catchUpSequenceNumber.low);
+  scheduleProgress();
+  return true;
+}
+
+//! Sends the next retained change to one of the catching up readers. Returns
+//! false if there is none or the rate limit is reached.
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::sendNextCatchUpChange() {
+  if (m_numReadersCatchingUp == 0) {
+    return false;
+  }
+  for (auto &proxy : m_proxies) {
+    if (!proxy.catchingUp) {
+      continue;
+    }
+    // Follows the sequence number order of the history from the change sent
+    // last, holes left by dropped instance samples cost nothing
+    const CacheChange *next =
+        m_history.getNextChange(proxy.catchUpSequenceNumber);
+    if (next == nullptr ||
+        !(next->sequenceNumber < m_nextSequenceNumberToSend)) {
+      proxy.catchingUp = false;
+      --m_numReadersCatchingUp;
+      continue;
+    }
+
+    const uint32_t cost = next->data.spaceUsed();
+    if (!consumeSendBudget(cost)) {
+      deferProgress(cost);
+      return false;
+    }
+    // Dropped changes are skipped right away instead of waiting for a NACK
+    if (proxy.catchUpSequenceNumber < next->sequenceNumber &&
+        !(proxy.catchUpSequenceNumber < m_history.getCurrentSeqNumMin())) {
+      sendGap(proxy, proxy.catchUpSequenceNumber, next->sequenceNumber);
+    }
+    sendData(proxy, next);
+    proxy.catchUpSequenceNumber = next->sequenceNumber;
+    ++proxy.catchUpSequenceNumber;
+    return true;
+  }
+  return false;
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::sendNextChange() {
+  // Changes dropped before they were sent are skipped. Reliable readers NACK
+  // them once a HEARTBEAT announces the changes after them and
+  // handleAckNack() answers with a GAP.
+  CacheChange *next = m_history.getNextChange(m_nextSequenceNumberToSend);
   if (next != nullptr) {
-    uint32_t i = 0;
-    for (const auto &proxy : m_proxies) {
-      if (!m_enforceUnicast) {
-        sendDataWRMulticast(proxy, next);
-      } else {
-        i++;
-        sendData(proxy, next);
-      }
+    m_nextSequenceNumberToSend = next->sequenceNumber;
+  }
+  if (next != nullptr) {
+    DataDestinations destinations;
+    collectDataDestinations(destinations);
+    const uint32_t cost = getSendCost(*next, destinations);
+    if (!consumeSendBudget(cost)) {
+      deferProgress(cost);
+      return false;
     }
 
+    const bool heartbeatDue = isPiggybackHeartbeatDue();
+    bool withHeartbeat = heartbeatDue;
+    sendDataToAllProxies(next, destinations, withHeartbeat);
+
     SFW_LOG("Sending data with SN %u.%u", (int)m_nextSequenceNumberToSend.low,
             (int)m_nextSequenceNumberToSend.high);
 
     if (next->disposeAfterWrite) {
-      SFW_LOG("Dispose after write msg sent to %u proxies\r\n", (int)i);
+      SFW_LOG("Dispose after write msg sent to %u locators\r\n",
+              (int)destinations.count);
     }
 
     /*
@@ -195,16 +354,80 @@ template <class NetworkDriver> void StatefulWriterT<NetworkDriver>::progress() {
       } else {
         SFW_LOG("Delayed dispose scheduled for sn %u %u\r\n",
                 (int)next->sequenceNumber.high, (int)next->sequenceNumber.low);
+        if (getTimerWheel() != nullptr && !m_disposeTimer.isArmed()) {
+          getTimerWheel()->schedule(m_disposeTimer,
+                                    Config::SF_WRITER_DISPOSE_RETENTION_MS);
+        }
       }
     }
 
     ++m_nextSequenceNumberToSend;
-    sendHeartBeat();
-
+    if (withHeartbeat) {
+      const uint32_t now = sys_now();
+      for (auto &proxy : m_proxies) {
+        if (!proxy.catchingUp) {
+          proxy.onHeartbeatSent(now);
+        }
+      }
+      m_hbCount.value++;
+      m_samplesSinceHeartbeat = 0;
+    } else if (heartbeatDue) {
+      // The batcher had no room for the piggybacked HEARTBEAT
+      sendHeartBeat();
+      m_samplesSinceHeartbeat = 0;
+    }
+    return true;
   } else {
     SFW_LOG("Couldn't get a CacheChange with SN (%i,%u)\n",
             m_nextSequenceNumberToSend.high, m_nextSequenceNumberToSend.low);
+    return false;
+  }
+}
+
+//! Catching up readers have not seen all changes before the one being sent
+//! yet. A HEARTBEAT announcing it would make them NACK the changes the
+//! catch-up still sends.
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::reachesCatchingUpReader(
+    const LocatorIPv4 &locator) {
+  if (m_numReadersCatchingUp == 0) {
+    return false;
   }
+  auto matches = [&](const LocatorIPv4 &other) {
+    return other.address == locator.address && other.port == locator.port;
+  };
+  for (const auto &proxy : m_proxies) {
+    if (proxy.catchingUp && (matches(proxy.remoteLocator) ||
+                             matches(proxy.remoteMulticastLocator))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::isPiggybackHeartbeatDue() {
+  ++m_samplesSinceHeartbeat;
+  if (m_samplesSinceHeartbeat >= Config::SF_WRITER_HB_EVERY_N_SAMPLES) {
+    return true;
+  }
+
+  // Share of the history the slowest reliable reader has not acknowledged,
+  // including the change about to be sent. The history keeps the count as
+  // changes come and go, moving the bounds only walks the changes sent or
+  // acknowledged since the last send.
+  SequenceNumber_t end = m_nextSequenceNumberToSend;
+  ++end;
+  m_history.setCountedRange(getMinAckedSequenceNumber(), end);
+  const uint32_t unacked = m_history.getNumCountedChanges();
+  return unacked * 100 > static_cast<uint32_t>(
+                             Config::SF_WRITER_HB_UNACKED_PERCENT) *
+                             Config::HISTORY_SIZE_STATEFUL;
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::flushBatches() {
+  m_batcher.flush();
 }
 
 template <class NetworkDriver>
@@ -214,29 +437,27 @@ void StatefulWriterT<NetworkDriver>::setAllChangesToUnsent() {
 
   m_nextSequenceNumberToSend = m_history.getCurrentSeqNumMin();
 
-  if (mp_threadPool != nullptr) {
-    mp_threadPool->addWorkload(this);
-  }
+  scheduleProgress();
 }
 
 template <class NetworkDriver>
 void StatefulWriterT<NetworkDriver>::onNewAckNack(
     const SubmessageAckNack &msg, const GuidPrefix_t &sourceGuidPrefix) {
   INIT_GUARD()
+  handleAckNack(msg, sourceGuidPrefix);
+  // Retransmissions and gaps for the reader leave as few messages
+  m_batcher.flush();
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::handleAckNack(
+    const SubmessageAckNack &msg, const GuidPrefix_t &sourceGuidPrefix) {
   Lock lock{m_mutex};
   if (!m_is_initialized_) {
     return;
   }
 
-  ReaderProxy *reader = nullptr;
-  for (auto &proxy : m_proxies) {
-    if (proxy.remoteReaderGuid.prefix == sourceGuidPrefix &&
-        proxy.remoteReaderGuid.entityId == msg.readerId) {
-      reader = &proxy;
-      break;
-    }
-  }
-
+  ReaderProxy *reader = getProxy(sourceGuidPrefix, msg.readerId);
   if (reader == nullptr) {
 #if SFW_VERBOSE && RTPS_GLOBAL_VERBOSE
     SFW_LOG("No proxy found with id: ");
@@ -246,9 +467,11 @@ void StatefulWriterT<NetworkDriver>::onNewAckNack(
     return;
   }
 
+  reader->onAckNackReceived(sys_now());
   reader->ackNackCount = msg.count;
   reader->finalFlag = msg.header.finalFlag();
-  reader->lastAckNackSequenceNumber = msg.readerSNState.base;
+  onAcknowledged(*reader, msg.readerSNState.base);
+  releaseAcknowledgedChanges();
 
   rtps::SequenceNumber_t nextSN = msg.readerSNState.base;
 
@@ -281,8 +504,9 @@ void StatefulWriterT<NetworkDriver>::onNewAckNack(
 
   SFW_LOG("Received non-preemptive acknack with %u bits set.\r\n",
           msg.readerSNState.numBits);
-  for (uint32_t i = 0; i < msg.readerSNState.numBits &&
-                       nextSN <= m_history.getLastUsedSequenceNumber();
+  // Changes not sent to the reader yet are on their way anyway
+  const SequenceNumber_t lastSent = getHighestSentSequenceNumber(*reader);
+  for (uint32_t i = 0; i < msg.readerSNState.numBits && nextSN <= lastSent;
        ++i, ++nextSN) {
 
     if (msg.readerSNState.isSet(i)) {
@@ -292,6 +516,11 @@ void StatefulWriterT<NetworkDriver>::onNewAckNack(
 
       // We still have the cache, send DATA
       if (cache != nullptr) {
+        if (!consumeSendBudget(cache->data.spaceUsed())) {
+          // The reader requests the rest again after the next heartbeat
+          SFW_LOG("Rate limit reached, postponing retransmissions.\r\n");
+          return;
+        }
         if (cache->disposeAfterWrite) {
           SFW_LOG("SERVING FROM DISPOSE AFTER WRITE CACHE\r\n");
         }
@@ -325,6 +554,212 @@ void StatefulWriterT<NetworkDriver>::onNewAckNack(
   }
 }
 
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::onNewNackFrag(
+    const SubmessageNackFrag &msg, const GuidPrefix_t &sourceGuidPrefix) {
+  INIT_GUARD()
+  {
+    Lock lock{m_mutex};
+    if (!m_is_initialized_) {
+      return;
+    }
+
+    ReaderProxy *reader = getProxy(sourceGuidPrefix, msg.readerId);
+    if (reader == nullptr) {
+      SFW_LOG("No proxy found for nackfrag, dropping.");
+      return;
+    }
+
+    const CacheChange *change = m_history.getChangeBySN(msg.writerSN);
+    if (change == nullptr) {
+      // Sample is gone, the reader has to skip it
+      SequenceNumber_t nextValid = msg.writerSN;
+      ++nextValid;
+      sendGap(*reader, msg.writerSN, nextValid);
+    } else if (isFragmented(*change)) {
+      const uint32_t numFragments = getNumFragments(*change);
+      const FragmentNumberSet &set = msg.fragmentNumberState;
+      SFW_LOG("Received nackfrag for SN %u with %u bits set.",
+              (int)msg.writerSN.low, (int)set.numBits);
+      for (uint32_t i = 0; i < set.numBits; ++i) {
+        const uint32_t fragment = set.base.value + i;
+        if (fragment > numFragments) {
+          break;
+        }
+        if (set.isSet(i) && fragment != 0) {
+          if (!consumeSendBudget(Config::FRAGMENT_SIZE)) {
+            break; // Requested again with the next NACK_FRAG
+          }
+          sendFragments(*m_transport, &reader->remoteLocator, 1,
+                        reader->remoteReaderGuid.entityId, *change, fragment,
+                        fragment);
+        }
+      }
+    }
+  }
+  m_batcher.flush();
+}
+
+template <class NetworkDriver>
+rtps::ReaderProxy *
+StatefulWriterT<NetworkDriver>::getProxy(const GuidPrefix_t &prefix,
+                                         const EntityId_t &readerId) {
+  for (auto &proxy : m_proxies) {
+    if (proxy.remoteReaderGuid.prefix == prefix &&
+        proxy.remoteReaderGuid.entityId == readerId) {
+      return &proxy;
+    }
+  }
+  return nullptr;
+}
+
+template <class NetworkDriver>
+bool StatefulWriterT<NetworkDriver>::removeProxy(const Guid_t &guid) {
+  Lock lock{m_mutex};
+  const bool removed = Writer::removeProxy(guid);
+  recomputeProxyState();
+  return removed;
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::removeAllProxiesOfParticipant(
+    const GuidPrefix_t &guidPrefix) {
+  Lock lock{m_mutex};
+  Writer::removeAllProxiesOfParticipant(guidPrefix);
+  recomputeProxyState();
+}
+
+//! All changes before the returned sequence number are acknowledged by every
+//! reliable reader
+template <class NetworkDriver>
+rtps::SequenceNumber_t
+StatefulWriterT<NetworkDriver>::getMinAckedSequenceNumber() const {
+  if (m_numReadersAtMinAcked == 0 ||
+      m_nextSequenceNumberToSend < m_minAckedSequenceNumber) {
+    return m_nextSequenceNumberToSend;
+  }
+  return m_minAckedSequenceNumber;
+}
+
+//! Readers not catching up are in step with the writer
+template <class NetworkDriver>
+rtps::SequenceNumber_t
+StatefulWriterT<NetworkDriver>::getHighestSentSequenceNumber(
+    const ReaderProxy &proxy) const {
+  SequenceNumber_t highest = m_nextSequenceNumberToSend;
+  if (proxy.catchingUp) {
+    // Changes dropped from the history don't hold the reader back
+    highest = proxy.catchUpSequenceNumber;
+    if (highest < m_history.getCurrentSeqNumMin()) {
+      highest = m_history.getCurrentSeqNumMin();
+    }
+  }
+  --highest;
+  return highest;
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::onAcknowledged(
+    ReaderProxy &proxy, const SequenceNumber_t &base) {
+  if (!proxy.isResponsive) {
+    // The reader is back and holds back the watermark again
+    proxy.isResponsive = true;
+    if (proxy.lastAckNackSequenceNumber < base) {
+      proxy.lastAckNackSequenceNumber = base;
+    }
+    addToMinAcked(proxy);
+    return;
+  }
+  // Reordered ACKNACKs must not take back an acknowledgement
+  if (!(proxy.lastAckNackSequenceNumber < base)) {
+    return;
+  }
+  const bool wasAtMinAcked =
+      proxy.is_reliable &&
+      proxy.lastAckNackSequenceNumber == m_minAckedSequenceNumber;
+  proxy.lastAckNackSequenceNumber = base;
+  if (wasAtMinAcked && --m_numReadersAtMinAcked == 0) {
+    recomputeProxyState();
+  }
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::addToMinAcked(const ReaderProxy &proxy) {
+  if (!proxy.is_reliable || !proxy.isResponsive) {
+    return;
+  }
+  if (m_numReadersAtMinAcked == 0 ||
+      proxy.lastAckNackSequenceNumber < m_minAckedSequenceNumber) {
+    m_minAckedSequenceNumber = proxy.lastAckNackSequenceNumber;
+    m_numReadersAtMinAcked = 1;
+  } else if (proxy.lastAckNackSequenceNumber == m_minAckedSequenceNumber) {
+    ++m_numReadersAtMinAcked;
+  }
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::recomputeProxyState() {
+  m_numReadersAtMinAcked = 0;
+  m_numReadersCatchingUp = 0;
+  for (const auto &proxy : m_proxies) {
+    addToMinAcked(proxy);
+    if (proxy.catchingUp) {
+      ++m_numReadersCatchingUp;
+    }
+  }
+  // The watermark may have moved on
+  wakeBlockedWriters();
+}
+
+//! Strictly reliable VOLATILE writers drop changes as soon as every reliable
+//! reader acknowledged them. Others keep them for late joiners.
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::releaseAcknowledgedChanges() {
+  if (!m_strictReliable ||
+      m_attributes.durabilityKind != DurabilityKind_t::VOLATILE ||
+      m_history.isEmpty()) {
+    return;
+  }
+  SequenceNumber_t lastAcked = getMinAckedSequenceNumber();
+  if (!(m_history.getCurrentSeqNumMin() < lastAcked)) {
+    return;
+  }
+  --lastAcked;
+  m_history.removeUntilIncl(lastAcked);
+  wakeBlockedWriters();
+}
+
+//! Stops waiting for reliable readers that leave HEARTBEATs for outstanding
+//! changes unanswered
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::evictUnresponsiveReaders() {
+  const uint32_t now = sys_now();
+  bool evicted = false;
+  for (auto &proxy : m_proxies) {
+    if (proxy.is_reliable && proxy.isResponsive && proxy.heartbeatPending &&
+        proxy.lastAckNackSequenceNumber < m_nextSequenceNumberToSend &&
+        now - proxy.firstUnansweredHeartbeatMs >
+            Config::SF_WRITER_READER_RESPONSE_TIMEOUT_MS) {
+      proxy.isResponsive = false;
+      evicted = true;
+      Diagnostics::StatefulWriter::sfw_unresponsive_readers++;
+      SFW_LOG("Reader stopped responding, no longer waiting for it.");
+    }
+  }
+  if (evicted) {
+    recomputeProxyState();
+    releaseAcknowledgedChanges();
+  }
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::wakeBlockedWriters() {
+  if (m_strictReliable && m_maxBlockingTimeMs != 0 &&
+      sys_sem_valid(&m_historySpaceSem)) {
+    sys_sem_signal(&m_historySpaceSem);
+  }
+}
+
 template <class NetworkDriver>
 bool rtps::StatefulWriterT<NetworkDriver>::removeFromHistory(
     const SequenceNumber_t &s) {
@@ -336,25 +771,46 @@ template <class NetworkDriver>
 bool StatefulWriterT<NetworkDriver>::sendData(const ReaderProxy &reader,
                                               const CacheChange *next) {
   INIT_GUARD()
-  // TODO smarter packaging e.g. by creating MessageStruct and serialize after
-  // adjusting values Reusing the pbuf is not possible. See
+  // Reusing the whole pbuf for several readers is not possible, as lwIP
+  // prepends its headers to it. See
   // https://www.nongnu.org/lwip/2_0_x/raw_api.html (Zero-Copy MACs)
-
-  PacketInfo info;
-  info.srcPort = m_srcPort;
-
-  MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
-  MessageFactory::addSubMessageTimeStamp(info.buffer);
+  // Only the small message prefix is created per packet, the payload of the
+  // history is chained by reference.
 
   // Just usable for IPv4
   const LocatorIPv4 &locator = reader.remoteLocator;
 
+  if (isFragmented(*next)) {
+    // Pending submessages for the reader have to leave first
+    m_batcher.flush(locator);
+    return sendFragments(*m_transport, &locator, 1,
+                         reader.remoteReaderGuid.entityId, *next, 1,
+                         getNumFragments(*next)) == getNumFragments(*next);
+  }
+
+  if (next->data.spaceUsed() <= Config::MESSAGE_BATCH_MAX_PAYLOAD_SIZE &&
+      m_batcher.add(locator, MessageFactory::getBatchedDataSize(next->data),
+                    [&](PBufWrapper &buffer) {
+                      MessageFactory::addSubMessageData(
+                          buffer, next->data, next->inLineQoS,
+                          next->sequenceNumber,
+                          m_attributes.endpointGuid.entityId,
+                          reader.remoteReaderGuid.entityId, true);
+                    })) {
+    return true;
+  }
+  // Pending submessages for the reader have to leave first
+  m_batcher.flush(locator);
+
+  PacketInfo info;
+  info.srcPort = m_srcPort;
   info.destAddr = locator.getIp4Address();
   info.destPort = (Ip4Port_t)locator.port;
 
-  MessageFactory::addSubMessageData(
-      info.buffer, next->data, next->inLineQoS, next->sequenceNumber,
-      m_attributes.endpointGuid.entityId, reader.remoteReaderGuid.entityId);
+  MessageFactory::addDataMessage(
+      info.buffer, m_attributes.endpointGuid.prefix, next->data,
+      next->inLineQoS, next->sequenceNumber, m_attributes.endpointGuid.entityId,
+      reader.remoteReaderGuid.entityId);
   m_transport->sendPacket(info);
 
   return true;
@@ -369,15 +825,25 @@ void StatefulWriterT<NetworkDriver>::sendGap(
   // adjusting values Reusing the pbuf is not possible. See
   // https://www.nongnu.org/lwip/2_0_x/raw_api.html (Zero-Copy MACs)
 
+  // Just usable for IPv4
+  const LocatorIPv4 &locator = reader.remoteLocator;
+
+  if (m_batcher.add(locator, MessageFactory::gapSubMessageSize,
+                    [&](PBufWrapper &buffer) {
+                      MessageFactory::addSubmessageGap(
+                          buffer, m_attributes.endpointGuid.entityId,
+                          reader.remoteReaderGuid.entityId, firstMissing,
+                          nextValid);
+                    })) {
+    return;
+  }
+
   PacketInfo info;
   info.srcPort = m_srcPort;
 
   MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
   MessageFactory::addSubMessageTimeStamp(info.buffer);
 
-  // Just usable for IPv4
-  const LocatorIPv4 &locator = reader.remoteLocator;
-
   info.destAddr = locator.getIp4Address();
   info.destPort = (Ip4Port_t)locator.port;
 
@@ -388,84 +854,199 @@ void StatefulWriterT<NetworkDriver>::sendGap(
 }
 
 template <class NetworkDriver>
-bool StatefulWriterT<NetworkDriver>::sendDataWRMulticast(
-    const ReaderProxy &reader, const CacheChange *next) {
+uint32_t StatefulWriterT<NetworkDriver>::sendDataToAllProxies(
+    const CacheChange *next, const DataDestinations &destinations,
+    bool &withHeartbeat) {
   INIT_GUARD()
+  if (destinations.count == 0) {
+    withHeartbeat = false;
+    return 0;
+  }
 
-  if (reader.useMulticast || reader.suppressUnicast == false) {
-    PacketInfo info;
-    info.srcPort = m_srcPort;
+  // Small payloads are copied into the batched messages. Otherwise, the
+  // message is serialized once and every destination only gets an empty pbuf
+  // for the lwIP headers in front of it.
+  // A piggybacked HEARTBEAT follows the DATA in the same message, except for
+  // destinations of catching up readers. withHeartbeat is cleared if it could
+  // not be queued for every other destination.
+  const bool piggyback = withHeartbeat;
+  const SequenceNumber_t firstSN = m_history.getCurrentSeqNumMin();
+  auto serializeHeartbeat = [&](PBufWrapper &buffer) {
+    MessageFactory::addHeartbeat(buffer, m_attributes.endpointGuid.entityId,
+                                 destinations.readerId, firstSN,
+                                 next->sequenceNumber, m_hbCount);
+  };
+
+  if (isFragmented(*next)) {
+    for (uint32_t i = 0; i < destinations.count; ++i) {
+      m_batcher.flush(destinations.locators[i]);
+    }
+    const uint32_t numFragments = getNumFragments(*next);
+    if (sendFragments(*m_transport, destinations.locators.data(),
+                      destinations.count, destinations.readerId, *next, 1,
+                      numFragments) != numFragments) {
+      withHeartbeat = false;
+      return 0;
+    }
+    for (uint32_t i = 0; piggyback && i < destinations.count; ++i) {
+      if (reachesCatchingUpReader(destinations.locators[i])) {
+        continue;
+      }
+      withHeartbeat &=
+          m_batcher.add(destinations.locators[i],
+                        SubmessageHeartbeat::getRawSize(), serializeHeartbeat);
+    }
+    return destinations.count;
+  }
 
-    MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
-    MessageFactory::addSubMessageTimeStamp(info.buffer);
+  const bool batchable =
+      next->data.spaceUsed() <= Config::MESSAGE_BATCH_MAX_PAYLOAD_SIZE;
+  const DataSize_t dataSize = MessageFactory::getBatchedDataSize(next->data);
+  bool withDestinationHeartbeat = false;
+  auto serialize = [&](PBufWrapper &buffer) {
+    MessageFactory::addSubMessageData(
+        buffer, next->data, next->inLineQoS, next->sequenceNumber,
+        m_attributes.endpointGuid.entityId, destinations.readerId, true);
+    if (withDestinationHeartbeat) {
+      serializeHeartbeat(buffer);
+    }
+  };
+
+  PacketInfo message;
+  uint32_t sent = 0;
+  for (; sent < destinations.count; ++sent) {
+    const LocatorIPv4 &locator = destinations.locators[sent];
+    withDestinationHeartbeat =
+        piggyback && !reachesCatchingUpReader(locator);
+    const DataSize_t batchedSize =
+        withDestinationHeartbeat
+            ? dataSize + SubmessageHeartbeat::getRawSize()
+            : dataSize;
+    if (batchable && m_batcher.add(locator, batchedSize, serialize)) {
+      continue;
+    }
+    // Pending submessages for the destination have to leave first
+    m_batcher.flush(locator);
+
+    if (!message.buffer.isValid()) {
+      MessageFactory::addDataMessage(
+          message.buffer, m_attributes.endpointGuid.prefix, next->data,
+          next->inLineQoS, next->sequenceNumber,
+          m_attributes.endpointGuid.entityId, destinations.readerId);
+      if (!message.buffer.isValid()) {
+        break;
+      }
+    }
 
-    // Deceide whether multicast or not
-    if (reader.useMulticast) {
-      const LocatorIPv4 &locator = reader.remoteMulticastLocator;
-      info.destAddr = locator.getIp4Address();
-      info.destPort = (Ip4Port_t)locator.port;
-    } else {
-      const LocatorIPv4 &locator = reader.remoteLocator;
-      info.destAddr = locator.getIp4Address();
-      info.destPort = (Ip4Port_t)locator.port;
+    PacketInfo info;
+    info.srcPort = m_srcPort;
+    info.destAddr = locator.getIp4Address();
+    info.destPort = (Ip4Port_t)locator.port;
+    if (!info.buffer.wrapShared(message.buffer)) {
+      break;
     }
+    m_transport->sendPacket(info);
 
-    EntityId_t reid;
-    if (reader.useMulticast) {
-      reid = ENTITYID_UNKNOWN;
-    } else {
-      reid = reader.remoteReaderGuid.entityId;
+    // The shared message cannot be extended, send it with the next batch
+    if (withDestinationHeartbeat) {
+      withHeartbeat &= m_batcher.add(locator, SubmessageHeartbeat::getRawSize(),
+                                     serializeHeartbeat);
     }
+  }
+  if (sent < destinations.count) {
+    withHeartbeat = false;
+  }
+  return sent;
+}
 
-    MessageFactory::addSubMessageData(info.buffer, next->data, next->inLineQoS,
-                                      next->sequenceNumber,
-                                      m_attributes.endpointGuid.entityId, reid);
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::heartbeatTimerJumppad(void *thisPointer) {
+  auto *writer = static_cast<StatefulWriterT<NetworkDriver> *>(thisPointer);
+  writer->onHeartbeatTimer();
+}
 
-    m_transport->sendPacket(info);
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::onHeartbeatTimer() {
+  sendHeartBeat();
+  m_batcher.flush();
+
+  Lock lock{m_mutex};
+  evictUnresponsiveReaders();
+  m_lastHeartbeatMs = sys_now();
+  bool changesOutstanding = false;
+  uint32_t period = getHeartbeatPeriod(changesOutstanding);
+  if (!changesOutstanding) {
+    // Back off while everything is acknowledged
+    m_hbIdlePeriodMs = std::min<uint32_t>(2 * m_hbIdlePeriodMs,
+                                          Config::SF_WRITER_HB_MAX_PERIOD_MS);
+    period = m_hbIdlePeriodMs;
   }
-  return true;
+  getTimerWheel()->schedule(m_heartbeatTimer, period);
 }
 
 template <class NetworkDriver>
-void StatefulWriterT<NetworkDriver>::hbFunctionJumppad(void *thisPointer) {
-  auto *writer = static_cast<StatefulWriterT<NetworkDriver> *>(thisPointer);
-  writer->sendHeartBeatLoop();
+void StatefulWriterT<NetworkDriver>::rescheduleHeartbeat() {
+  if (getTimerWheel() == nullptr) {
+    return;
+  }
+  bool changesOutstanding = false;
+  const uint32_t deadline =
+      m_lastHeartbeatMs + getHeartbeatPeriod(changesOutstanding);
+  const uint32_t now = sys_now();
+  const int32_t remaining = static_cast<int32_t>(deadline - now);
+  getTimerWheel()->schedule(m_heartbeatTimer, remaining > 0 ? remaining : 0);
 }
 
 template <class NetworkDriver>
-void StatefulWriterT<NetworkDriver>::sendHeartBeatLoop() {
-  m_thread_running = true;
-  while (m_running) {
-    sendHeartBeat();
-    dropDisposeAfterWriteChanges();
-    bool unconfirmed_changes = false;
-    for (auto it : m_proxies) {
-      if (it.lastAckNackSequenceNumber < m_nextSequenceNumberToSend) {
-        unconfirmed_changes = true;
-        break;
-      }
-    }
+uint32_t
+StatefulWriterT<NetworkDriver>::getHeartbeatPeriod(bool &changesOutstanding) {
+  Lock lock{m_mutex};
+  changesOutstanding = false;
+  if (!(getMinAckedSequenceNumber() < m_nextSequenceNumberToSend)) {
+    return m_hbIdlePeriodMs;
+  }
 
-    // Temporarily increase HB frequency if there are unconfirmed remote changes
-    if (unconfirmed_changes) {
-      SFW_LOG("HB SPEEDUP!\r\n");
-#ifdef OS_IS_FREERTOS
-      vTaskDelay(pdMS_TO_TICKS(Config::SF_WRITER_HB_PERIOD_MS / 4));
-    } else {
-      vTaskDelay(pdMS_TO_TICKS(Config::SF_WRITER_HB_PERIOD_MS));
-    }
-#else
-      sys_msleep(Config::SF_WRITER_HB_PERIOD_MS / 4);
-    } else {
-      sys_msleep(Config::SF_WRITER_HB_PERIOD_MS);
+  uint32_t worstRtt = 0;
+  bool rttUnknown = false;
+  for (const auto &proxy : m_proxies) {
+    if (proxy.is_reliable && proxy.isResponsive &&
+        proxy.lastAckNackSequenceNumber < m_nextSequenceNumberToSend) {
+      changesOutstanding = true;
+      rttUnknown |= proxy.smoothedRttMs == 0;
+      worstRtt = std::max(worstRtt, proxy.smoothedRttMs);
     }
-#endif
   }
-  m_thread_running = false;
+
+  if (!changesOutstanding) {
+    return m_hbIdlePeriodMs;
+  }
+
+  SFW_LOG("HB SPEEDUP!\r\n");
+  uint32_t period = Config::SF_WRITER_HB_PERIOD_MS / 4;
+  if (!rttUnknown) {
+    period = std::min(period, Config::SF_WRITER_HB_RTT_MULTIPLIER * worstRtt);
+  }
+  period = std::max<uint32_t>(period, Config::SF_WRITER_HB_MIN_PERIOD_MS);
+  // The backoff restarts from the active period
+  m_hbIdlePeriodMs = period;
+  return period;
+}
+
+template <class NetworkDriver>
+void StatefulWriterT<NetworkDriver>::disposeTimerJumppad(void *thisPointer) {
+  auto *writer = static_cast<StatefulWriterT<NetworkDriver> *>(thisPointer);
+  Lock lock{writer->m_mutex};
+  const uint32_t nextExpiry = writer->dropDisposeAfterWriteChanges();
+  if (nextExpiry != 0) {
+    writer->getTimerWheel()->schedule(writer->m_disposeTimer, nextExpiry);
+  }
 }
 
+//! Returns the time until the next retained change expires, 0 if none is left
 template <class NetworkDriver>
-void StatefulWriterT<NetworkDriver>::dropDisposeAfterWriteChanges() {
+uint32_t StatefulWriterT<NetworkDriver>::dropDisposeAfterWriteChanges() {
+  const TickType_t retention =
+      pdMS_TO_TICKS(Config::SF_WRITER_DISPOSE_RETENTION_MS);
   SequenceNumber_t oldest_retained;
   while (m_disposeWithDelay.peakFirst(oldest_retained)) {
 
@@ -473,11 +1054,11 @@ void StatefulWriterT<NetworkDriver>::dropDisposeAfterWriteChanges() {
     if (change == nullptr || !change->disposeAfterWrite) {
       // Not in history anymore, drop
       m_disposeWithDelay.moveFirstInto(oldest_retained);
-      return;
+      continue;
     }
 
     auto age = (xTaskGetTickCount() - change->sentTickCount);
-    if (age > pdMS_TO_TICKS(4000)) {
+    if (age > retention) {
       m_history.dropChange(change->sequenceNumber);
       SFW_LOG("Removing SN %u %u for good\r\n",
               static_cast<unsigned int>(oldest_retained.low),
@@ -487,9 +1068,10 @@ void StatefulWriterT<NetworkDriver>::dropDisposeAfterWriteChanges() {
 
       continue;
     } else {
-      return;
+      return (retention - age + 1) * portTICK_PERIOD_MS;
     }
   }
+  return 0;
 }
 
 template <class NetworkDriver>
@@ -503,14 +1085,9 @@ void StatefulWriterT<NetworkDriver>::sendHeartBeat() {
 
   for (auto &proxy : m_proxies) {
 
-    PacketInfo info;
-    info.srcPort = m_srcPort;
-
     SequenceNumber_t firstSN;
     SequenceNumber_t lastSN;
 
-    MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
-
     {
       Lock lock{m_mutex};
 
@@ -518,12 +1095,11 @@ void StatefulWriterT<NetworkDriver>::sendHeartBeat() {
         firstSN = m_history.getCurrentSeqNumMin();
         lastSN = m_history.getCurrentSeqNumMax();
 
-        // Otherwise we may announce changes that have not been sent at least
-        // once!
-        if (lastSN > m_nextSequenceNumberToSend ||
-            lastSN == m_nextSequenceNumberToSend) {
-          lastSN = m_nextSequenceNumberToSend;
-          --lastSN;
+        // Otherwise we may announce changes that have not been sent to the
+        // reader at least once!
+        const SequenceNumber_t lastSent = getHighestSentSequenceNumber(proxy);
+        if (lastSent < lastSN) {
+          lastSN = lastSent;
         }
 
         // Proxy has confirmed all sequence numbers and set final flag
@@ -531,6 +1107,7 @@ void StatefulWriterT<NetworkDriver>::sendHeartBeat() {
             proxy.ackNackCount.value > 0) {
           continue;
         }
+        proxy.onHeartbeatSent(sys_now());
       } else if (m_history.getLastUsedSequenceNumber() ==
                  SequenceNumber_t{0, 0}) {
         firstSN = SequenceNumber_t{0, 1};
@@ -544,6 +1121,19 @@ void StatefulWriterT<NetworkDriver>::sendHeartBeat() {
     SFW_LOG("Sending HB with SN range [%u.%u;%u.%u]", firstSN.low, firstSN.high,
             lastSN.low, lastSN.high);
 
+    if (m_batcher.add(proxy.remoteLocator, SubmessageHeartbeat::getRawSize(),
+                      [&](PBufWrapper &buffer) {
+                        MessageFactory::addHeartbeat(
+                            buffer, m_attributes.endpointGuid.entityId,
+                            proxy.remoteReaderGuid.entityId, firstSN, lastSN,
+                            m_hbCount);
+                      })) {
+      continue;
+    }
+
+    PacketInfo info;
+    info.srcPort = m_srcPort;
+    MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
     MessageFactory::addHeartbeat(
         info.buffer, m_attributes.endpointGuid.entityId,
         proxy.remoteReaderGuid.entityId, firstSN, lastSN, m_hbCount);
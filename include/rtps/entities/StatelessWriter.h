@@ -27,6 +27,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 
 #include "lwip/sys.h"
 #include "rtps/common/types.h"
+#include "rtps/communication/MessageBatcher.h"
 #include "rtps/config.h"
 #include "rtps/entities/Writer.h"
 #include "rtps/storages/MemoryPool.h"
@@ -43,6 +44,7 @@ public:
             NetworkDriver &driver, bool enfUnicast = false);
 
   void progress() override;
+  void flushBatches() override;
   const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                DataSize_t size, bool inLineQoS = false,
                                bool markDisposedAfterWrite = false) override;
@@ -55,8 +57,11 @@ public:
 
 private:
   NetworkDriver *m_transport;
+  MessageBatcherT<NetworkDriver> m_batcher;
 
   SimpleHistoryCache<Config::HISTORY_SIZE_STATELESS> m_history;
+
+  bool sendNextChange();
 };
 
 using StatelessWriter = StatelessWriterT<UdpDriver>;
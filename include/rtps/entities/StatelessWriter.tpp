@@ -52,6 +52,7 @@ using rtps::StatelessWriterT;
 
 template <class NetworkDriver>
 StatelessWriterT<NetworkDriver>::~StatelessWriterT() {
+  cancelDeferredProgress();
   //  if(sys_mutex_valid(&m_mutex)){
   //    sys_mutex_free(&m_mutex);
   //  }
@@ -87,6 +88,11 @@ bool StatelessWriterT<NetworkDriver>::init(TopicData attributes,
   m_history.clear();
 
   m_transport = &driver;
+  if (!m_batcher.init(driver, m_attributes.endpointGuid.prefix, m_srcPort,
+                      getTimerWheel())) {
+    SLW_LOG("Failed to initialize message batching.\n");
+    return false;
+  }
 
   return true;
 }
@@ -94,6 +100,8 @@ bool StatelessWriterT<NetworkDriver>::init(TopicData attributes,
 template <typename NetworkDriver>
 void StatelessWriterT<NetworkDriver>::reset() {
   m_is_initialized_ = false;
+  cancelDeferredProgress();
+  m_batcher.reset();
 }
 
 template <typename NetworkDriver>
@@ -119,9 +127,7 @@ const CacheChange *StatelessWriterT<NetworkDriver>::newChange(
   }
 
   auto *result = m_history.addChange(data, size);
-  if (mp_threadPool != nullptr) {
-    mp_threadPool->addWorkload(this);
-  }
+  scheduleProgress();
 
   SLW_LOG("Adding new data.\n");
   return result;
@@ -141,9 +147,7 @@ void StatelessWriterT<NetworkDriver>::setAllChangesToUnsent() {
 
   m_nextSequenceNumberToSend = m_history.getSeqNumMin();
 
-  if (mp_threadPool != nullptr) {
-    mp_threadPool->addWorkload(this);
-  }
+  scheduleProgress();
 }
 
 template <typename NetworkDriver>
@@ -153,74 +157,111 @@ void StatelessWriterT<NetworkDriver>::onNewAckNack(
   // Too lazy to respond
 }
 
+template <typename NetworkDriver>
+void StatelessWriterT<NetworkDriver>::flushBatches() {
+  m_batcher.flush();
+}
+
 template <typename NetworkDriver>
 void StatelessWriterT<NetworkDriver>::progress() {
   INIT_GUARD();
-  // TODO smarter packaging e.g. by creating MessageStruct and serialize after
-  // adjusting values Reusing the pbuf is not possible. See
-  // https://www.nongnu.org/lwip/2_1_x/raw_api.html (Zero-Copy MACs)
+  Lock lock(m_mutex);
 
   if (m_proxies.getNumElements() == 0) {
     SLW_LOG("No Proxy!\n");
   }
 
-  for (const auto &proxy : m_proxies) {
-
-    SLW_LOG("Progess.\n");
-    // Do nothing, if someone else sends for me... (Multicast)
-    if (proxy.useMulticast || !proxy.suppressUnicast || m_enforceUnicast) {
-      PacketInfo info;
-      info.srcPort = m_srcPort;
-
-      MessageFactory::addHeader(info.buffer, m_attributes.endpointGuid.prefix);
-      MessageFactory::addSubMessageTimeStamp(info.buffer);
-
-      {
-        Lock lock(m_mutex);
-        const CacheChange *next =
-            m_history.getChangeBySN(m_nextSequenceNumberToSend);
-        if (next == nullptr) {
-          SLW_LOG("Couldn't get a new CacheChange with SN "
-                  "(%i,%i)\n",
-                  m_nextSequenceNumberToSend.high,
-                  m_nextSequenceNumberToSend.low);
-          return;
-        } else {
-          SLW_LOG("Sending change with SN (%i,%i)\n",
-                  m_nextSequenceNumberToSend.high,
-                  m_nextSequenceNumberToSend.low);
-        }
-
-        // Set EntityId to UNKNOWN if using multicast, because there might be
-        // different ones...
-        // TODO: mybe enhance by using UNKNOWN only if ids are really different
-        EntityId_t reid;
-        if (proxy.useMulticast && !m_enforceUnicast && proxy.unknown_eid) {
-          reid = ENTITYID_UNKNOWN;
-        } else {
-          reid = proxy.remoteReaderGuid.entityId;
-        }
-        MessageFactory::addSubMessageData(info.buffer, next->data, false,
-                                          next->sequenceNumber,
-                                          m_attributes.endpointGuid.entityId,
-                                          reid); // TODO
-      }
+  for (uint8_t i = 0; i < Config::WRITER_MAX_CHANGES_PER_PROGRESS; ++i) {
+    if (!sendNextChange()) {
+      return;
+    }
+  }
+  // Let the other writers go first before sending the rest
+  if (m_history.getChangeBySN(m_nextSequenceNumberToSend) != nullptr) {
+    scheduleProgress();
+  }
+}
 
-      // Just usable for IPv4
-      // Decide which locator to be used unicast/multicast
+template <typename NetworkDriver>
+bool StatelessWriterT<NetworkDriver>::sendNextChange() {
+  // Reusing the whole pbuf for several readers is not possible, as lwIP
+  // prepends its headers to it. See
+  // https://www.nongnu.org/lwip/2_1_x/raw_api.html (Zero-Copy MACs)
+  // Hence, small payloads are copied into batched messages. Otherwise, the
+  // message is serialized once and every destination only gets an empty pbuf
+  // for the lwIP headers in front of it.
+  const CacheChange *next = m_history.getChangeBySN(m_nextSequenceNumberToSend);
+  if (next == nullptr) {
+    SLW_LOG("Couldn't get a new CacheChange with SN "
+            "(%i,%i)\n",
+            m_nextSequenceNumberToSend.high, m_nextSequenceNumberToSend.low);
+    return false;
+  }
+
+  // Proxies sharing a locator are served by a single packet
+  DataDestinations destinations;
+  collectDataDestinations(destinations);
+  const uint32_t cost = getSendCost(*next, destinations);
+  if (!consumeSendBudget(cost)) {
+    deferProgress(cost);
+    return false;
+  }
+  SLW_LOG("Sending change with SN (%i,%i)\n", m_nextSequenceNumberToSend.high,
+          m_nextSequenceNumberToSend.low);
+
+  if (isFragmented(*next)) {
+    for (uint32_t i = 0; i < destinations.count; ++i) {
+      m_batcher.flush(destinations.locators[i]);
+    }
+    sendFragments(*m_transport, destinations.locators.data(),
+                  destinations.count, destinations.readerId, *next, 1,
+                  getNumFragments(*next));
+    m_history.removeUntilIncl(m_nextSequenceNumberToSend);
+    ++m_nextSequenceNumberToSend;
+    return true;
+  }
 
-      if (proxy.useMulticast && !m_enforceUnicast) {
-        info.destAddr = proxy.remoteMulticastLocator.getIp4Address();
-        info.destPort = (Ip4Port_t)proxy.remoteMulticastLocator.port;
-      } else {
-        info.destAddr = proxy.remoteLocator.getIp4Address();
-        info.destPort = (Ip4Port_t)proxy.remoteLocator.port;
+  const bool batchable =
+      next->data.spaceUsed() <= Config::MESSAGE_BATCH_MAX_PAYLOAD_SIZE;
+  const DataSize_t batchedSize = MessageFactory::getBatchedDataSize(next->data);
+  auto serialize = [&](PBufWrapper &buffer) {
+    MessageFactory::addSubMessageData(buffer, next->data, false,
+                                      next->sequenceNumber,
+                                      m_attributes.endpointGuid.entityId,
+                                      destinations.readerId, true);
+  };
+
+  PacketInfo message;
+  for (uint32_t i = 0; i < destinations.count; ++i) {
+    const LocatorIPv4 &locator = destinations.locators[i];
+    if (batchable && m_batcher.add(locator, batchedSize, serialize)) {
+      continue;
+    }
+    // Pending submessages for the destination have to leave first
+    m_batcher.flush(locator);
+
+    if (!message.buffer.isValid()) {
+      MessageFactory::addDataMessage(message.buffer,
+                                     m_attributes.endpointGuid.prefix,
+                                     next->data, false, next->sequenceNumber,
+                                     m_attributes.endpointGuid.entityId,
+                                     destinations.readerId); // TODO
+      if (!message.buffer.isValid()) {
+        break;
       }
-      
-      m_transport->sendPacket(info);
     }
+
+    PacketInfo info;
+    info.srcPort = m_srcPort;
+    info.destAddr = locator.getIp4Address();
+    info.destPort = (Ip4Port_t)locator.port;
+    if (!info.buffer.wrapShared(message.buffer)) {
+      break;
+    }
+    m_transport->sendPacket(info);
   }
 
   m_history.removeUntilIncl(m_nextSequenceNumberToSend);
   ++m_nextSequenceNumberToSend;
+  return true;
 }
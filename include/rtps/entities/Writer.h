@@ -26,12 +26,16 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #define RTPS_WRITER_H
 
 #include "rtps/ThreadPool.h"
+#include "rtps/communication/TokenBucket.h"
 #include "rtps/discovery/TopicData.h"
 #include "rtps/entities/ReaderProxy.h"
+#include "rtps/messages/MessageFactory.h"
 #include "rtps/storages/CacheChange.h"
 #include "rtps/storages/MemoryPool.h"
 #include "rtps/storages/PBufWrapper.h"
 
+#include <atomic>
+
 #ifdef DEBUG_BUILD
 #define COMPILE_INIT_GUARD
 #endif
@@ -58,15 +62,28 @@ public:
   virtual void reset() = 0;
   virtual const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
                                        DataSize_t size);
+  //! Adds a change of the instance with the given key hash. Reliable writers
+  //! of keyed topics keep the last Config::SF_WRITER_KEEP_LAST_DEPTH changes
+  //! of each instance. Other writers ignore the key.
+  virtual const CacheChange *newChange(ChangeKind_t kind, const uint8_t *data,
+                                       DataSize_t size, const KeyHash_t &key);
 
   //! Executes required steps like sending packets. Intended to be called by
   //! worker threads
   virtual void progress() = 0;
 
+  //! Sends messages still held back for batching. Intended to be called by
+  //! worker threads after progress()
+  virtual void flushBatches() {}
+
   virtual bool removeFromHistory(const SequenceNumber_t &s) = 0;
   virtual void setAllChangesToUnsent() = 0;
   virtual void onNewAckNack(const SubmessageAckNack &msg,
                             const GuidPrefix_t &sourceGuidPrefix) = 0;
+  //! Retransmits the requested fragments. Nothing to do if the writer
+  //! doesn't keep its changes for retransmission.
+  virtual void onNewNackFrag(const SubmessageNackFrag & /*msg*/,
+                             const GuidPrefix_t & /*sourceGuidPrefix*/) {}
 
   using dumpProxyCallback = void (*)(const Writer *writer, const ReaderProxy &,
                                      void *arg);
@@ -81,6 +98,29 @@ public:
 
   bool isBuiltinEndpoint();
 
+  //! The thread pool serves writers with a lower value first. Builtin
+  //! endpoints use Config::THREAD_POOL_BUILTIN_WRITER_PRIORITY.
+  void setPriority(uint8_t priority);
+  uint8_t getPriority();
+
+  //! Queues the writer at the thread pool unless it is queued already.
+  //! Returns false if the workload queue is full.
+  bool scheduleProgress();
+  //! Called by the thread pool before progress(), so changes added from now
+  //! on schedule the writer again
+  void onWorkloadDequeued();
+
+  //! Limits the bytes this writer sends per second, 0 disables the limit.
+  //! Must be called after init().
+  void setRateLimit(uint32_t bytesPerSecond, uint32_t burstBytes);
+
+  //! Strictly reliable writers only make room in a full history by dropping
+  //! changes every responsive reliable reader acknowledged. newChange() waits
+  //! up to maxBlockingTimeMs for such room and returns nullptr if there is
+  //! none, 0 doesn't wait at all. VOLATILE writers release acknowledged
+  //! changes right away. Only affects stateful writers.
+  void setStrictReliable(bool enabled, uint32_t maxBlockingTimeMs = 0);
+
 protected:
   SequenceNumber_t m_sedp_sequence_number;
 
@@ -90,6 +130,25 @@ protected:
   Ip4Port_t m_srcPort;
 
   bool m_enforceUnicast;
+  uint8_t m_priority = Config::THREAD_POOL_DEFAULT_WRITER_PRIORITY;
+  std::atomic<bool> m_progressScheduled{false};
+
+  TokenBucket m_rateLimiter{Config::WRITER_RATE_LIMIT_BYTES_PER_SEC,
+                            Config::WRITER_RATE_LIMIT_BURST_BYTES};
+  std::atomic<bool> m_progressDeferred{false};
+  Timer m_deferredProgressTimer{deferredProgressJumppad, this};
+  bool m_strictReliable = false;
+  uint32_t m_maxBlockingTimeMs = 0;
+  //! Takes the bytes from the rate limiter. Requires m_mutex.
+  bool consumeSendBudget(uint32_t bytes);
+  //! Schedules progress() once the rate limiter allows sending the bytes
+  void deferProgress(uint32_t bytes);
+  TimerWheel *getTimerWheel() {
+    return mp_threadPool != nullptr ? &mp_threadPool->getTimerWheel()
+                                    : nullptr;
+  }
+  void cancelDeferredProgress();
+  static void deferredProgressJumppad(void *thisPointer);
 
   TopicKind_t m_topicKind = TopicKind_t::NO_KEY;
   SequenceNumber_t m_nextSequenceNumberToSend;
@@ -104,10 +163,80 @@ protected:
   virtual ~Writer() = default;
   MemoryPool<ReaderProxy, Config::NUM_READER_PROXIES_PER_WRITER> m_proxies;
 
+  //! Distinct locators a change has to be sent to. The reader id is the one
+  //! of all addressed readers if they share it, ENTITYID_UNKNOWN otherwise.
+  struct DataDestinations {
+    std::array<LocatorIPv4, Config::NUM_READER_PROXIES_PER_WRITER> locators;
+    uint32_t count = 0;
+    EntityId_t readerId = ENTITYID_UNKNOWN;
+  };
+  void collectDataDestinations(DataDestinations &destinations);
+
+  //! Bytes put on the wire when sending the change to the destinations.
+  //! Readers sharing a locator are served by one datagram.
+  static uint32_t getSendCost(const CacheChange &change,
+                              const DataDestinations &destinations) {
+    return static_cast<uint32_t>(change.data.spaceUsed()) * destinations.count;
+  }
+
+  // Inline QoS only comes with small disposal messages, these are never sent
+  // as fragments
+  static bool isFragmented(const CacheChange &change) {
+    return !change.inLineQoS &&
+           change.data.spaceUsed() > Config::FRAGMENT_SIZE;
+  }
+
+  static uint32_t getNumFragments(const CacheChange &change) {
+    return MessageFactory::getNumFragments(change.data.spaceUsed(),
+                                           Config::FRAGMENT_SIZE);
+  }
+
+  //! Sends fragments [firstFragment, lastFragment] of the change as DATA_FRAG.
+  //! Each message is serialized once and shared by all locators.
+  template <class NetworkDriver>
+  uint32_t sendFragments(NetworkDriver &driver, const LocatorIPv4 *locators,
+                         uint32_t numLocators, const EntityId_t &readerId,
+                         const CacheChange &change, uint32_t firstFragment,
+                         uint32_t lastFragment);
+
   void resetSendOptions();
   void manageSendOptions();
   bool isIrrelevant(ChangeKind_t kind) const;
 };
+
+template <class NetworkDriver>
+uint32_t Writer::sendFragments(NetworkDriver &driver,
+                               const LocatorIPv4 *locators,
+                               uint32_t numLocators,
+                               const EntityId_t &readerId,
+                               const CacheChange &change,
+                               uint32_t firstFragment, uint32_t lastFragment) {
+  uint32_t sent = 0;
+  for (uint32_t fragment = firstFragment; fragment <= lastFragment;
+       ++fragment) {
+    PacketInfo message;
+    if (!MessageFactory::addDataFragMessage(
+            message.buffer, m_attributes.endpointGuid.prefix, change.data,
+            change.sequenceNumber, m_attributes.endpointGuid.entityId,
+            readerId, fragment, Config::FRAGMENT_SIZE)) {
+      return sent;
+    }
+
+    for (uint32_t i = 0; i < numLocators; ++i) {
+      PacketInfo info;
+      info.srcPort = m_srcPort;
+      info.destAddr = locators[i].getIp4Address();
+      info.destPort = (Ip4Port_t)locators[i].port;
+      if (!info.buffer.wrapShared(message.buffer)) {
+        return sent;
+      }
+      driver.sendPacket(info);
+    }
+    ++sent;
+  }
+  return sent;
+}
+
 } // namespace rtps
 
 #endif // RTPS_WRITER_H
@@ -26,6 +26,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #define RTPS_WRITERPROXY_H
 
 #include "rtps/common/types.h"
+#include "rtps/config.h"
 #include <rtps/common/Locator.h>
 
 namespace rtps {
@@ -36,6 +37,12 @@ struct WriterProxy {
   Count_t hbCount;
   bool is_reliable;
   LocatorIPv4 remoteLocator;
+  // A response to HEARTBEAT or GAP waits to be sent. It covers the changes up
+  // to ackNackLastSN.
+  bool ackNackPending = false;
+  SequenceNumber_t ackNackLastSN = {0, 0};
+  uint32_t lastAckNackMs = 0; // Only valid once an ACKNACK was sent
+
 
   WriterProxy() = default;
 
@@ -44,10 +51,18 @@ struct WriterProxy {
         expectedSN(SequenceNumber_t{0, 1}), ackNackCount{1}, hbCount{0},
         is_reliable(reliable), remoteLocator(loc) {}
 
-  // For now, we don't store any packets, so we just request all starting from
-  // the next expected
   SequenceNumberSet getMissing(const SequenceNumber_t &firstAvail,
                                const SequenceNumber_t &lastAvail) {
+    return getMissing(firstAvail, lastAvail,
+                      [](const SequenceNumber_t &) { return false; });
+  }
+
+  //! Requests all SNs starting from the next expected except for those
+  //! isReceived(sn) reports as already buffered
+  template <typename RECEIVED>
+  SequenceNumberSet getMissing(const SequenceNumber_t &firstAvail,
+                               const SequenceNumber_t &lastAvail,
+                               RECEIVED isReceived) {
     SequenceNumberSet set;
     if (lastAvail < expectedSN) {
       set.base = expectedSN;
@@ -58,7 +73,9 @@ struct WriterProxy {
       uint32_t bit;
       for (bit = 0, i = expectedSN; i <= lastAvail && bit < SNS_MAX_NUM_BITS;
            i++, bit++) {
-        set.bitMap[0] |= uint32_t{1} << (31 - bit);
+        if (!isReceived(i)) {
+          set.bitMap[bit / 32] |= uint32_t{1} << (31 - bit % 32);
+        }
         set.numBits++;
       }
     }
@@ -66,6 +83,12 @@ struct WriterProxy {
     return set;
   }
 
+  //! HEARTBEATs shortly after the last ACKNACK are not answered
+  bool isHeartbeatSuppressed(uint32_t nowMs) const {
+    return ackNackCount.value > 1 &&
+           nowMs - lastAckNackMs < Config::SF_READER_HB_SUPPRESSION_MS;
+  }
+
   Count_t getNextAckNackCount() {
     const Count_t tmp = ackNackCount;
     ++ackNackCount.value;
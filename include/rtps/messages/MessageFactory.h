@@ -42,6 +42,11 @@ const std::array<uint8_t, 4> PROTOCOL_TYPE{'R', 'T', 'P', 'S'};
 const uint8_t numBytesUntilEndOfLength =
     4; // The first bytes incl. submessagelength don't count
 
+// Header + INFO_TS + DATA submessage header in front of each payload
+const uint16_t dataMessagePrefixSize =
+    Header::getRawSize() + SubmessageHeader::getRawSize() + sizeof(Time_t) +
+    SubmessageData::getRawSize();
+
 template <class Buffer>
 void addHeader(Buffer &buffer, const GuidPrefix_t &guidPrefix) {
 
@@ -101,10 +106,23 @@ void addSubMessageTimeStamp(Buffer &buffer, bool setInvalid = false) {
   }
 }
 
+// Padding required to let a following submessage start 4 byte aligned
+inline uint16_t getAlignmentPadding(DataSize_t size) {
+  return (4 - (size % 4)) % 4;
+}
+
+/**
+ * @param copyAndAlignPayload If set, the payload is copied instead of chained
+ * and padded such that further submessages can be appended (batching).
+ */
 template <class Buffer>
 void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
                        bool containsInlineQos, const SequenceNumber_t &SN,
-                       const EntityId_t &writerID, const EntityId_t &readerID) {
+                       const EntityId_t &writerID, const EntityId_t &readerID,
+                       bool copyAndAlignPayload = false) {
+  const uint16_t padding =
+      copyAndAlignPayload ? getAlignmentPadding(filledPayload.spaceUsed()) : 0;
+
   SubmessageData msg;
   msg.header.submessageId = SubmessageKind::DATA;
 #if IS_LITTLE_ENDIAN
@@ -114,7 +132,7 @@ void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
 #endif
 
   msg.header.octetsToNextHeader = SubmessageData::getRawSize() +
-                                  filledPayload.spaceUsed() -
+                                  filledPayload.spaceUsed() + padding -
                                   numBytesUntilEndOfLength;
 
   if (containsInlineQos) {
@@ -135,11 +153,102 @@ void addSubMessageData(Buffer &buffer, const Buffer &filledPayload,
 
   serializeMessage(buffer, msg);
 
-  if (filledPayload.isValid()) {
+  if (!filledPayload.isValid()) {
+    return;
+  }
+
+  if (copyAndAlignPayload) {
+    const uint8_t zeros[4] = {0, 0, 0, 0};
+    buffer.appendCopy(filledPayload);
+    if (padding != 0) {
+      buffer.append(zeros, padding);
+    }
+  } else {
     buffer.append(filledPayload);
   }
 }
 
+template <class Buffer>
+DataSize_t getBatchedDataSize(const Buffer &filledPayload) {
+  return SubmessageData::getRawSize() + filledPayload.spaceUsed() +
+         getAlignmentPadding(filledPayload.spaceUsed());
+}
+
+/**
+ * Creates a complete DATA message. Only header, INFO_TS and the DATA
+ * submessage header are serialized into buffer, which is sized for them with a
+ * single allocation. The payload is chained behind them by reference, so the
+ * history data is never copied no matter how many readers it is sent to.
+ */
+template <class Buffer>
+void addDataMessage(Buffer &buffer, const GuidPrefix_t &guidPrefix,
+                    const Buffer &filledPayload, bool containsInlineQos,
+                    const SequenceNumber_t &SN, const EntityId_t &writerID,
+                    const EntityId_t &readerID) {
+  buffer.reserve(dataMessagePrefixSize);
+  addHeader(buffer, guidPrefix);
+  addSubMessageTimeStamp(buffer);
+  addSubMessageData(buffer, filledPayload, containsInlineQos, SN, writerID,
+                    readerID);
+}
+
+inline uint32_t getNumFragments(DataSize_t sampleSize,
+                                uint16_t fragmentSize) {
+  return (static_cast<uint32_t>(sampleSize) + fragmentSize - 1) / fragmentSize;
+}
+
+/**
+ * Creates a complete DATA_FRAG message carrying the fragment with the given
+ * number (starting at 1) of the payload. In contrast to addDataMessage, the
+ * fragment is copied as a pbuf chain cannot reference a part of another one.
+ */
+template <class Buffer>
+bool addDataFragMessage(Buffer &buffer, const GuidPrefix_t &guidPrefix,
+                        const Buffer &filledPayload, const SequenceNumber_t &SN,
+                        const EntityId_t &writerID, const EntityId_t &readerID,
+                        uint32_t fragment, uint16_t fragmentSize) {
+  const DataSize_t sampleSize = filledPayload.spaceUsed();
+  if (fragment == 0 || fragment > getNumFragments(sampleSize, fragmentSize)) {
+    return false;
+  }
+  const uint32_t offset = (fragment - 1) * fragmentSize;
+  const DataSize_t length = (sampleSize - offset < fragmentSize)
+                                ? static_cast<DataSize_t>(sampleSize - offset)
+                                : fragmentSize;
+
+  if (!buffer.reserve(Header::getRawSize() + SubmessageHeader::getRawSize() +
+                      sizeof(Time_t) + SubmessageDataFrag::getRawSize() +
+                      length)) {
+    return false;
+  }
+  addHeader(buffer, guidPrefix);
+  addSubMessageTimeStamp(buffer);
+
+  SubmessageDataFrag msg;
+  msg.header.submessageId = SubmessageKind::DATA_FRAG;
+#if IS_LITTLE_ENDIAN
+  msg.header.flags = FLAG_LITTLE_ENDIAN;
+#else
+  msg.header.flags = FLAG_BIG_ENDIAN;
+#endif
+  msg.header.octetsToNextHeader =
+      SubmessageDataFrag::getRawSize() + length - numBytesUntilEndOfLength;
+
+  msg.extraFlags = 0;
+  msg.octetsToInlineQos =
+      SubmessageDataFrag::getRawSize() - SubmessageHeader::getRawSize() - 4;
+  msg.readerId = readerID;
+  msg.writerId = writerID;
+  msg.writerSN = SN;
+  msg.fragmentStartingNum = {fragment};
+  msg.fragmentsInSubmessage = 1;
+  msg.fragmentSize = fragmentSize;
+  msg.sampleSize = sampleSize;
+
+  serializeMessage(buffer, msg);
+  return buffer.appendCopy(filledPayload, offset, length);
+}
+
 template <class Buffer>
 void addHeartbeat(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
                   SequenceNumber_t firstSN, SequenceNumber_t lastSN,
@@ -192,6 +301,33 @@ void addAckNack(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
   serializeMessage(buffer, subMsg);
 }
 
+template <class Buffer>
+void addNackFrag(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
+                 const SequenceNumber_t &writerSN,
+                 const FragmentNumberSet &fragmentNumberState, Count_t count) {
+  SubmessageNackFrag subMsg;
+  subMsg.header.submessageId = SubmessageKind::NACK_FRAG;
+#if IS_LITTLE_ENDIAN
+  subMsg.header.flags = FLAG_LITTLE_ENDIAN;
+#else
+  subMsg.header.flags = FLAG_BIG_ENDIAN;
+#endif
+  subMsg.header.octetsToNextHeader =
+      SubmessageNackFrag::getRawSize(fragmentNumberState) -
+      numBytesUntilEndOfLength;
+
+  subMsg.writerId = writerId;
+  subMsg.readerId = readerId;
+  subMsg.writerSN = writerSN;
+  subMsg.fragmentNumberState = fragmentNumberState;
+  subMsg.count = count;
+
+  serializeMessage(buffer, subMsg);
+}
+
+// GAP without bitmap, see addSubmessageGap
+const uint16_t gapSubMessageSize = 36;
+
 template <class Buffer>
 void addSubmessageGap(Buffer &buffer, EntityId_t writerId, EntityId_t readerId,
                       const SequenceNumber_t &firstMissing,
@@ -25,6 +25,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #ifndef RTPS_MESSAGERECEIVER_H
 #define RTPS_MESSAGERECEIVER_H
 
+#include "lwip/pbuf.h"
 #include "rtps/common/types.h"
 #include "rtps/config.h"
 #include "rtps/discovery/BuiltInEndpoints.h"
@@ -46,6 +47,7 @@ public:
   explicit MessageReceiver(Participant *part);
 
   bool processMessage(const uint8_t *data, DataSize_t size);
+  bool processMessage(const pbuf *chain);
 
 private:
   Participant *mp_part;
@@ -66,8 +68,17 @@ private:
                          const SubmessageHeader &submsgHeader);
   bool processDataSubmessage(MessageProcessingInfo &msgInfo,
                              const SubmessageHeader &submsgHeader);
+  bool processDataFragSubmessage(MessageProcessingInfo &msgInfo,
+                                 const SubmessageHeader &submsgHeader);
   bool processHeartbeatSubmessage(MessageProcessingInfo &msgInfo);
   bool processAckNackSubmessage(MessageProcessingInfo &msgInfo);
+  bool processNackFragSubmessage(MessageProcessingInfo &msgInfo);
+
+  //! Resolves the reader id of a submessage. ENTITYID_UNKNOWN yields all
+  //! local readers matched with the writer.
+  uint32_t getAddressedReaders(const EntityId_t &readerId,
+                               const EntityId_t &writerId, Reader **readers,
+                               uint32_t maxReaders);
 };
 } // namespace rtps
 
@@ -26,6 +26,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #define RTPS_MESSAGES_H
 
 #include "rtps/common/types.h"
+#include "rtps/storages/PBufWrapper.h"
 
 #include <array>
 
@@ -143,6 +144,7 @@ enum SubMessageFlag : uint8_t {
   FLAG_INLINE_QOS = (1 << 1),
   FLAG_NO_PAYLOAD = (0 << 3 | 0 << 2),
   FLAG_DATA_PAYLOAD = (0 << 3 | 1 << 2),
+  FLAG_KEY_PAYLOAD = (1 << 3 | 0 << 2),
   FLAG_FINAL = (1 << 1),
   FLAG_HB_LIVELINESS = (1 << 2)
 };
@@ -184,6 +186,25 @@ struct SubmessageData {
   }
 };
 
+struct SubmessageDataFrag {
+  SubmessageHeader header;
+  uint16_t extraFlags;
+  uint16_t octetsToInlineQos;
+  EntityId_t readerId;
+  EntityId_t writerId;
+  SequenceNumber_t writerSN;
+  FragmentNumber_t fragmentStartingNum;
+  uint16_t fragmentsInSubmessage;
+  uint16_t fragmentSize;
+  uint32_t sampleSize;
+  static constexpr uint16_t getRawSize() {
+    return SubmessageHeader::getRawSize() + sizeof(uint16_t) +
+           sizeof(uint16_t) + (2 * 3 + 2 * 1) // EntityID
+           + sizeof(SequenceNumber_t) + sizeof(FragmentNumber_t) +
+           2 * sizeof(uint16_t) + sizeof(uint32_t);
+  }
+};
+
 struct SubmessageHeartbeat {
   SubmessageHeader header;
   EntityId_t readerId;
@@ -232,10 +253,8 @@ struct SubmessageAckNack {
   SequenceNumberSet readerSNState;
   Count_t count;
   static uint16_t getRawSize(const SequenceNumberSet &set) {
-    uint16_t bitMapSize = 0;
-    if (set.numBits != 0) {
-      bitMapSize = SNS_NUM_BYTES;
-    }
+    // One 32 bit word per started 32 bits
+    const uint16_t bitMapSize = 4 * ((set.numBits + 31) / 32);
     return getRawSizeWithoutSNSet() + sizeof(SequenceNumber_t) +
            sizeof(uint32_t) + bitMapSize; // SequenceNumberSet
   }
@@ -244,6 +263,24 @@ struct SubmessageAckNack {
   }
 };
 
+struct SubmessageNackFrag {
+  SubmessageHeader header;
+  EntityId_t readerId;
+  EntityId_t writerId;
+  SequenceNumber_t writerSN;
+  FragmentNumberSet fragmentNumberState;
+  Count_t count;
+  static uint16_t getRawSize(const FragmentNumberSet &set) {
+    const uint16_t bitMapSize = 4 * ((set.numBits + 31) / 32);
+    return getRawSizeWithoutFNSet() + sizeof(FragmentNumber_t) +
+           sizeof(uint32_t) + bitMapSize; // FragmentNumberSet
+  }
+  static uint16_t getRawSizeWithoutFNSet() {
+    return SubmessageHeader::getRawSize() + (2 * (3 + 1)) +
+           sizeof(SequenceNumber_t) + sizeof(Count_t);
+  }
+};
+
 template <typename Buffer>
 bool serializeMessage(Buffer &buffer, Header &header) {
   if (!buffer.reserve(Header::getRawSize())) {
@@ -260,10 +297,9 @@ bool serializeMessage(Buffer &buffer, Header &header) {
 
 template <typename Buffer>
 bool serializeMessage(Buffer &buffer, SubmessageHeader &header) {
-  if (!buffer.reserve(Header::getRawSize())) {
+  if (!buffer.reserve(SubmessageHeader::getRawSize())) {
     return false;
   }
-  buffer.reserve(SubmessageHeader::getRawSize());
 
   buffer.append(reinterpret_cast<uint8_t *>(&header.submessageId),
                 sizeof(SubmessageKind));
@@ -311,6 +347,38 @@ bool serializeMessage(Buffer &buffer, SubmessageData &msg) {
   return true;
 }
 
+template <typename Buffer>
+bool serializeMessage(Buffer &buffer, SubmessageDataFrag &msg) {
+  if (!buffer.reserve(SubmessageDataFrag::getRawSize())) {
+    return false;
+  }
+
+  serializeMessage(buffer, msg.header);
+
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.extraFlags), sizeof(uint16_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.octetsToInlineQos),
+                sizeof(uint16_t));
+  buffer.append(msg.readerId.entityKey.data(), msg.readerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.readerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(msg.writerId.entityKey.data(), msg.writerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.high),
+                sizeof(msg.writerSN.high));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.low),
+                sizeof(msg.writerSN.low));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentStartingNum.value),
+                sizeof(msg.fragmentStartingNum.value));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentsInSubmessage),
+                sizeof(uint16_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentSize),
+                sizeof(uint16_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.sampleSize),
+                sizeof(uint32_t));
+  return true;
+}
+
 template <typename Buffer>
 bool serializeMessage(Buffer &buffer, SubmessageHeartbeat &msg) {
   if (!buffer.reserve(SubmessageHeartbeat::getRawSize())) {
@@ -360,7 +428,41 @@ bool serializeMessage(Buffer &buffer, SubmessageAckNack &msg) {
                 sizeof(uint32_t));
   if (msg.readerSNState.numBits != 0) {
     buffer.append(reinterpret_cast<uint8_t *>(msg.readerSNState.bitMap.data()),
-                  4 * ((msg.readerSNState.numBits / 32) + 1));
+                  4 * ((msg.readerSNState.numBits + 31) / 32));
+  }
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.count.value),
+                sizeof(msg.count.value));
+  return true;
+}
+
+template <typename Buffer>
+bool serializeMessage(Buffer &buffer, SubmessageNackFrag &msg) {
+  if (!buffer.reserve(
+          SubmessageNackFrag::getRawSize(msg.fragmentNumberState))) {
+    return false;
+  }
+
+  serializeMessage(buffer, msg.header);
+
+  buffer.append(msg.readerId.entityKey.data(), msg.readerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.readerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(msg.writerId.entityKey.data(), msg.writerId.entityKey.size());
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerId.entityKind),
+                sizeof(EntityKind_t));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.high),
+                sizeof(msg.writerSN.high));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.writerSN.low),
+                sizeof(msg.writerSN.low));
+  buffer.append(
+      reinterpret_cast<uint8_t *>(&msg.fragmentNumberState.base.value),
+      sizeof(msg.fragmentNumberState.base.value));
+  buffer.append(reinterpret_cast<uint8_t *>(&msg.fragmentNumberState.numBits),
+                sizeof(uint32_t));
+  if (msg.fragmentNumberState.numBits != 0) {
+    buffer.append(
+        reinterpret_cast<uint8_t *>(msg.fragmentNumberState.bitMap.data()),
+        4 * ((msg.fragmentNumberState.numBits + 31) / 32));
   }
   buffer.append(reinterpret_cast<uint8_t *>(&msg.count.value),
                 sizeof(msg.count.value));
@@ -405,20 +507,63 @@ bool serializeMessage(Buffer &buffer, SubmessageGap &msg) {
 }
 
 struct MessageProcessingInfo {
-  MessageProcessingInfo(const uint8_t *data, DataSize_t size)
-      : data(data), size(size) {}
-  const uint8_t *data;
+  //! The message may be spread over several pbufs, no copy is made
+  explicit MessageProcessingInfo(const pbuf *chain)
+      : chain(chain), size(chain->tot_len), m_segment(chain) {}
+  const pbuf *chain;
   const DataSize_t size;
 
   //! Offset to the next unprocessed byte
   DataSize_t nextPos = 0;
 
-  inline const uint8_t *getPointerToCurrentPos() const {
-    return &data[nextPos];
+  //! Largest part of a submessage that is read at once, a GAP with full bitmap
+  static constexpr DataSize_t MAX_LINEARIZED_SIZE = 32 + SNS_NUM_BYTES;
+
+  /**
+   * Returns length contiguous bytes at the current position. If they span
+   * several pbufs, they are copied into an internal buffer that is only valid
+   * until the next call. Returns nullptr if less data is left.
+   */
+  inline const uint8_t *getPointerToCurrentPos(DataSize_t length) const {
+    return getPointer(0, length);
+  }
+
+  //! Same as getPointerToCurrentPos() for bytes offset bytes behind it
+  inline const uint8_t *getPointer(DataSize_t offset, DataSize_t length) const {
+    if (offset > getRemainingSize() ||
+        length > getRemainingSize() - offset) {
+      return nullptr;
+    }
+    // Submessages are read front to back, so continue from the last segment
+    // instead of walking the chain from its start for every field
+    const DataSize_t pos = nextPos + offset;
+    if (pos < m_segmentStart) {
+      m_segment = chain;
+      m_segmentStart = 0;
+    }
+    while (pos - m_segmentStart >= m_segment->len &&
+           m_segment->next != nullptr) {
+      m_segmentStart += m_segment->len;
+      m_segment = m_segment->next;
+    }
+    return static_cast<const uint8_t *>(
+        pbuf_get_contiguous(m_segment, m_linearized.data(), m_linearized.size(),
+                            length, pos - m_segmentStart));
+  }
+
+  //! View of length bytes starting offset bytes behind the current position
+  inline PBufView getView(DataSize_t offset, DataSize_t length) const {
+    return PBufView{chain, static_cast<DataSize_t>(nextPos + offset), length};
   }
 
   //! Returns the size of data which isn't processed yet
   inline DataSize_t getRemainingSize() const { return size - nextPos; }
+
+private:
+  mutable std::array<uint8_t, MAX_LINEARIZED_SIZE> m_linearized;
+  // Segment that holds the last position read and its offset in the chain
+  mutable const pbuf *m_segment;
+  mutable DataSize_t m_segmentStart = 0;
 };
 
 bool deserializeMessage(const MessageProcessingInfo &info, Header &header);
@@ -428,6 +573,9 @@ bool deserializeMessage(const MessageProcessingInfo &info,
 
 bool deserializeMessage(const MessageProcessingInfo &info, SubmessageData &msg);
 
+bool deserializeMessage(const MessageProcessingInfo &info,
+                        SubmessageDataFrag &msg);
+
 bool deserializeMessage(const MessageProcessingInfo &info,
                         SubmessageHeartbeat &msg);
 
@@ -436,8 +584,18 @@ bool deserializeMessage(const MessageProcessingInfo &info,
 
 bool deserializeMessage(const MessageProcessingInfo &info, SubmessageGap &msg);
 
-void deserializeSNS(const uint8_t *&position, SequenceNumberSet &set,
-                    size_t num_bitfields);
+bool deserializeMessage(const MessageProcessingInfo &info,
+                        SubmessageNackFrag &msg);
+
+/**
+ * Parses the parameter list starting offset bytes behind the current position
+ * up to and including its sentinel, which must lie within maxLength bytes.
+ * length is set to the number of bytes the list occupies.
+ */
+bool deserializeInlineQos(const MessageProcessingInfo &info,
+                          const SubmessageHeader &header, DataSize_t offset,
+                          DataSize_t maxLength, InlineQos_t &qos,
+                          DataSize_t &length);
 
 } // namespace rtps
 
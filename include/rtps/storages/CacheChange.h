@@ -25,6 +25,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #ifndef PROJECT_CACHECHANGE_H
 #define PROJECT_CACHECHANGE_H
 
+#include "FreeRTOS.h"
 #include "rtps/common/types.h"
 #include "rtps/storages/PBufWrapper.h"
 
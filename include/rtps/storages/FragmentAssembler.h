@@ -0,0 +1,232 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_FRAGMENTASSEMBLER_H
+#define RTPS_FRAGMENTASSEMBLER_H
+
+#include "lwip/pbuf.h"
+#include "rtps/common/types.h"
+#include "rtps/config.h"
+#include "rtps/storages/PBufWrapper.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace rtps {
+
+/**
+ * Reassembles samples received as DATA_FRAG. Memory is bounded by the number
+ * of slots and Config::FRAG_MAX_SAMPLE_SIZE. The oldest sample is evicted if
+ * fragments of a new one arrive while all slots are in use.
+ */
+template <uint8_t NUM_SAMPLES> class FragmentAssembler {
+public:
+  //! A sample with more fragments can't be acknowledged with one NACK_FRAG
+  static constexpr uint32_t MAX_NUM_FRAGMENTS = SNS_MAX_NUM_BITS;
+
+  struct Sample {
+    Guid_t writerGuid;
+    SequenceNumber_t sn;
+    PBufWrapper data; // Contiguous, sampleSize bytes
+    uint32_t sampleSize = 0;
+    uint16_t fragmentSize = 0;
+    uint32_t numFragments = 0;
+    uint32_t numReceived = 0;
+    std::array<uint32_t, MAX_NUM_FRAGMENTS / 32> received{};
+    uint32_t age = 0;
+    bool inUse = false;
+
+    const uint8_t *getData() const {
+      return static_cast<const uint8_t *>(data.firstElement->payload);
+    }
+
+    bool isReceived(uint32_t fragment) const {
+      return (received[(fragment - 1) / 32] & (1u << ((fragment - 1) % 32))) !=
+             0;
+    }
+  };
+
+  void clear() {
+    for (auto &sample : m_samples) {
+      release(sample);
+    }
+  }
+
+  /**
+   * Copies fragments [firstFragment, firstFragment + numFragments) of a sample
+   * into its slot. Fragment numbers start at 1.
+   * @return The sample if it is complete now, nullptr otherwise. A completed
+   * sample has to be handed back with release().
+   */
+  Sample *addFragments(const Guid_t &writerGuid, const SequenceNumber_t &sn,
+                       uint32_t sampleSize, uint16_t fragmentSize,
+                       uint32_t firstFragment, uint16_t numFragments,
+                       const PBufView &data) {
+    if (fragmentSize == 0 || firstFragment == 0 || sampleSize == 0 ||
+        sampleSize > Config::FRAG_MAX_SAMPLE_SIZE) {
+      return nullptr;
+    }
+    const uint32_t totalFragments =
+        (sampleSize + fragmentSize - 1) / fragmentSize;
+    if (totalFragments > MAX_NUM_FRAGMENTS ||
+        firstFragment > totalFragments) {
+      return nullptr;
+    }
+
+    Sample *sample = find(writerGuid, sn);
+    if (sample == nullptr) {
+      sample = allocate(writerGuid, sn, sampleSize, fragmentSize);
+      if (sample == nullptr) {
+        return nullptr;
+      }
+    } else if (sample->sampleSize != sampleSize ||
+               sample->fragmentSize != fragmentSize) {
+      return nullptr;
+    }
+
+    uint32_t offset = (firstFragment - 1) * fragmentSize;
+    for (uint32_t fragment = firstFragment;
+         fragment < firstFragment + numFragments && fragment <= totalFragments;
+         ++fragment, offset += fragmentSize) {
+      const uint32_t length = (sampleSize - offset < fragmentSize)
+                                  ? sampleSize - offset
+                                  : fragmentSize;
+      const uint32_t dataOffset = offset - (firstFragment - 1) * fragmentSize;
+      if (dataOffset + length > data.size) {
+        break;
+      }
+      if (sample->isReceived(fragment)) {
+        continue;
+      }
+      if (pbuf_copy_partial(
+              data.chain,
+              static_cast<uint8_t *>(sample->data.firstElement->payload) +
+                  offset,
+              length, data.offset + dataOffset) != length) {
+        break;
+      }
+      sample->received[(fragment - 1) / 32] |= 1u << ((fragment - 1) % 32);
+      ++sample->numReceived;
+    }
+
+    return (sample->numReceived == sample->numFragments) ? sample : nullptr;
+  }
+
+  void release(Sample &sample) {
+    sample.data.destroy();
+    sample.inUse = false;
+  }
+
+  bool isAssembling(const Guid_t &writerGuid, const SequenceNumber_t &sn) {
+    return find(writerGuid, sn) != nullptr;
+  }
+
+  /**
+   * Calls f(sn, missing) for every incomplete sample of the writer up to
+   * lastSN, missing holds the fragments that were not received yet.
+   */
+  template <typename FUNC>
+  void forEachIncomplete(const Guid_t &writerGuid,
+                         const SequenceNumber_t &lastSN, FUNC f) {
+    for (auto &sample : m_samples) {
+      if (!sample.inUse || !(sample.writerGuid == writerGuid) ||
+          lastSN < sample.sn) {
+        continue;
+      }
+      FragmentNumberSet missing;
+      for (uint32_t fragment = 1; fragment <= sample.numFragments;
+           ++fragment) {
+        if (sample.isReceived(fragment)) {
+          continue;
+        }
+        if (missing.base.value == 0) {
+          missing.base.value = fragment;
+        }
+        missing.numBits = fragment - missing.base.value + 1;
+        missing.set(fragment - missing.base.value);
+      }
+      f(sample.sn, missing);
+    }
+  }
+
+  //! Drops the samples of the writer before sn, they can't be delivered anymore
+  void removeOlderThan(const Guid_t &writerGuid, const SequenceNumber_t &sn) {
+    for (auto &sample : m_samples) {
+      if (sample.inUse && sample.writerGuid == writerGuid && sample.sn < sn) {
+        release(sample);
+      }
+    }
+  }
+
+private:
+  std::array<Sample, NUM_SAMPLES> m_samples;
+  uint32_t m_age = 0;
+
+  Sample *find(const Guid_t &writerGuid, const SequenceNumber_t &sn) {
+    for (auto &sample : m_samples) {
+      if (sample.inUse && sample.sn == sn && sample.writerGuid == writerGuid) {
+        return &sample;
+      }
+    }
+    return nullptr;
+  }
+
+  Sample *allocate(const Guid_t &writerGuid, const SequenceNumber_t &sn,
+                   uint32_t sampleSize, uint16_t fragmentSize) {
+    Sample *slot = nullptr;
+    for (auto &sample : m_samples) {
+      if (!sample.inUse) {
+        slot = &sample;
+        break;
+      }
+      if (slot == nullptr || sample.age < slot->age) {
+        slot = &sample;
+      }
+    }
+    if (slot == nullptr) {
+      return nullptr;
+    }
+    release(*slot);
+
+    slot->data = PBufWrapper{pbuf_alloc(PBUF_RAW, sampleSize, PBUF_RAM)};
+    if (!slot->data.isValid()) {
+      return nullptr;
+    }
+    slot->writerGuid = writerGuid;
+    slot->sn = sn;
+    slot->sampleSize = sampleSize;
+    slot->fragmentSize = fragmentSize;
+    slot->numFragments = (sampleSize + fragmentSize - 1) / fragmentSize;
+    slot->numReceived = 0;
+    slot->received = {};
+    slot->age = m_age++;
+    slot->inUse = true;
+    return slot;
+  }
+};
+
+} // namespace rtps
+
+#endif // RTPS_FRAGMENTASSEMBLER_H
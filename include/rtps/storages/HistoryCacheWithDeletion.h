@@ -25,35 +25,70 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #ifndef HISTORYCACHEWITHDELETION_H
 #define HISTORYCACHEWITHDELETION_H
 
+#include "rtps/storages/CacheChange.h"
+#include "rtps/storages/StaticHashIndex.h"
+
 #include <array>
 #include <stdint.h>
 
 namespace rtps {
 
 /**
- * Extension of the SimpleHistoryCache that allows for deletion operation at the
- * cost of efficieny
- * TODO: Replace with something better in the future!
- * Likely only used for SEDP
+ * Extension of the SimpleHistoryCache that allows for deletion of arbitrary
+ * changes. Changes live in a pool of SIZE slots which are found through a
+ * hash index on their sequence number and linked in sequence number order.
+ * Dropping a change frees its slot right away (kind INVALID) and leaves a
+ * hole in the sequence numbers, which the order list steps over.
+ *
+ * Changes may belong to an instance identified by a key hash. Only the last
+ * depth changes of each instance are kept (KEEP_LAST). When the history is
+ * full, the oldest change that is not the latest one of its instance is
+ * dropped first, so a burst on one instance doesn't evict the latest state
+ * of the others. Up to MAX_INSTANCES instances are tracked.
  */
-template <uint16_t SIZE> class HistoryCacheWithDeletion {
+template <uint16_t SIZE, uint16_t MAX_INSTANCES = 0>
+class HistoryCacheWithDeletion {
 public:
-  HistoryCacheWithDeletion() = default;
+  HistoryCacheWithDeletion() { clear(); }
 
   uint32_t m_dispose_after_write_cnt = 0;
 
-  bool isFull() const {
-    uint16_t it = m_head;
-    incrementIterator(it);
-    return it == m_tail;
+  bool isFull() const { return m_numChanges == SIZE; }
+
+  //! Number of changes kept per instance, at least one
+  void setInstanceDepth(uint16_t depth) {
+    m_instanceDepth = depth == 0 ? 1 : depth;
   }
 
+  /**
+   * Adds a change of the instance with the given key or one without instance
+   * if key is nullptr. Drops the oldest change of the instance if it exceeds
+   * the depth and another one if the history is full. Returns nullptr if
+   * there is no room for a new instance.
+   */
   const CacheChange *addChange(const uint8_t *data, DataSize_t size,
-                               bool inLineQoS, bool disposeAfterWrite) {
-    CacheChange change;
+                               bool inLineQoS, bool disposeAfterWrite,
+                               const KeyHash_t *key) {
+    if (key != nullptr) {
+      const uint16_t instance = findInstance(*key);
+      if (instance == NONE && m_numInstances == MAX_INSTANCES) {
+        return nullptr;
+      }
+      if (instance != NONE &&
+          m_instances[instance].count >= m_instanceDepth) {
+        dropSlot(m_instances[instance].oldest);
+      }
+    }
+    if (isFull()) {
+      dropSlot(selectSlotToEvict());
+    }
+
+    const uint16_t slot = m_freeSlots[--m_numFreeSlots];
+    CacheChange &change = m_buffer[slot];
     change.kind = ChangeKind_t::ALIVE;
     change.inLineQoS = inLineQoS;
     change.disposeAfterWrite = disposeAfterWrite;
+    change.sentTickCount = 0;
     change.data.reserve(size);
     change.data.append(data, size);
     change.sequenceNumber = ++m_lastUsedSequenceNumber;
@@ -61,12 +96,43 @@ public:
     if (disposeAfterWrite) {
       m_dispose_after_write_cnt++;
     }
+    ++m_numChanges;
+    m_snIndex.insert(change.sequenceNumber, slot);
+    if (isCounted(change.sequenceNumber)) {
+      ++m_numCounted;
+    }
 
-    CacheChange *place = &m_buffer[m_head];
-    incrementHead();
+    linkAsLatest(slot);
+    m_instanceOf[slot] = NONE;
+    if (key != nullptr) {
+      linkToInstance(slot, createInstance(*key));
+    }
+    return &change;
+  }
 
-    *place = std::move(change);
-    return place;
+  /**
+   * Returns the sequence number of the change addChange() drops to make room
+   * for a change of the given instance in a full history.
+   * SEQUENCENUMBER_UNKNOWN if there is room or the instance drops its own
+   * oldest change.
+   */
+  SequenceNumber_t getChangeToEvict(const KeyHash_t *key) {
+    if (!isFull()) {
+      return SEQUENCENUMBER_UNKNOWN;
+    }
+    if (key != nullptr) {
+      const uint16_t instance = findInstance(*key);
+      if (instance != NONE &&
+          m_instances[instance].count >= m_instanceDepth) {
+        return SEQUENCENUMBER_UNKNOWN;
+      }
+    }
+    return m_buffer[selectSlotToEvict()].sequenceNumber;
+  }
+
+  const CacheChange *addChange(const uint8_t *data, DataSize_t size,
+                               bool inLineQoS, bool disposeAfterWrite) {
+    return addChange(data, size, inLineQoS, disposeAfterWrite, nullptr);
   }
 
   const CacheChange *addChange(const uint8_t *data, DataSize_t size) {
@@ -74,49 +140,19 @@ public:
   }
 
   void removeUntilIncl(SequenceNumber_t sn) {
-    if (m_head == m_tail) {
-      return;
-    }
-
-    if (getCurrentSeqNumMax() <= sn) { // We won't overrun head
-      m_head = m_tail;
-      return;
-    }
-
-    while (m_buffer[m_tail].sequenceNumber <= sn) {
-      incrementTail();
+    while (!isEmpty() && m_minSequenceNumber <= sn) {
+      dropSlot(m_oldestSlot);
     }
   }
 
   void dropOldest() { removeUntilIncl(getCurrentSeqNumMin()); }
 
   bool dropChange(const SequenceNumber_t &sn) {
-    uint16_t idx_to_clear;
-    CacheChange *change;
-    if (!getChangeBySN(sn, &change, idx_to_clear)) {
+    const uint16_t slot = getSlot(sn);
+    if (slot == NONE) {
       return false; // sn does not exist, nothing to do
     }
-
-    if (idx_to_clear == m_tail) {
-      m_buffer[m_tail].reset();
-      incrementTail();
-      return true;
-    }
-
-    uint16_t prev = idx_to_clear;
-    do {
-      prev = idx_to_clear - 1;
-      if (prev >= m_buffer.size()) {
-        prev = m_buffer.size() - 1;
-      }
-
-      m_buffer[idx_to_clear] = std::move(m_buffer[prev]);
-      idx_to_clear = prev;
-
-    } while (prev != m_tail);
-
-    incrementTail();
-
+    dropSlot(slot);
     return true;
   }
 
@@ -131,27 +167,57 @@ public:
   }
 
   CacheChange *getChangeBySN(SequenceNumber_t sn) {
-    CacheChange *change;
-    uint16_t position;
-    if (getChangeBySN(sn, &change, position)) {
-      return change;
+    const uint16_t slot = getSlot(sn);
+    return slot == NONE ? nullptr : &m_buffer[slot];
+  }
+
+  //! Returns the oldest change with a sequence number of at least sn
+  CacheChange *getNextChange(const SequenceNumber_t &sn) {
+    const uint16_t slot = findNextSlot(sn);
+    return slot == NONE ? nullptr : &m_buffer[slot];
+  }
+
+  /**
+   * Keeps count of the changes with sequence numbers in [first, end), e.g.
+   * the ones sent but not acknowledged yet. Changes added or dropped in the
+   * range are counted right away. Moving the bounds only walks the changes
+   * between the old and the new ones.
+   */
+  void setCountedRange(const SequenceNumber_t &first,
+                       const SequenceNumber_t &end) {
+    if (!(first < m_countedEnd) || !(m_countedFirst < end)) {
+      // Disjoint from the old range
+      m_numCounted = countChanges(first, end);
     } else {
-      return nullptr;
+      if (m_countedFirst < first) {
+        m_numCounted -= countChanges(m_countedFirst, first);
+      } else {
+        m_numCounted += countChanges(first, m_countedFirst);
+      }
+      if (m_countedEnd < end) {
+        m_numCounted += countChanges(m_countedEnd, end);
+      } else {
+        m_numCounted -= countChanges(end, m_countedEnd);
+      }
     }
+    m_countedFirst = first;
+    m_countedEnd = end;
   }
 
-  bool isEmpty() { return (m_head == m_tail); }
+  uint16_t getNumCountedChanges() const { return m_numCounted; }
+
+  bool isEmpty() { return m_numChanges == 0; }
 
   const SequenceNumber_t &getCurrentSeqNumMin() const {
-    if (m_head == m_tail) {
+    if (m_numChanges == 0) {
       return SEQUENCENUMBER_UNKNOWN;
     } else {
-      return m_buffer[m_tail].sequenceNumber;
+      return m_minSequenceNumber;
     }
   }
 
   const SequenceNumber_t &getCurrentSeqNumMax() const {
-    if (m_head == m_tail) {
+    if (m_numChanges == 0) {
       return SEQUENCENUMBER_UNKNOWN;
     } else {
       return m_lastUsedSequenceNumber;
@@ -163,9 +229,26 @@ public:
   }
 
   void clear() {
-    m_head = 0;
-    m_tail = 0;
+    for (uint16_t i = 0; i < SIZE; ++i) {
+      m_buffer[i].reset();
+      m_buffer[i].data.destroy();
+      m_freeSlots[i] = SIZE - 1 - i;
+    }
+    m_numFreeSlots = SIZE;
+    m_numChanges = 0;
+    m_oldestSlot = NONE;
+    m_latestSlot = NONE;
+    m_snIndex.clear();
+    for (uint16_t i = 0; i < MAX_INSTANCES; ++i) {
+      m_instances[i].count = 0;
+      m_freeInstances[i] = MAX_INSTANCES - 1 - i;
+    }
+    m_numInstances = 0;
+    m_instanceIndex.clear();
     m_lastUsedSequenceNumber = {0, 0};
+    m_minSequenceNumber = {0, 0};
+    m_dispose_after_write_cnt = 0;
+    m_numCounted = 0;
   }
 #ifdef DEBUG_HISTORY_CACHE_WITH_DELETION
   void print() {
@@ -183,11 +266,13 @@ public:
         std::cout << " Type = DISPOSED";
         break;
       }
-      if (m_head == i) {
-        std::cout << " <- HEAD";
+      if (m_buffer[i].kind != ChangeKind_t::INVALID &&
+          m_instanceOf[i] != NONE) {
+        std::cout << " Instance = " << m_instanceOf[i];
       }
-      if (m_tail == i) {
-        std::cout << " <- TAIL";
+      if (m_buffer[i].kind != ChangeKind_t::INVALID &&
+          m_buffer[i].sequenceNumber == m_minSequenceNumber) {
+        std::cout << " <- MIN";
       }
       std::cout << std::endl;
     }
@@ -205,68 +290,243 @@ public:
   }
 
 private:
-  std::array<CacheChange, SIZE + 1> m_buffer{};
-  uint16_t m_head = 0;
-  uint16_t m_tail = 0;
-  static_assert(sizeof(SIZE) <= sizeof(m_head),
-                "Iterator is large enough for given size");
+  static constexpr uint16_t NONE = UINT16_MAX;
+  static_assert(SIZE < NONE && MAX_INSTANCES < NONE,
+                "Slot indices need to fit into uint16_t");
 
-  SequenceNumber_t m_lastUsedSequenceNumber{0, 0};
+  std::array<CacheChange, SIZE> m_buffer{};
+  std::array<uint16_t, SIZE> m_freeSlots{};
+  uint16_t m_numFreeSlots = 0;
+  uint16_t m_numChanges = 0;
+  StaticHashIndex<SequenceNumber_t, uint16_t, hashIndexCapacity(SIZE)>
+      m_snIndex;
 
-  bool getChangeBySN(const SequenceNumber_t &sn, CacheChange **out_change,
-                     uint16_t &out_buffer_position) {
+  SequenceNumber_t m_lastUsedSequenceNumber{0, 0};
+  // Oldest change, only valid if the history is not empty
+  SequenceNumber_t m_minSequenceNumber{0, 0};
+
+  // Changes in [m_countedFirst, m_countedEnd), see setCountedRange()
+  SequenceNumber_t m_countedFirst{0, 0};
+  SequenceNumber_t m_countedEnd{0, 0};
+  uint16_t m_numCounted = 0;
+
+  // All changes form a list from the oldest to the latest one
+  uint16_t m_oldestSlot = NONE;
+  uint16_t m_latestSlot = NONE;
+  std::array<uint16_t, SIZE> m_prevBySN{};
+  std::array<uint16_t, SIZE> m_nextBySN{};
+
+  // The changes of an instance form a list from the oldest to the latest one
+  struct Instance {
+    KeyHash_t key;
+    uint16_t oldest = NONE;
+    uint16_t latest = NONE;
+    uint16_t count = 0; // Unused if 0
+  };
+  std::array<Instance, MAX_INSTANCES> m_instances{};
+  uint16_t m_numInstances = 0;
+  // Unused instances, the last MAX_INSTANCES - m_numInstances ones are valid
+  std::array<uint16_t, MAX_INSTANCES> m_freeInstances{};
+  uint16_t m_instanceDepth = 1;
+  StaticHashIndex<KeyHash_t, uint16_t, hashIndexCapacity(MAX_INSTANCES)>
+      m_instanceIndex;
+  std::array<uint16_t, SIZE> m_instanceOf{};
+  std::array<uint16_t, SIZE> m_nextOfInstance{};
+
+  uint16_t getSlot(const SequenceNumber_t &sn) {
     if (!isSNInRange(sn)) {
-      return false;
+      return NONE;
+    }
+    const uint16_t slot = m_snIndex.find(sn);
+    // find() yields 0 for unknown numbers
+    if (m_buffer[slot].kind == ChangeKind_t::INVALID ||
+        !(m_buffer[slot].sequenceNumber == sn)) {
+      return NONE;
     }
-    static_assert(std::is_unsigned<decltype(sn.low)>::value,
-                  "Underflow well defined");
-    static_assert(sizeof(m_tail) <= sizeof(uint16_t), "Cast ist well defined");
+    return slot;
+  }
 
-    unsigned int cur_idx = m_tail;
-    while (cur_idx != m_head) {
-      if (m_buffer[cur_idx].sequenceNumber == sn) {
-        *out_change = &m_buffer[cur_idx];
-        out_buffer_position = cur_idx;
-        return true;
+  /**
+   * Returns the slot of the oldest change with a sequence number of at least
+   * sn. Takes constant time if the change with sn or the one before it are
+   * still there, as for a send position following the changes sent.
+   * Otherwise the order list is walked from both ends, which takes as many
+   * steps as there are changes on the shorter side of sn.
+   */
+  uint16_t findNextSlot(const SequenceNumber_t &sn) {
+    if (isEmpty() || m_lastUsedSequenceNumber < sn) {
+      return NONE;
+    }
+    if (!(m_minSequenceNumber < sn)) {
+      return m_oldestSlot;
+    }
+    uint16_t slot = getSlot(sn);
+    if (slot != NONE) {
+      return slot;
+    }
+    SequenceNumber_t previous = sn;
+    --previous;
+    slot = getSlot(previous);
+    if (slot != NONE) {
+      return m_nextBySN[slot];
+    }
+    // The oldest change is older than sn, so the backward walk ends first if
+    // there is no newer one
+    uint16_t older = m_oldestSlot;
+    uint16_t newer = m_latestSlot;
+    while (true) {
+      if (m_buffer[newer].sequenceNumber < sn) {
+        return m_nextBySN[newer];
       }
-      // Sequence numbers are consecutive
-      if (m_buffer[cur_idx].sequenceNumber > sn) {
-        *out_change = nullptr;
-        return false;
+      if (!(m_buffer[older].sequenceNumber < sn)) {
+        return older;
+      }
+      newer = m_prevBySN[newer];
+      older = m_nextBySN[older];
+    }
+  }
+
+  //! Number of changes with sequence numbers in [first, end)
+  uint16_t countChanges(const SequenceNumber_t &first,
+                        const SequenceNumber_t &end) {
+    uint16_t count = 0;
+    for (uint16_t slot = findNextSlot(first);
+         slot != NONE && m_buffer[slot].sequenceNumber < end;
+         slot = m_nextBySN[slot]) {
+      ++count;
+    }
+    return count;
+  }
+
+  bool isCounted(const SequenceNumber_t &sn) const {
+    return !(sn < m_countedFirst) && sn < m_countedEnd;
+  }
+
+  void dropSlot(uint16_t slot) {
+    CacheChange &change = m_buffer[slot];
+    const SequenceNumber_t sn = change.sequenceNumber;
+    if (change.disposeAfterWrite) {
+      m_dispose_after_write_cnt--;
+    }
+    if (m_instanceOf[slot] != NONE) {
+      unlinkFromInstance(slot);
+    }
+    if (isCounted(sn)) {
+      --m_numCounted;
+    }
+    m_snIndex.remove(sn, slot);
+    unlinkBySN(slot);
+    change.reset();
+    change.data.destroy();
+    m_freeSlots[m_numFreeSlots++] = slot;
+    --m_numChanges;
+  }
+
+  void linkAsLatest(uint16_t slot) {
+    m_prevBySN[slot] = m_latestSlot;
+    m_nextBySN[slot] = NONE;
+    if (m_latestSlot == NONE) {
+      m_oldestSlot = slot;
+      m_minSequenceNumber = m_buffer[slot].sequenceNumber;
+    } else {
+      m_nextBySN[m_latestSlot] = slot;
+    }
+    m_latestSlot = slot;
+  }
+
+  void unlinkBySN(uint16_t slot) {
+    const uint16_t prev = m_prevBySN[slot];
+    const uint16_t next = m_nextBySN[slot];
+    if (prev == NONE) {
+      m_oldestSlot = next;
+      if (next != NONE) {
+        m_minSequenceNumber = m_buffer[next].sequenceNumber;
       }
+    } else {
+      m_nextBySN[prev] = next;
+    }
+    if (next == NONE) {
+      m_latestSlot = prev;
+    } else {
+      m_prevBySN[next] = prev;
+    }
+  }
 
-      cur_idx++;
-      if (cur_idx >= m_buffer.size()) {
-        cur_idx -= m_buffer.size();
+  uint16_t selectSlotToEvict() {
+    const uint16_t oldest = m_oldestSlot;
+    const uint16_t instance = m_instanceOf[oldest];
+    if (instance == NONE || m_instances[instance].count > 1) {
+      return oldest;
+    }
+    // Oldest change of an instance that has newer ones
+    uint16_t candidate = NONE;
+    for (const auto &other : m_instances) {
+      if (other.count > 1 &&
+          (candidate == NONE || m_buffer[other.oldest].sequenceNumber <
+                                    m_buffer[candidate].sequenceNumber)) {
+        candidate = other.oldest;
       }
     }
+    return candidate == NONE ? oldest : candidate;
+  }
 
-    *out_change = nullptr;
-    return false;
+  uint16_t findInstance(const KeyHash_t &key) const {
+    const uint16_t idx = m_instanceIndex.find(key);
+    // find() yields 0 for unknown keys
+    if (idx < MAX_INSTANCES && m_instances[idx].count != 0 &&
+        m_instances[idx].key == key) {
+      return idx;
+    }
+    return NONE;
   }
 
-  inline void incrementHead() {
-    incrementIterator(m_head);
-    if (m_head == m_tail) {
-      // Move without check
-      incrementIterator(m_tail); // drop one
+  uint16_t createInstance(const KeyHash_t &key) {
+    uint16_t idx = findInstance(key);
+    if (idx != NONE) {
+      return idx;
     }
+    // Checked in addChange() that there is an unused one
+    idx = m_freeInstances[MAX_INSTANCES - 1 - m_numInstances];
+    m_instances[idx].key = key;
+    m_instanceIndex.insert(key, idx);
+    ++m_numInstances;
+    return idx;
   }
 
-  inline void incrementIterator(uint16_t &iterator) const {
-    ++iterator;
-    if (iterator >= m_buffer.size()) {
-      iterator = 0;
+  void linkToInstance(uint16_t slot, uint16_t idx) {
+    Instance &instance = m_instances[idx];
+    m_instanceOf[slot] = idx;
+    m_nextOfInstance[slot] = NONE;
+    if (instance.count == 0) {
+      instance.oldest = slot;
+    } else {
+      m_nextOfInstance[instance.latest] = slot;
     }
+    instance.latest = slot;
+    ++instance.count;
   }
 
-  inline void incrementTail() {
-    if (m_buffer[m_tail].disposeAfterWrite) {
-      m_dispose_after_write_cnt--;
+  void unlinkFromInstance(uint16_t slot) {
+    const uint16_t idx = m_instanceOf[slot];
+    Instance &instance = m_instances[idx];
+    m_instanceOf[slot] = NONE;
+    if (instance.oldest == slot) {
+      instance.oldest = m_nextOfInstance[slot];
+    } else {
+      // Only dropChange() removes others than the oldest, depth is small
+      uint16_t prev = instance.oldest;
+      while (m_nextOfInstance[prev] != slot) {
+        prev = m_nextOfInstance[prev];
+      }
+      m_nextOfInstance[prev] = m_nextOfInstance[slot];
+      if (instance.latest == slot) {
+        instance.latest = prev;
+      }
     }
-    if (m_head != m_tail) {
-      m_buffer[m_tail].reset();
-      incrementIterator(m_tail);
+    if (--instance.count == 0) {
+      m_instanceIndex.remove(instance.key, idx);
+      --m_numInstances;
+      m_freeInstances[MAX_INSTANCES - 1 - m_numInstances] = idx;
     }
   }
 
@@ -0,0 +1,141 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_LOCKFREECIRCULARBUFFER_H
+#define RTPS_LOCKFREECIRCULARBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace rtps {
+
+/**
+ * Bounded multi-producer/multi-consumer queue without locks (per-slot
+ * sequence counters, see D. Vyukov). Offers the interface of
+ * ThreadSafeCircularBuffer except for peakFirst(), which cannot be provided
+ * safely with concurrent consumers. The capacity is SIZE rounded up to the
+ * next power of two.
+ */
+template <typename T, uint16_t SIZE> class MpmcCircularBuffer {
+
+public:
+  bool init();
+
+  bool moveElementIntoBuffer(T &&elem);
+  bool copyElementIntoBuffer(const T &elem);
+
+  /**
+   * Removes the first into the given hull. Also moves responsibility for
+   * resources.
+   * @return true if element was injected. False if no element was present.
+   */
+  bool moveFirstInto(T &hull);
+  /**
+   * Removes up to n elements from the front into the given hulls.
+   * @return Number of elements that were moved.
+   */
+  uint32_t moveFirstN(T *hulls, uint32_t n);
+
+  uint32_t numElements();
+  uint32_t insertionFailures();
+
+  //! Drains the buffer. Must not race with other consumers.
+  void clear();
+
+private:
+  static constexpr uint32_t nextPowerOfTwo(uint32_t value,
+                                           uint32_t result = 1) {
+    return result >= value ? result : nextPowerOfTwo(value, result << 1);
+  }
+  static constexpr uint32_t CAPACITY = nextPowerOfTwo(SIZE);
+  static constexpr uint32_t MASK = CAPACITY - 1;
+  static_assert(SIZE > 0, "Buffer needs at least one slot");
+
+  struct Cell {
+    std::atomic<uint32_t> sequence{0};
+    T data{};
+  };
+
+  std::array<Cell, CAPACITY> m_cells{};
+  std::atomic<uint32_t> m_enqueuePos{0};
+  std::atomic<uint32_t> m_dequeuePos{0};
+  std::atomic<uint32_t> m_insertion_failures{0};
+  bool m_initialized = false;
+
+  template <typename U> bool enqueue(U &&elem);
+};
+
+/**
+ * Bounded single-producer/single-consumer queue without locks. Only one
+ * thread may insert and only one thread may remove elements. Offers the
+ * complete interface of ThreadSafeCircularBuffer.
+ */
+template <typename T, uint16_t SIZE> class SpscCircularBuffer {
+
+public:
+  bool init();
+
+  bool moveElementIntoBuffer(T &&elem);
+  bool copyElementIntoBuffer(const T &elem);
+
+  /**
+   * Removes the first into the given hull. Also moves responsibility for
+   * resources.
+   * @return true if element was injected. False if no element was present.
+   */
+  bool moveFirstInto(T &hull);
+  /**
+   * Removes up to n elements from the front into the given hulls.
+   * @return Number of elements that were moved.
+   */
+  uint32_t moveFirstN(T *hulls, uint32_t n);
+  bool peakFirst(T &hull);
+
+  uint32_t numElements();
+  uint32_t insertionFailures();
+
+  //! Drains the buffer. Must be called from the consumer.
+  void clear();
+
+private:
+  std::array<T, SIZE + 1> m_buffer{};
+  std::atomic<uint16_t> m_head{0};
+  std::atomic<uint16_t> m_tail{0};
+  uint32_t m_insertion_failures = 0;
+  static_assert(SIZE + 1 < std::numeric_limits<uint16_t>::max(),
+                "Iterator is large enough for given size");
+
+  bool m_initialized = false;
+
+  template <typename U> bool enqueue(U &&elem);
+  inline uint16_t nextIndex(uint16_t index) const;
+};
+
+} // namespace rtps
+
+#include "LockFreeCircularBuffer.tpp"
+
+#endif // RTPS_LOCKFREECIRCULARBUFFER_H
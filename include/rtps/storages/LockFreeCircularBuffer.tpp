@@ -0,0 +1,237 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_LOCKFREECIRCULARBUFFER_TPP
+#define RTPS_LOCKFREECIRCULARBUFFER_TPP
+
+#include <utility>
+
+namespace rtps {
+
+template <typename T, uint16_t SIZE>
+bool MpmcCircularBuffer<T, SIZE>::init() {
+  if (m_initialized) {
+    return true;
+  }
+  for (uint32_t i = 0; i < CAPACITY; ++i) {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  m_enqueuePos.store(0, std::memory_order_relaxed);
+  m_dequeuePos.store(0, std::memory_order_relaxed);
+  m_initialized = true;
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+bool MpmcCircularBuffer<T, SIZE>::moveElementIntoBuffer(T &&elem) {
+  return enqueue(std::move(elem));
+}
+
+template <typename T, uint16_t SIZE>
+bool MpmcCircularBuffer<T, SIZE>::copyElementIntoBuffer(const T &elem) {
+  return enqueue(elem);
+}
+
+template <typename T, uint16_t SIZE>
+template <typename U>
+bool MpmcCircularBuffer<T, SIZE>::enqueue(U &&elem) {
+  uint32_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+  Cell *cell;
+  while (true) {
+    cell = &m_cells[pos & MASK];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<int32_t>(seq - pos);
+    if (diff == 0) {
+      // Slot is free, try to claim it
+      if (m_enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Slot still holds an element from the previous round
+      m_insertion_failures.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = m_enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+  cell->data = std::forward<U>(elem);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+bool MpmcCircularBuffer<T, SIZE>::moveFirstInto(T &hull) {
+  uint32_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+  Cell *cell;
+  while (true) {
+    cell = &m_cells[pos & MASK];
+    uint32_t seq = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<int32_t>(seq - (pos + 1));
+    if (diff == 0) {
+      if (m_dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Empty, or the producer of this slot has not finished yet
+      return false;
+    } else {
+      pos = m_dequeuePos.load(std::memory_order_relaxed);
+    }
+  }
+  hull = std::move(cell->data);
+  cell->sequence.store(pos + CAPACITY, std::memory_order_release);
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+uint32_t MpmcCircularBuffer<T, SIZE>::moveFirstN(T *hulls, uint32_t n) {
+  uint32_t moved = 0;
+  while (moved < n && moveFirstInto(hulls[moved])) {
+    ++moved;
+  }
+  return moved;
+}
+
+template <typename T, uint16_t SIZE>
+uint32_t MpmcCircularBuffer<T, SIZE>::numElements() {
+  // The dequeue position never passes the enqueue position, so loading it
+  // first can't yield a negative count. It may be outdated by the time the
+  // enqueue position is loaded though.
+  const uint32_t dequeuePos = m_dequeuePos.load(std::memory_order_acquire);
+  const uint32_t count =
+      m_enqueuePos.load(std::memory_order_acquire) - dequeuePos;
+  return count < CAPACITY ? count : CAPACITY;
+}
+
+template <typename T, uint16_t SIZE>
+uint32_t MpmcCircularBuffer<T, SIZE>::insertionFailures() {
+  return m_insertion_failures.load(std::memory_order_relaxed);
+}
+
+template <typename T, uint16_t SIZE>
+void MpmcCircularBuffer<T, SIZE>::clear() {
+  T hull;
+  while (moveFirstInto(hull)) {
+  }
+}
+
+template <typename T, uint16_t SIZE>
+bool SpscCircularBuffer<T, SIZE>::init() {
+  m_initialized = true;
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+bool SpscCircularBuffer<T, SIZE>::moveElementIntoBuffer(T &&elem) {
+  return enqueue(std::move(elem));
+}
+
+template <typename T, uint16_t SIZE>
+bool SpscCircularBuffer<T, SIZE>::copyElementIntoBuffer(const T &elem) {
+  return enqueue(elem);
+}
+
+template <typename T, uint16_t SIZE>
+template <typename U>
+bool SpscCircularBuffer<T, SIZE>::enqueue(U &&elem) {
+  const uint16_t head = m_head.load(std::memory_order_relaxed);
+  const uint16_t next = nextIndex(head);
+  if (next == m_tail.load(std::memory_order_acquire)) {
+    m_insertion_failures++;
+    return false;
+  }
+  m_buffer[head] = std::forward<U>(elem);
+  m_head.store(next, std::memory_order_release);
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+bool SpscCircularBuffer<T, SIZE>::moveFirstInto(T &hull) {
+  const uint16_t tail = m_tail.load(std::memory_order_relaxed);
+  if (tail == m_head.load(std::memory_order_acquire)) {
+    return false;
+  }
+  hull = std::move(m_buffer[tail]);
+  m_tail.store(nextIndex(tail), std::memory_order_release);
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+uint32_t SpscCircularBuffer<T, SIZE>::moveFirstN(T *hulls, uint32_t n) {
+  uint16_t tail = m_tail.load(std::memory_order_relaxed);
+  const uint16_t head = m_head.load(std::memory_order_acquire);
+  uint32_t moved = 0;
+  while (moved < n && tail != head) {
+    hulls[moved] = std::move(m_buffer[tail]);
+    tail = nextIndex(tail);
+    ++moved;
+  }
+  // Release all slots at once
+  m_tail.store(tail, std::memory_order_release);
+  return moved;
+}
+
+template <typename T, uint16_t SIZE>
+bool SpscCircularBuffer<T, SIZE>::peakFirst(T &hull) {
+  const uint16_t tail = m_tail.load(std::memory_order_relaxed);
+  if (tail == m_head.load(std::memory_order_acquire)) {
+    return false;
+  }
+  hull = m_buffer[tail];
+  return true;
+}
+
+template <typename T, uint16_t SIZE>
+uint32_t SpscCircularBuffer<T, SIZE>::numElements() {
+  const uint16_t head = m_head.load(std::memory_order_relaxed);
+  const uint16_t tail = m_tail.load(std::memory_order_relaxed);
+  return head >= tail ? head - tail : m_buffer.size() - tail + head;
+}
+
+template <typename T, uint16_t SIZE>
+uint32_t SpscCircularBuffer<T, SIZE>::insertionFailures() {
+  return m_insertion_failures;
+}
+
+template <typename T, uint16_t SIZE>
+void SpscCircularBuffer<T, SIZE>::clear() {
+  T hull;
+  while (moveFirstInto(hull)) {
+  }
+}
+
+template <typename T, uint16_t SIZE>
+inline uint16_t SpscCircularBuffer<T, SIZE>::nextIndex(uint16_t index) const {
+  ++index;
+  if (index >= m_buffer.size()) {
+    index = 0;
+  }
+  return index;
+}
+
+} // namespace rtps
+
+#endif // RTPS_LOCKFREECIRCULARBUFFER_TPP
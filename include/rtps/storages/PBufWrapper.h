@@ -53,10 +53,29 @@ struct PBufWrapper {
 
   bool append(const uint8_t *data, DataSize_t length);
 
-  /// Note that unused reserved memory is now part of the wrapper. New calls to
+  /// Chains the pbufs of other by reference (pbuf_ref), no payload is copied.
+  /// Unused reserved memory of this wrapper is released first so that the
+  /// chained data directly follows the data written so far. Unused reserved
+  /// memory of other is now part of the wrapper. New calls to
   /// append(uint8_t*[...]) will continue behind the appended wrapper
   void append(const PBufWrapper &other);
 
+  /// Copies the used data of other behind the data written so far
+  bool appendCopy(const PBufWrapper &other);
+
+  /// Copies length bytes of other starting at offset behind the data written
+  /// so far
+  bool appendCopy(const PBufWrapper &other, DataSize_t offset,
+                  DataSize_t length);
+
+  /// Releases reserved but unused memory at the end of the chain
+  void shrinkToFit();
+
+  /// Replaces the content by an empty pbuf followed by the pbufs of other
+  /// (by reference). Lower layers prepend their headers to the empty pbuf, so
+  /// the same data can be handed to several sends without being modified.
+  bool wrapShared(const PBufWrapper &other);
+
   bool reserve(DataSize_t length);
 
   void destroy();
@@ -79,6 +98,20 @@ private:
   void copySimpleMembersAndResetBuffer(const PBufWrapper &other);
 };
 
+/// Read-only view of size bytes starting at offset of a pbuf chain. Does not
+/// own the chain.
+struct PBufView {
+  const pbuf *chain = nullptr;
+  DataSize_t offset = 0;
+  DataSize_t size = 0;
+
+  /// Returns a pointer to the data if it doesn't span several pbufs, nullptr
+  /// otherwise
+  const uint8_t *getContiguous() const;
+
+  bool copyInto(uint8_t *buffer, DataSize_t destSize) const;
+};
+
 } // namespace rtps
 
 #endif // RTPS_PBUFWRAPPER_H
@@ -0,0 +1,209 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_STATICHASHINDEX_H
+#define RTPS_STATICHASHINDEX_H
+
+#include "rtps/common/types.h"
+
+#include <array>
+#include <cstdint>
+
+namespace rtps {
+
+inline uint32_t hashBytes(const uint8_t *data, uint32_t length,
+                          uint32_t hash = 2166136261u) {
+  // FNV-1a
+  for (uint32_t i = 0; i < length; ++i) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+inline uint32_t hashKey(const EntityId_t &id) {
+  const uint8_t bytes[4] = {id.entityKey[0], id.entityKey[1], id.entityKey[2],
+                            static_cast<uint8_t>(id.entityKind)};
+  return hashBytes(bytes, sizeof(bytes));
+}
+
+inline uint32_t hashKey(const Guid_t &guid) {
+  return hashKey(guid.entityId) ^
+         hashBytes(guid.prefix.id.data(), guid.prefix.id.size());
+}
+
+inline uint32_t hashKey(const KeyHash_t &key) {
+  return hashBytes(key.value.data(), key.value.size());
+}
+
+inline uint32_t hashKey(const SequenceNumber_t &sn) {
+  // Consecutive numbers end up in consecutive slots, no need to mix
+  return sn.low ^ (static_cast<uint32_t>(sn.high) << 16);
+}
+
+//! Smallest power of two that keeps the load factor at or below one half
+constexpr uint32_t hashIndexCapacity(uint32_t numEntries,
+                                     uint32_t capacity = 1) {
+  return capacity >= 2 * numEntries
+             ? capacity
+             : hashIndexCapacity(numEntries, capacity << 1);
+}
+
+/**
+ * Fixed capacity hash index using open addressing with linear probing. Keys
+ * may be present several times with different values. Removal shifts the
+ * following entries back, so no tombstones accumulate. CAPACITY needs to be
+ * a power of two and should be about twice the number of expected entries.
+ */
+template <typename KEY, typename VALUE, uint32_t CAPACITY>
+class StaticHashIndex {
+  static_assert(CAPACITY != 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                "Capacity needs to be a power of two");
+
+public:
+  //! Adds the pair unless it is already present
+  bool insert(const KEY &key, const VALUE &value) {
+    if (m_numEntries == CAPACITY - 1) {
+      return false; // Keep at least one free slot to terminate probing
+    }
+    uint32_t idx = hashKey(key) & MASK;
+    while (m_entries[idx].used) {
+      if (m_entries[idx].key == key && m_entries[idx].value == value) {
+        return true;
+      }
+      idx = (idx + 1) & MASK;
+    }
+    m_entries[idx].key = key;
+    m_entries[idx].value = value;
+    m_entries[idx].used = true;
+    ++m_numEntries;
+    return true;
+  }
+
+  //! Returns the value of the first entry with the key or a value-initialized
+  //! VALUE if there is none
+  VALUE find(const KEY &key) const {
+    for (uint32_t idx = hashKey(key) & MASK; m_entries[idx].used;
+         idx = (idx + 1) & MASK) {
+      if (m_entries[idx].key == key) {
+        return m_entries[idx].value;
+      }
+    }
+    return VALUE{};
+  }
+
+  //! Calls func(value) for each entry with the key
+  template <typename FUNC> void forEach(const KEY &key, FUNC func) const {
+    for (uint32_t idx = hashKey(key) & MASK; m_entries[idx].used;
+         idx = (idx + 1) & MASK) {
+      if (m_entries[idx].key == key) {
+        func(m_entries[idx].value);
+      }
+    }
+  }
+
+  bool remove(const KEY &key, const VALUE &value) {
+    for (uint32_t idx = hashKey(key) & MASK; m_entries[idx].used;
+         idx = (idx + 1) & MASK) {
+      if (m_entries[idx].key == key && m_entries[idx].value == value) {
+        erase(idx);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //! Removes all entries with the key
+  void removeAll(const KEY &key) {
+    uint32_t idx = hashKey(key) & MASK;
+    while (m_entries[idx].used) {
+      // erase() may move the next entry of the probe sequence into idx
+      if (m_entries[idx].key == key) {
+        erase(idx);
+      } else {
+        idx = (idx + 1) & MASK;
+      }
+    }
+  }
+
+  //! Removes all entries for which pred(key, value) returns true
+  template <typename PRED> void removeIf(PRED pred) {
+    uint32_t idx = 0;
+    while (idx < CAPACITY) {
+      // erase() may move an unchecked entry into idx, so check it again
+      if (m_entries[idx].used &&
+          pred(m_entries[idx].key, m_entries[idx].value)) {
+        erase(idx);
+      } else {
+        ++idx;
+      }
+    }
+  }
+
+  void clear() {
+    for (auto &entry : m_entries) {
+      entry.used = false;
+    }
+    m_numEntries = 0;
+  }
+
+  uint32_t getNumElements() const { return m_numEntries; }
+
+private:
+  static constexpr uint32_t MASK = CAPACITY - 1;
+
+  struct Entry {
+    KEY key;
+    VALUE value;
+    bool used = false;
+  };
+
+  std::array<Entry, CAPACITY> m_entries{};
+  uint32_t m_numEntries = 0;
+
+  void erase(uint32_t hole) {
+    // Backward shift deletion: move entries that would not be found anymore
+    // with the new gap into the hole
+    uint32_t idx = hole;
+    while (true) {
+      idx = (idx + 1) & MASK;
+      if (!m_entries[idx].used) {
+        break;
+      }
+      uint32_t home = hashKey(m_entries[idx].key) & MASK;
+      // Entry can fill the hole if its home is not within (hole, idx]
+      bool homeBetween = (hole < idx) ? (hole < home && home <= idx)
+                                      : (hole < home || home <= idx);
+      if (!homeBetween) {
+        m_entries[hole] = m_entries[idx];
+        hole = idx;
+      }
+    }
+    m_entries[hole].used = false;
+    --m_numEntries;
+  }
+};
+
+} // namespace rtps
+
+#endif // RTPS_STATICHASHINDEX_H
@@ -47,6 +47,11 @@ public:
    * @return true if element was injected. False if no element was present.
    */
   bool moveFirstInto(T &hull);
+  /**
+   * Removes up to n elements from the front into the given hulls.
+   * @return Number of elements that were moved.
+   */
+  uint32_t moveFirstN(T *hulls, uint32_t n);
   bool peakFirst(T &hull);
 
   uint32_t numElements();
@@ -72,6 +72,18 @@ bool ThreadSafeCircularBuffer<T, SIZE>::moveFirstInto(T &hull) {
   }
 }
 
+template <typename T, uint16_t SIZE>
+uint32_t ThreadSafeCircularBuffer<T, SIZE>::moveFirstN(T *hulls, uint32_t n) {
+  Lock lock(m_mutex);
+  uint32_t moved = 0;
+  while (moved < n && m_head != m_tail) {
+    hulls[moved] = std::move(m_buffer[m_tail]);
+    incrementTail();
+    ++moved;
+  }
+  return moved;
+}
+
 template <typename T, uint16_t SIZE>
 bool ThreadSafeCircularBuffer<T, SIZE>::peakFirst(T &hull) {
   Lock lock(m_mutex);
@@ -25,6 +25,8 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #ifndef RTPS_DIAGNOSTICS_H
 #define RTPS_DIAGNOSTICS_H
 
+#include "rtps/config.h"
+
 #include <stdint.h>
 
 namespace rtps {
@@ -41,21 +43,39 @@ extern uint32_t processed_incoming_metatraffic;
 extern uint32_t processed_outgoing_metatraffic;
 extern uint32_t processed_incoming_usertraffic;
 extern uint32_t processed_outgoing_usertraffic;
+extern uint32_t processed_outgoing_control;
+extern uint32_t dropped_outgoing_control;
 
 extern uint32_t max_ever_elements_outgoing_usertraffic_queue;
 extern uint32_t max_ever_elements_incoming_usertraffic_queue;
 
 extern uint32_t max_ever_elements_outgoing_metatraffic_queue;
 extern uint32_t max_ever_elements_incoming_metatraffic_queue;
+
+// Time writer workloads waited for a worker, per priority. Bucket i counts
+// delays below 2^i ms, the last bucket all longer ones.
+const uint8_t QUEUEING_DELAY_BUCKETS = 8;
+extern uint32_t outgoing_queueing_delay_histogram
+    [Config::THREAD_POOL_NUM_PRIORITIES][QUEUEING_DELAY_BUCKETS];
+extern uint32_t
+    max_ever_outgoing_queueing_delay_ms[Config::THREAD_POOL_NUM_PRIORITIES];
 } // namespace ThreadPool
 
 namespace StatefulReader {
 extern uint32_t sfr_unexpected_sn;
 extern uint32_t sfr_retransmit_requests;
+extern uint32_t sfr_buffered_out_of_order;
+extern uint32_t sfr_reorder_buffer_full;
 } // namespace StatefulReader
 
+namespace StatefulWriter {
+extern uint32_t sfw_would_block;
+extern uint32_t sfw_unresponsive_readers;
+} // namespace StatefulWriter
+
 namespace Network {
 extern uint32_t lwip_allocation_failures;
+extern uint32_t rate_limited_sends;
 }
 
 namespace OS {
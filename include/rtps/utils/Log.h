@@ -43,5 +43,8 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #define SFR_VERBOSE 0
 #define SLR_VERBOSE 0
 #define THREAD_POOL_VERBOSE 0
+#define MSG_BATCHER_VERBOSE 0
+#define LINUX_UDP_DRIVER_VERBOSE 0
+#define TIMER_WHEEL_VERBOSE 0
 
 #endif // RTPS_LOG_H
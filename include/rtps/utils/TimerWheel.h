@@ -0,0 +1,112 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_TIMERWHEEL_H
+#define RTPS_TIMERWHEEL_H
+
+#include "lwip/sys.h"
+#include "rtps/config.h"
+#include "rtps/utils/Lock.h"
+
+#include <array>
+
+namespace rtps {
+
+//! One-shot timer that is embedded into its owner and armed via TimerWheel
+class Timer {
+public:
+  using Callback = void (*)(void *arg);
+
+  Timer(Callback callback, void *arg) : m_callback(callback), m_arg(arg) {}
+  Timer(const Timer &) = delete;
+  Timer &operator=(const Timer &) = delete;
+
+  bool isArmed() const { return m_armed; }
+
+private:
+  friend class TimerWheel;
+  Callback m_callback;
+  void *m_arg;
+  uint32_t m_deadline = 0; // sys_now()
+  uint32_t m_tick = 0;     // First tick at or after the deadline
+  Timer *m_prev = nullptr;
+  Timer *m_next = nullptr;
+  bool m_armed = false;
+};
+
+/**
+ * Runs the timers of all endpoints, such as heartbeats and SPDP resends, in a
+ * single thread. Timers are hashed into Config::TIMER_WHEEL_NUM_SLOTS slots of
+ * Config::TIMER_WHEEL_TICK_MS each and the thread sleeps until the earliest
+ * deadline. Callbacks run one after another in the timer thread and should be
+ * short.
+ */
+class TimerWheel {
+public:
+  TimerWheel();
+  ~TimerWheel();
+
+  bool start();
+  //! Returns once the timer thread has exited. Must not be called from a
+  //! callback.
+  void stop();
+
+  //! (Re)arms the timer to fire once in delayMs. May be called from callbacks.
+  void schedule(Timer &timer, uint32_t delayMs);
+
+  //! Disarms the timer and waits for a running callback of it to return, so
+  //! its owner can be destroyed afterwards. Must not be called while holding
+  //! a lock the callback takes.
+  void cancel(Timer &timer);
+
+private:
+  std::array<Timer *, Config::TIMER_WHEEL_NUM_SLOTS> m_slots{};
+  // Protects the slots, held by the timer thread except during callbacks
+  SemaphoreHandle_t m_mutex = nullptr;
+  // Held by the timer thread while running a callback
+  SemaphoreHandle_t m_callbackMutex = nullptr;
+  Timer *m_firing = nullptr; // Expired, callback about to run
+  sys_sem_t m_wakeupSem{};
+  sys_sem_t m_exitSem{}; // Signaled by the timer thread when it exits
+  bool m_running = false;
+  uint32_t m_lastTick = 0; // Last processed tick
+  uint32_t m_nextWakeup = 0;
+  bool m_wakeupScheduled = false;
+
+  static bool isBefore(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) < 0;
+  }
+
+  void link(Timer &timer);
+  void unlink(Timer &timer);
+  void advance();
+  void fire(Timer &timer);
+  uint32_t getSleepTime();
+  static void threadFunction(void *arg);
+  void run();
+};
+
+} // namespace rtps
+
+#endif // RTPS_TIMERWHEEL_H
@@ -26,6 +26,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 
 #include "lwip/tcpip.h"
 #include "rtps/entities/Domain.h"
+#include "rtps/entities/Reader.h"
 #include "rtps/entities/Writer.h"
 #include "rtps/utils/Diagnostics.h"
 #include "rtps/utils/Log.h"
@@ -48,8 +49,13 @@ using rtps::ThreadPool;
 ThreadPool::ThreadPool(receiveJumppad_fp receiveCallback, void *callee)
     : m_receiveJumppad(receiveCallback), m_callee(callee) {
 
-  if (!m_outgoingMetaTraffic.init() || !m_outgoingUserTraffic.init() ||
-      !m_incomingMetaTraffic.init() || !m_incomingUserTraffic.init()) {
+  for (auto &queue : m_outgoing) {
+    if (!queue.init()) {
+      return;
+    }
+  }
+  if (!m_outgoingControl.init() || !m_incomingMetaTraffic.init() ||
+      !m_incomingUserTraffic.init()) {
     return;
   }
   err_t inputErr = sys_sem_new(&m_readerNotificationSem, 0);
@@ -81,10 +87,16 @@ void ThreadPool::updateDiagnostics() {
                    max_ever_elements_incoming_usertraffic_queue,
                m_incomingUserTraffic.numElements());
 
+  uint32_t outgoingUserTraffic = 0;
+  for (uint8_t prio = 0; prio < m_outgoing.size(); ++prio) {
+    if (prio != Config::THREAD_POOL_BUILTIN_WRITER_PRIORITY) {
+      outgoingUserTraffic += m_outgoing[prio].numElements();
+    }
+  }
   rtps::Diagnostics::ThreadPool::max_ever_elements_outgoing_usertraffic_queue =
       std::max(rtps::Diagnostics::ThreadPool::
                    max_ever_elements_outgoing_usertraffic_queue,
-               m_outgoingUserTraffic.numElements());
+               outgoingUserTraffic);
 
   rtps::Diagnostics::ThreadPool::max_ever_elements_incoming_metatraffic_queue =
       std::max(rtps::Diagnostics::ThreadPool::
@@ -94,7 +106,8 @@ void ThreadPool::updateDiagnostics() {
   rtps::Diagnostics::ThreadPool::max_ever_elements_outgoing_metatraffic_queue =
       std::max(rtps::Diagnostics::ThreadPool::
                    max_ever_elements_outgoing_metatraffic_queue,
-               m_outgoingMetaTraffic.numElements());
+               m_outgoing[Config::THREAD_POOL_BUILTIN_WRITER_PRIORITY]
+                   .numElements());
 }
 
 bool ThreadPool::startThreads() {
@@ -105,6 +118,9 @@ bool ThreadPool::startThreads() {
       !sys_sem_valid(&m_writerNotificationSem)) {
     return false;
   }
+  if (!m_timers.start()) {
+    return false;
+  }
 
   m_running = true;
   for (auto &thread : m_writers) {
@@ -125,6 +141,7 @@ bool ThreadPool::startThreads() {
 
 void ThreadPool::stopThreads() {
   m_running = false;
+  m_timers.stop();
   // This should call all the semaphores for each thread once, so they don't
   // stuck before ended.
   for (auto &thread : m_writers) {
@@ -143,21 +160,33 @@ void ThreadPool::stopThreads() {
 }
 
 void ThreadPool::clearQueues() {
-  m_outgoingMetaTraffic.clear();
-  m_outgoingUserTraffic.clear();
+  std::array<Reader *, Config::THREAD_POOL_WRITER_BATCH_SIZE> readers;
+  uint32_t numReaders;
+  while ((numReaders = m_outgoingControl.moveFirstN(readers.data(),
+                                                    readers.size())) != 0) {
+    for (uint32_t i = 0; i < numReaders; ++i) {
+      readers[i]->onWorkloadDequeued();
+    }
+  }
+  std::array<Workload, Config::THREAD_POOL_WRITER_BATCH_SIZE> workloads;
+  for (auto &queue : m_outgoing) {
+    uint32_t num;
+    while ((num = queue.moveFirstN(workloads.data(), workloads.size())) != 0) {
+      for (uint32_t i = 0; i < num; ++i) {
+        workloads[i].writer->onWorkloadDequeued();
+      }
+    }
+  }
   m_incomingMetaTraffic.clear();
   m_incomingUserTraffic.clear();
 }
 
 bool ThreadPool::addWorkload(Writer *workload) {
-  bool res = false;
-  if (workload->isBuiltinEndpoint()) {
-    res = m_outgoingMetaTraffic.moveElementIntoBuffer(std::move(workload));
-  } else {
-    res = m_outgoingUserTraffic.moveElementIntoBuffer(std::move(workload));
-  }
+  Workload element{workload, sys_now()};
+  bool res = m_outgoing[workload->getPriority()].moveElementIntoBuffer(
+      std::move(element));
   if (res) {
-    sys_sem_signal(&m_writerNotificationSem);
+    notify(m_writerNotificationSem, m_writerWakeupPending);
   } else {
 	if(workload->isBuiltinEndpoint()){
 		rtps::Diagnostics::ThreadPool::dropped_outgoing_packets_metatraffic++;
@@ -170,6 +199,17 @@ bool ThreadPool::addWorkload(Writer *workload) {
   return res;
 }
 
+bool ThreadPool::addControlWorkload(Reader *reader) {
+  bool res = m_outgoingControl.moveElementIntoBuffer(std::move(reader));
+  if (res) {
+    notify(m_writerNotificationSem, m_writerWakeupPending);
+  } else {
+    rtps::Diagnostics::ThreadPool::dropped_outgoing_control++;
+    THREAD_POOL_LOG("Failed to enqueue control workload.");
+  }
+  return res;
+}
+
 bool ThreadPool::addBuiltinPort(const Ip4Port_t &port) {
   if (m_builtinPortsIdx == m_builtinPorts.size()) {
     return false;
@@ -204,7 +244,7 @@ bool ThreadPool::addNewPacket(PacketInfo &&packet) {
     res = m_incomingUserTraffic.moveElementIntoBuffer(std::move(packet));
   }
   if (res) {
-    sys_sem_signal(&m_readerNotificationSem);
+    notify(m_readerNotificationSem, m_readerWakeupPending);
   } else {
     THREAD_POOL_LOG("failed to enqueue packet for port %u",
                     static_cast<unsigned int>(packet.destPort));
@@ -212,6 +252,14 @@ bool ThreadPool::addNewPacket(PacketInfo &&packet) {
   return res;
 }
 
+void ThreadPool::notify(sys_sem_t &sem, std::atomic<bool> &wakeupPending) {
+  // Workers reset the flag before draining the queues. Everything enqueued
+  // while it is set is therefore picked up without another signal.
+  if (!wakeupPending.exchange(true)) {
+    sys_sem_signal(&sem);
+  }
+}
+
 void ThreadPool::writerThreadFunction(void *arg) {
   auto pool = static_cast<ThreadPool *>(arg);
   if (pool == nullptr) {
@@ -225,53 +273,114 @@ void ThreadPool::writerThreadFunction(void *arg) {
 }
 
 void ThreadPool::doWriterWork() {
+  std::array<Workload, Config::THREAD_POOL_WRITER_BATCH_SIZE> workloads;
   while (m_running) {
-    Writer *workload_usertraffic = nullptr;
-    bool workload_usertraffic_available = m_outgoingUserTraffic.moveFirstInto(workload_usertraffic);
-    if (workload_usertraffic_available) {
-      workload_usertraffic->progress();
-      Diagnostics::ThreadPool::processed_outgoing_usertraffic++;
-    }
-
-    Writer *workload_metatraffic = nullptr;
-    bool workload_metatraffic_available = m_outgoingMetaTraffic.moveFirstInto(workload_metatraffic);
-    if (workload_metatraffic_available) {
-      workload_metatraffic->progress();
-      Diagnostics::ThreadPool::processed_outgoing_metatraffic++;
-    }
-
-    if (workload_usertraffic_available || workload_metatraffic_available) {
-      continue;
-    } else {
+    m_writerWakeupPending = false;
+
+    const uint32_t numControl = doControlWork();
+    const uint8_t priority = selectPriority();
+    if (priority == Config::THREAD_POOL_NUM_PRIORITIES) {
+      if (numControl != 0) {
+        continue;
+      }
       THREAD_POOL_LOG("WriterWorker | User = %u, Meta = %u\r\n",
                       static_cast<unsigned int>(Diagnostics::ThreadPool::processed_outgoing_usertraffic),
                       static_cast<unsigned int>(Diagnostics::ThreadPool::processed_outgoing_metatraffic));
       updateDiagnostics();
       sys_sem_wait(&m_writerNotificationSem);
+      continue;
+    }
+
+    const uint32_t num = m_outgoing[priority].moveFirstN(workloads.data(),
+                                                         workloads.size());
+    const uint32_t now = sys_now();
+    for (uint32_t i = 0; i < num; ++i) {
+      recordQueueingDelay(priority, now - workloads[i].enqueuedAt);
+      workloads[i].writer->onWorkloadDequeued();
+      workloads[i].writer->progress();
+      if (workloads[i].writer->isBuiltinEndpoint()) {
+        Diagnostics::ThreadPool::processed_outgoing_metatraffic++;
+      } else {
+        Diagnostics::ThreadPool::processed_outgoing_usertraffic++;
+      }
+    }
+    for (uint32_t i = 0; i < num; ++i) {
+      workloads[i].writer->flushBatches();
     }
   }
 }
 
-void ThreadPool::readCallback(void *args, udp_pcb *target, pbuf *pbuf,
-                              const ip_addr_t *addr, Ip4Port_t port) {
-  auto &pool = *static_cast<ThreadPool *>(args);
+uint32_t ThreadPool::doControlWork() {
+  std::array<Reader *, Config::THREAD_POOL_WRITER_BATCH_SIZE> readers;
+  const uint32_t num =
+      m_outgoingControl.moveFirstN(readers.data(), readers.size());
+  for (uint32_t i = 0; i < num; ++i) {
+    readers[i]->onWorkloadDequeued();
+    readers[i]->sendPendingResponses();
+    Diagnostics::ThreadPool::processed_outgoing_control++;
+  }
+  return num;
+}
 
-  PacketInfo packet;
+uint8_t ThreadPool::selectPriority() {
+  // Highest waiting priority, unless a lower one was passed over too often
+  uint8_t selected = Config::THREAD_POOL_NUM_PRIORITIES;
+  for (uint8_t prio = 0; prio < Config::THREAD_POOL_NUM_PRIORITIES; ++prio) {
+    if (m_outgoing[prio].numElements() == 0) {
+      m_skippedRounds[prio] = 0;
+      continue;
+    }
+    if (selected == Config::THREAD_POOL_NUM_PRIORITIES ||
+        (m_skippedRounds[prio] >= Config::THREAD_POOL_PRIORITY_AGING_ROUNDS &&
+         m_skippedRounds[selected] <
+             Config::THREAD_POOL_PRIORITY_AGING_ROUNDS)) {
+      selected = prio;
+    }
+  }
 
-  // TODO This is a workaround for chained pbufs caused by hardware limitations,
-  // not a general fix
-  if (pbuf->next != nullptr) {
-    struct pbuf *test = pbuf_alloc(PBUF_RAW, pbuf->tot_len, PBUF_POOL);
-    pbuf_copy(test, pbuf);
-    pbuf_free(pbuf);
-    pbuf = test;
+  for (uint8_t prio = 0; prio < Config::THREAD_POOL_NUM_PRIORITIES; ++prio) {
+    if (prio == selected) {
+      m_skippedRounds[prio] = 0;
+    } else if (m_skippedRounds[prio] <
+                   Config::THREAD_POOL_PRIORITY_AGING_ROUNDS &&
+               m_outgoing[prio].numElements() != 0) {
+      ++m_skippedRounds[prio];
+    }
   }
+  return selected;
+}
+
+void ThreadPool::recordQueueingDelay(uint8_t priority, uint32_t delayMs) {
+  uint8_t bucket = 0;
+  while (bucket < Diagnostics::ThreadPool::QUEUEING_DELAY_BUCKETS - 1 &&
+         delayMs >= (1u << bucket)) {
+    ++bucket;
+  }
+  Diagnostics::ThreadPool::outgoing_queueing_delay_histogram[priority]
+                                                            [bucket]++;
+  Diagnostics::ThreadPool::max_ever_outgoing_queueing_delay_ms[priority] =
+      std::max(
+          Diagnostics::ThreadPool::max_ever_outgoing_queueing_delay_ms[priority],
+          delayMs);
+}
+
+void ThreadPool::readCallback(void *args, udp_pcb *target, pbuf *pbuf,
+                              const ip_addr_t *addr, Ip4Port_t port) {
+  PacketInfo packet;
 
+  // Chained pbufs are processed in place, see MessageProcessingInfo
   packet.destAddr = {0}; // not relevant
   packet.destPort = target->local_port;
   packet.srcPort = port;
   packet.buffer = PBufWrapper{pbuf};
 
+  packetCallback(args, packet);
+}
+
+void ThreadPool::packetCallback(void *args, PacketInfo &packet) {
+  auto &pool = *static_cast<ThreadPool *>(args);
+  const Ip4Port_t port = packet.srcPort;
+
   if (!pool.addNewPacket(std::move(packet))) {
     THREAD_POOL_LOG("ThreadPool: dropped packet\n");
     if (pool.isBuiltinPort(port)) {
@@ -294,29 +403,38 @@ void ThreadPool::readerThreadFunction(void *arg) {
 }
 
 void ThreadPool::doReaderWork() {
-  uint32_t metatraffic = 0;
-  uint32_t usertraffic = 0;
   while (m_running) {
-    PacketInfo packet_user;
-    auto isUserWorkToDo = m_incomingUserTraffic.moveFirstInto(packet_user);
-    if (isUserWorkToDo) {
+    m_readerWakeupPending = false;
+
+    // Scoped to the iteration so the pbufs are released after processing
+    std::array<PacketInfo, Config::THREAD_POOL_READER_BATCH_SIZE> packets_user;
+    std::array<PacketInfo, Config::THREAD_POOL_READER_BATCH_SIZE> packets_meta;
+
+    uint32_t num_user = m_incomingUserTraffic.moveFirstN(packets_user.data(),
+                                                         packets_user.size());
+    for (uint32_t i = 0; i < num_user; ++i) {
       Diagnostics::ThreadPool::processed_incoming_usertraffic++;
-      m_receiveJumppad(m_callee, const_cast<const PacketInfo &>(packet_user));
+      m_receiveJumppad(m_callee,
+                       const_cast<const PacketInfo &>(packets_user[i]));
     }
 
-    PacketInfo packet_meta;
-    auto isMetaWorkToDo = m_incomingMetaTraffic.moveFirstInto(packet_meta);
-    if (isMetaWorkToDo) {
+    uint32_t num_meta = m_incomingMetaTraffic.moveFirstN(packets_meta.data(),
+                                                         packets_meta.size());
+    for (uint32_t i = 0; i < num_meta; ++i) {
       Diagnostics::ThreadPool::processed_incoming_metatraffic++;
-      m_receiveJumppad(m_callee, const_cast<const PacketInfo &>(packet_meta));
+      m_receiveJumppad(m_callee,
+                       const_cast<const PacketInfo &>(packets_meta[i]));
     }
 
-    if (isUserWorkToDo || isMetaWorkToDo) {
+    if (num_user != 0 || num_meta != 0) {
       continue;
     }
-    THREAD_POOL_LOG("ReaderWorker | User = %u, Meta = %u\r\n",
-                    static_cast<unsigned int>(usertraffic),
-                    static_cast<unsigned int>(metatraffic));
+    THREAD_POOL_LOG(
+        "ReaderWorker | User = %u, Meta = %u\r\n",
+        static_cast<unsigned int>(
+            Diagnostics::ThreadPool::processed_incoming_usertraffic),
+        static_cast<unsigned int>(
+            Diagnostics::ThreadPool::processed_incoming_metatraffic));
     updateDiagnostics();
     sys_sem_wait(&m_readerNotificationSem);
   }
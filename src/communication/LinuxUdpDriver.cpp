@@ -0,0 +1,394 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#if defined(__linux__)
+
+#include "rtps/communication/LinuxUdpDriver.h"
+#include "rtps/utils/Log.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+using rtps::LinuxUdpDriver;
+
+#if LINUX_UDP_DRIVER_VERBOSE && RTPS_GLOBAL_VERBOSE
+#include "rtps/utils/printutils.h"
+#define LINUX_UDP_DRIVER_LOG(...)                                              \
+  if (true) {                                                                  \
+    printf("[Linux UDP Driver] ");                                             \
+    printf(__VA_ARGS__);                                                       \
+    printf("\r\n");                                                            \
+  }
+#else
+#define LINUX_UDP_DRIVER_LOG(...) //
+#endif
+
+LinuxUdpDriver::LinuxUdpDriver(rxFunc_fp callback, void *args)
+    : m_rxCallback(callback), m_callbackArgs(args) {
+  m_rxThread = std::thread(&LinuxUdpDriver::receiveLoop, this);
+  m_txThread = std::thread(&LinuxUdpDriver::sendLoop, this);
+}
+
+LinuxUdpDriver::~LinuxUdpDriver() {
+  flush();
+  m_running = false;
+  m_txCondition.notify_all();
+  m_txThread.join();
+  m_rxThread.join();
+
+  for (std::size_t i = 0; i < m_numTxPending; ++i) {
+    pbuf_free(m_txPending[i].buffer);
+  }
+  for (auto &buffer : m_rxBuffers) {
+    if (buffer != nullptr) {
+      pbuf_free(buffer);
+    }
+  }
+  for (std::size_t i = 0; i < m_numConns; ++i) {
+    close(m_conns[i].fd);
+  }
+}
+
+bool LinuxUdpDriver::createUdpConnection(Ip4Port_t receivePort) {
+  std::lock_guard<std::mutex> lock(m_connMutex);
+  return getSocketLocked(receivePort) >= 0;
+}
+
+int LinuxUdpDriver::getSocketLocked(Ip4Port_t port) {
+  for (std::size_t i = 0; i < m_numConns; ++i) {
+    if (m_conns[i].port == port) {
+      return m_conns[i].fd;
+    }
+  }
+
+  if (m_numConns == m_conns.size()) {
+    return -1;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    LINUX_UDP_DRIVER_LOG("Failed to create socket for port %u: %i", port,
+                         errno);
+    return -1;
+  }
+
+  // Several participants on the same host share the multicast ports
+  int enable = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+  sockaddr_in local{};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  local.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0) {
+    LINUX_UDP_DRIVER_LOG("Failed to bind port %u: %i", port, errno);
+    close(fd);
+    return -1;
+  }
+
+  for (std::size_t i = 0; i < m_numGroups; ++i) {
+    joinGroup(fd, m_groups[i]);
+  }
+
+  m_conns[m_numConns].fd = fd;
+  m_conns[m_numConns].port = port;
+  m_numConns++;
+
+  LINUX_UDP_DRIVER_LOG("Successfully created UDP connection on port %u", port);
+  return fd;
+}
+
+bool LinuxUdpDriver::joinGroup(int fd, ip4_addr_t addr) {
+  ip_mreq request{};
+  request.imr_multiaddr.s_addr = addr.addr; // Both in network byte order
+  request.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request,
+                 sizeof(request)) != 0 &&
+      errno != EADDRINUSE) {
+    LINUX_UDP_DRIVER_LOG("Failed to join multicast group: %i", errno);
+    return false;
+  }
+  return true;
+}
+
+bool LinuxUdpDriver::joinMultiCastGroup(ip4_addr_t addr) {
+  std::lock_guard<std::mutex> lock(m_connMutex);
+
+  bool known = false;
+  for (std::size_t i = 0; i < m_numGroups; ++i) {
+    known = known || m_groups[i].addr == addr.addr;
+  }
+  if (!known) {
+    if (m_numGroups == m_groups.size()) {
+      return false;
+    }
+    m_groups[m_numGroups++] = addr;
+  }
+
+  // Sockets created later join in getSocketLocked
+  bool success = true;
+  for (std::size_t i = 0; i < m_numConns; ++i) {
+    success = joinGroup(m_conns[i].fd, addr) && success;
+  }
+  return success;
+}
+
+void LinuxUdpDriver::receiveLoop() {
+  std::array<pollfd, Config::MAX_NUM_UDP_CONNECTIONS> fds;
+  std::array<Connection, Config::MAX_NUM_UDP_CONNECTIONS> conns;
+
+  while (m_running) {
+    std::size_t numConns;
+    {
+      std::lock_guard<std::mutex> lock(m_connMutex);
+      numConns = m_numConns;
+      for (std::size_t i = 0; i < numConns; ++i) {
+        conns[i] = m_conns[i];
+        fds[i].fd = m_conns[i].fd;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+      }
+    }
+
+    if (numConns == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+      continue;
+    }
+
+    // The timeout lets new connections and stop requests take effect
+    if (poll(fds.data(), numConns, POLL_TIMEOUT_MS) <= 0) {
+      continue;
+    }
+
+    for (std::size_t i = 0; i < numConns; ++i) {
+      if (fds[i].revents & POLLIN) {
+        receiveBatch(conns[i]);
+      }
+    }
+  }
+}
+
+void LinuxUdpDriver::receiveBatch(const Connection &conn) {
+  // Replace the buffers that were handed out during the last batch
+  unsigned int count = 0;
+  for (uint16_t slot = 0; slot < m_rxBuffers.size(); ++slot) {
+    if (m_rxBuffers[slot] == nullptr) {
+      m_rxBuffers[slot] = pbuf_alloc(PBUF_RAW, RX_BUFFER_SIZE, PBUF_RAM);
+      if (m_rxBuffers[slot] == nullptr) {
+        continue;
+      }
+    }
+    m_rxIov[count].iov_base = m_rxBuffers[slot]->payload;
+    m_rxIov[count].iov_len = RX_BUFFER_SIZE;
+    m_rxMsgs[count].msg_hdr = {};
+    m_rxMsgs[count].msg_hdr.msg_name = &m_rxSources[count];
+    m_rxMsgs[count].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    m_rxMsgs[count].msg_hdr.msg_iov = &m_rxIov[count];
+    m_rxMsgs[count].msg_hdr.msg_iovlen = 1;
+    m_rxMsgs[count].msg_len = 0;
+    m_rxSlots[count] = slot;
+    ++count;
+  }
+
+  if (count == 0) {
+    LINUX_UDP_DRIVER_LOG("No receive buffers available");
+    return;
+  }
+
+  int received =
+      recvmmsg(conn.fd, m_rxMsgs.data(), count, MSG_DONTWAIT, nullptr);
+  if (received <= 0) {
+    return;
+  }
+
+  for (int i = 0; i < received; ++i) {
+    const mmsghdr &msg = m_rxMsgs[i];
+    if (msg.msg_len == 0 || (msg.msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+      LINUX_UDP_DRIVER_LOG("Dropped packet of invalid size on port %u",
+                           conn.port);
+      continue; // Buffer stays in the ring
+    }
+
+    pbuf *buffer = m_rxBuffers[m_rxSlots[i]];
+    m_rxBuffers[m_rxSlots[i]] = nullptr;
+    pbuf_realloc(buffer, static_cast<u16_t>(msg.msg_len));
+
+    PacketInfo packet;
+    packet.destAddr = {0}; // not relevant
+    packet.destPort = conn.port;
+    packet.srcPort = ntohs(m_rxSources[i].sin_port);
+    packet.buffer = PBufWrapper{buffer};
+    m_rxCallback(m_callbackArgs, packet);
+  }
+}
+
+void LinuxUdpDriver::sendPacket(PacketInfo &packet) {
+  if (!packet.buffer.isValid()) {
+    return;
+  }
+
+  int fd;
+  {
+    std::lock_guard<std::mutex> lock(m_connMutex);
+    fd = getSocketLocked(packet.srcPort);
+  }
+  if (fd < 0) {
+    LINUX_UDP_DRIVER_LOG("Failed to create connection on port %u",
+                         packet.srcPort);
+    return;
+  }
+
+  // The caller keeps ownership of its reference
+  pbuf_ref(packet.buffer.firstElement);
+
+  std::unique_lock<std::mutex> lock(m_txMutex);
+  if (m_numTxPending == m_txPending.size()) {
+    sendPending(lock);
+  }
+  TxEntry &entry = m_txPending[m_numTxPending++];
+  entry.fd = fd;
+  entry.dest = {};
+  entry.dest.sin_family = AF_INET;
+  entry.dest.sin_addr.s_addr = packet.destAddr.addr;
+  entry.dest.sin_port = htons(packet.destPort);
+  entry.buffer = packet.buffer.firstElement;
+  lock.unlock();
+  m_txCondition.notify_all();
+}
+
+void LinuxUdpDriver::flush() {
+  std::unique_lock<std::mutex> lock(m_txMutex);
+  sendPending(lock);
+}
+
+void LinuxUdpDriver::sendLoop() {
+  std::unique_lock<std::mutex> lock(m_txMutex);
+  while (m_running) {
+    m_txCondition.wait(lock,
+                       [this] { return !m_running || m_numTxPending != 0; });
+    sendPending(lock);
+  }
+}
+
+void LinuxUdpDriver::sendPending(std::unique_lock<std::mutex> &lock) {
+  // Only one batch is in flight at a time to preserve the packet order
+  m_txCondition.wait(lock, [this] { return !m_txInProgress; });
+  if (m_numTxPending == 0) {
+    return;
+  }
+
+  const std::size_t count = m_numTxPending;
+  for (std::size_t i = 0; i < count; ++i) {
+    m_txBatch[i] = m_txPending[i];
+  }
+  m_numTxPending = 0;
+  m_txInProgress = true;
+
+  lock.unlock();
+  sendBatch(count);
+  lock.lock();
+
+  m_txInProgress = false;
+  m_txCondition.notify_all();
+}
+
+bool LinuxUdpDriver::prepareMessage(TxEntry &entry, mmsghdr &msg,
+                                    std::array<iovec, MAX_IOV_PER_PACKET> &iov) {
+  uint8_t numIov = 0;
+  for (pbuf *q = entry.buffer; q != nullptr; q = q->next) {
+    numIov += (q->len != 0) ? 1 : 0;
+  }
+
+  if (MAX_IOV_PER_PACKET < numIov) {
+    pbuf *flat = pbuf_alloc(PBUF_RAW, entry.buffer->tot_len, PBUF_RAM);
+    if (flat == nullptr || pbuf_copy(flat, entry.buffer) != ERR_OK) {
+      if (flat != nullptr) {
+        pbuf_free(flat);
+      }
+      return false;
+    }
+    pbuf_free(entry.buffer);
+    entry.buffer = flat;
+  }
+
+  numIov = 0;
+  for (pbuf *q = entry.buffer; q != nullptr; q = q->next) {
+    if (q->len != 0) {
+      iov[numIov].iov_base = q->payload;
+      iov[numIov].iov_len = q->len;
+      ++numIov;
+    }
+  }
+
+  msg.msg_hdr = {};
+  msg.msg_hdr.msg_name = &entry.dest;
+  msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+  msg.msg_hdr.msg_iov = iov.data();
+  msg.msg_hdr.msg_iovlen = numIov;
+  msg.msg_len = 0;
+  return true;
+}
+
+void LinuxUdpDriver::sendBatch(std::size_t count) {
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!prepareMessage(m_txBatch[i], m_txMsgs[i], m_txIov[i])) {
+      LINUX_UDP_DRIVER_LOG("Failed to flatten packet, dropping it");
+      m_txBatch[i].fd = -1;
+    }
+  }
+
+  // sendmmsg works on a single socket, so send runs of the same source port
+  std::size_t start = 0;
+  while (start < count) {
+    const int fd = m_txBatch[start].fd;
+    std::size_t end = start;
+    while (end < count && m_txBatch[end].fd == fd) {
+      ++end;
+    }
+
+    std::size_t sent = start;
+    while (fd >= 0 && sent < end) {
+      int res = sendmmsg(fd, &m_txMsgs[sent], end - sent, 0);
+      if (res < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LINUX_UDP_DRIVER_LOG("UDP TRANSMIT NOT SUCCESSFUL err: %i", errno);
+        ++sent; // Skip the packet that caused the error
+      } else {
+        sent += res;
+      }
+    }
+    start = end;
+  }
+
+  for (std::size_t i = 0; i < count; ++i) {
+    pbuf_free(m_txBatch[i].buffer);
+    m_txBatch[i].buffer = nullptr;
+  }
+}
+
+#endif // defined(__linux__)
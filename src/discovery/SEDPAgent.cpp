@@ -88,6 +88,11 @@ void SEDPAgent::jumppadSubscriptionReader(
 
 void SEDPAgent::handlePublisherReaderMessage(const ReaderCacheChange &change) {
   Lock lock{m_mutex};
+  // The key hash identifies the endpoint, no need to parse the payload
+  if (change.kind != ChangeKind_t::ALIVE) {
+    handleRemoteEndpointDeletion(change);
+    return;
+  }
 #if SEDP_VERBOSE
   SEDP_LOG("New publisher\n");
 #endif
@@ -193,8 +198,12 @@ void SEDPAgent::handlePublisherReaderMessage(const TopicData &writerData,
 #if SEDP_VERBOSE
   SEDP_LOG("PUB T/D %s/%s", writerData.topicName, writerData.typeName);
 #endif
-  Reader *reader = m_part->getMatchingReader(writerData);
-  if (reader == nullptr) {
+  // Every local reader of the topic receives the samples of the writer
+  const uint32_t numMatched = m_part->addWriterProxyToMatchingReaders(
+      writerData,
+      WriterProxy{writerData.endpointGuid, writerData.unicastLocator,
+                  (writerData.reliabilityKind == ReliabilityKind_t::RELIABLE)});
+  if (numMatched == 0) {
 #if SEDP_VERBOSE
     SEDP_LOG("SEDPAgent: Couldn't find reader for new Publisher[%s, %s] \n",
              writerData.topicName, writerData.typeName);
@@ -212,9 +221,6 @@ void SEDPAgent::handlePublisherReaderMessage(const TopicData &writerData,
   }
   SEDP_LOG("publisher\n");
 #endif
-  reader->addNewMatchedWriter(
-      WriterProxy{writerData.endpointGuid, writerData.unicastLocator,
-                  (writerData.reliabilityKind == ReliabilityKind_t::RELIABLE)});
   if (mfp_onNewPublisherCallback != nullptr) {
     mfp_onNewPublisherCallback(m_onNewPublisherArgs);
   }
@@ -223,6 +229,11 @@ void SEDPAgent::handlePublisherReaderMessage(const TopicData &writerData,
 void SEDPAgent::handleSubscriptionReaderMessage(
     const ReaderCacheChange &change) {
   Lock lock{m_mutex};
+  // The key hash identifies the endpoint, no need to parse the payload
+  if (change.kind != ChangeKind_t::ALIVE) {
+    handleRemoteEndpointDeletion(change);
+    return;
+  }
 #if SEDP_VERBOSE
   SEDP_LOG("New subscriber\n");
 #endif
@@ -255,7 +266,25 @@ void SEDPAgent::handleRemoteEndpointDeletion(const TopicData &topic,
   Guid_t guid;
   guid.prefix = topic.endpointGuid.prefix;
   guid.entityId = topic.entityIdFromKeyHash;
+  removeRemoteEndpoint(guid);
+}
+
+void SEDPAgent::handleRemoteEndpointDeletion(const ReaderCacheChange &change) {
+  if (!change.inlineQos.hasKeyHash) {
+    return;
+  }
+  const Guid_t guid = change.inlineQos.getGuidFromKeyHash();
+  SEDP_LOG("Endpoint %s message SN %u.%u\r\n",
+           change.kind == ChangeKind_t::NOT_ALIVE_DISPOSED ? "disposal"
+                                                           : "unregistration",
+           (int)change.sn.high, (int)change.sn.low);
+  if (!m_part->findRemoteParticipant(guid.prefix)) {
+    return;
+  }
+  removeRemoteEndpoint(guid);
+}
 
+void SEDPAgent::removeRemoteEndpoint(const Guid_t &guid) {
   // Remove entity ID from all proxies of local endpoints
   m_part->removeProxyFromAllEndpoints(guid);
 
@@ -297,17 +326,16 @@ void SEDPAgent::handleSubscriptionReaderMessage(
   }
   SEDP_LOG("Subscriber\n");
 #endif
+  const bool reliable =
+      readerData.reliabilityKind == ReliabilityKind_t::RELIABLE;
+  ReaderProxy proxy{readerData.endpointGuid, readerData.unicastLocator,
+                    reliable};
   if (readerData.multicastLocator.kind ==
       rtps::LocatorKind_t::LOCATOR_KIND_UDPv4) {
-    writer->addNewMatchedReader(ReaderProxy{
-        readerData.endpointGuid, readerData.unicastLocator,
-        readerData.multicastLocator,
-        (readerData.reliabilityKind == ReliabilityKind_t::RELIABLE)});
-  } else {
-    writer->addNewMatchedReader(ReaderProxy{
-        readerData.endpointGuid, readerData.unicastLocator,
-        (readerData.reliabilityKind == ReliabilityKind_t::RELIABLE)});
+    proxy.remoteMulticastLocator = readerData.multicastLocator;
   }
+  proxy.durabilityKind = readerData.durabilityKind;
+  writer->addNewMatchedReader(proxy);
 
   if (mfp_onNewSubscriberCallback != nullptr) {
     mfp_onNewSubscriberCallback(m_onNewSubscriberArgs);
@@ -319,19 +347,20 @@ void SEDPAgent::tryMatchUnmatchedEndpoints() {
   for (auto &proxy : m_unmatchedRemoteReaders) {
     auto writer = m_part->getMatchingWriter(proxy);
     if (writer != nullptr) {
-      writer->addNewMatchedReader(
-          ReaderProxy{proxy.endpointGuid, proxy.unicastLocator,
-                      proxy.multicastLocator, proxy.is_reliable});
+      ReaderProxy readerProxy{proxy.endpointGuid, proxy.unicastLocator,
+                              proxy.multicastLocator, proxy.is_reliable};
+      readerProxy.durabilityKind = proxy.durabilityKind;
+      writer->addNewMatchedReader(readerProxy);
       removeUnmatchedEntity(proxy.endpointGuid);
     }
   }
 
   // Try to match remote writers with local readers
   for (auto &proxy : m_unmatchedRemoteWriters) {
-    auto reader = m_part->getMatchingReader(proxy);
-    if (reader != nullptr) {
-      reader->addNewMatchedWriter(WriterProxy{
-          proxy.endpointGuid, proxy.unicastLocator, proxy.is_reliable});
+    const uint32_t numMatched = m_part->addWriterProxyToMatchingReaders(
+        proxy, WriterProxy{proxy.endpointGuid, proxy.unicastLocator,
+                           proxy.is_reliable});
+    if (numMatched != 0) {
       removeUnmatchedEntity(proxy.endpointGuid);
     }
   }
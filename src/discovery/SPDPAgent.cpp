@@ -52,37 +52,37 @@ void SPDPAgent::init(Participant &participant, BuiltInEndpoints &endpoints) {
   initialized = true;
 }
 
-void SPDPAgent::start() {
-  if (m_running) {
+void SPDPAgent::start(TimerWheel &timers) {
+  if (mp_timers != nullptr) {
     return;
   }
-  m_running = true;
-  auto t =
-      sys_thread_new("SPDPThread", runBroadcast, this,
-                     Config::SPDP_WRITER_STACKSIZE, Config::SPDP_WRITER_PRIO);
+  mp_timers = &timers;
+  const DataSize_t size = ucdr_buffer_length(&m_microbuffer);
+  m_buildInEndpoints.spdpWriter->newChange(ChangeKind_t::ALIVE,
+                                           m_microbuffer.init, size);
+  mp_timers->schedule(m_resendTimer, Config::SPDP_RESEND_PERIOD_MS);
 }
 
-void SPDPAgent::stop() { m_running = false; }
+void SPDPAgent::stop() {
+  if (mp_timers != nullptr) {
+    mp_timers->cancel(m_resendTimer);
+    mp_timers = nullptr;
+  }
+}
 
-void SPDPAgent::runBroadcast(void *args) {
-  SPDPAgent &agent = *static_cast<SPDPAgent *>(args);
-  const DataSize_t size = ucdr_buffer_length(&agent.m_microbuffer);
-  agent.m_buildInEndpoints.spdpWriter->newChange(
-      ChangeKind_t::ALIVE, agent.m_microbuffer.init, size);
-  while (agent.m_running) {
-#ifdef OS_IS_FREERTOS
-    vTaskDelay(pdMS_TO_TICKS(Config::SPDP_RESEND_PERIOD_MS));
-#else
-    sys_msleep(Config::SPDP_RESEND_PERIOD_MS);
-#endif
-    agent.m_buildInEndpoints.spdpWriter->setAllChangesToUnsent();
-    if (agent.m_cycleHB == Config::SPDP_CYCLECOUNT_HEARTBEAT) {
-      agent.m_cycleHB = 0;
-      agent.mp_participant->checkAndResetHeartbeats();
-    } else {
-      agent.m_cycleHB++;
-    }
+void SPDPAgent::resendTimerJumppad(void *thisPointer) {
+  static_cast<SPDPAgent *>(thisPointer)->resend();
+}
+
+void SPDPAgent::resend() {
+  m_buildInEndpoints.spdpWriter->setAllChangesToUnsent();
+  if (m_cycleHB == Config::SPDP_CYCLECOUNT_HEARTBEAT) {
+    m_cycleHB = 0;
+    mp_participant->checkAndResetHeartbeats();
+  } else {
+    m_cycleHB++;
   }
+  mp_timers->schedule(m_resendTimer, Config::SPDP_RESEND_PERIOD_MS);
 }
 
 void SPDPAgent::receiveCallback(void *callee,
@@ -121,8 +121,11 @@ void SPDPAgent::handleSPDPPackage(const ReaderCacheChange &cacheChange) {
     } else {
       SPDP_LOG("ParticipantProxyData deserializtaion failed\n");
     }
-  } else {
-    // TODO RemoveParticipant
+  } else if (cacheChange.inlineQos.hasKeyHash) {
+    // The key hash of the participant data is the participant's GUID
+    const Guid_t guid = cacheChange.inlineQos.getGuidFromKeyHash();
+    SPDP_LOG("Remote participant left\n");
+    mp_participant->removeRemoteParticipant(guid.prefix);
   }
 }
 
@@ -199,18 +202,20 @@ bool SPDPAgent::addProxiesForBuiltInEndpoints() {
 #endif
 
   if (m_proxyDataBuffer.hasPublicationReader()) {
-    const ReaderProxy proxy{{m_proxyDataBuffer.m_guid.prefix,
-                             ENTITYID_SEDP_BUILTIN_PUBLICATIONS_READER},
-                            *locator,
-                            true};
+    ReaderProxy proxy{{m_proxyDataBuffer.m_guid.prefix,
+                       ENTITYID_SEDP_BUILTIN_PUBLICATIONS_READER},
+                      *locator,
+                      true};
+    proxy.durabilityKind = DurabilityKind_t::TRANSIENT_LOCAL;
     m_buildInEndpoints.sedpPubWriter->addNewMatchedReader(proxy);
   }
 
   if (m_proxyDataBuffer.hasSubscriptionReader()) {
-    const ReaderProxy proxy{{m_proxyDataBuffer.m_guid.prefix,
-                             ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_READER},
-                            *locator,
-                            true};
+    ReaderProxy proxy{{m_proxyDataBuffer.m_guid.prefix,
+                       ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_READER},
+                      *locator,
+                      true};
+    proxy.durabilityKind = DurabilityKind_t::TRANSIENT_LOCAL;
     m_buildInEndpoints.sedpSubWriter->addNewMatchedReader(proxy);
   }
 
@@ -219,7 +224,8 @@ bool SPDPAgent::addProxiesForBuiltInEndpoints() {
                              ENTITYID_SEDP_BUILTIN_PUBLICATIONS_WRITER},
                             *locator,
                             true};
-    m_buildInEndpoints.sedpPubReader->addNewMatchedWriter(proxy);
+    mp_participant->addWriterProxyToReader(*m_buildInEndpoints.sedpPubReader,
+                                           proxy);
     m_buildInEndpoints.sedpPubReader->sendPreemptiveAckNack(proxy);
   }
 
@@ -228,7 +234,8 @@ bool SPDPAgent::addProxiesForBuiltInEndpoints() {
                              ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_WRITER},
                             *locator,
                             true};
-    m_buildInEndpoints.sedpSubReader->addNewMatchedWriter(proxy);
+    mp_participant->addWriterProxyToReader(*m_buildInEndpoints.sedpSubReader,
+                                           proxy);
     m_buildInEndpoints.sedpPubReader->sendPreemptiveAckNack(proxy);
   }
 
@@ -48,6 +48,7 @@ bool TopicData::readFromUcdrBuffer(ucdrBuffer &buffer) {
   // Reset valid flags, as the respective parameters are optional
   statusInfoValid = false;
   entityIdFromKeyHashValid = false;
+  durabilityKind = DurabilityKind_t::VOLATILE;
 
   while (ucdr_buffer_remaining(&buffer) >= 4) {
     if (ucdr_buffer_has_error(&buffer)) {
@@ -81,6 +82,10 @@ bool TopicData::readFromUcdrBuffer(ucdrBuffer &buffer) {
       buffer.iterator += 8;
       // TODO Skip 8 bytes. don't know what they are yet
       break;
+    case ParameterId::PID_DURABILITY:
+      ucdr_deserialize_uint32_t(&buffer,
+                                reinterpret_cast<uint32_t *>(&durabilityKind));
+      break;
     case ParameterId::PID_SENTINEL:
       return true;
     case ParameterId::PID_TOPIC_NAME:
@@ -58,7 +58,7 @@ bool Domain::completeInit() {
   }
 
   for (auto i = 0; i < m_nextParticipantId; i++) {
-    m_participants[i].getSPDPAgent().start();
+    m_participants[i].getSPDPAgent().start(m_threadPool.getTimerWheel());
   }
   return m_initComplete;
 }
@@ -71,19 +71,11 @@ void Domain::receiveJumppad(void *callee, const PacketInfo &packet) {
 }
 
 void Domain::receiveCallback(const PacketInfo &packet) {
-  if (packet.buffer.firstElement->next != nullptr) {
-
-    DOMAIN_LOG("Cannot handle multiple elements chained. You might "
-               "want to increase PBUF_POOL_BUFSIZE\n");
-  }
-
   if (isMetaMultiCastPort(packet.destPort)) {
     // Pass to all
     DOMAIN_LOG("Domain: Multicast to port %u\n", packet.destPort);
     for (auto i = 0; i < m_nextParticipantId - PARTICIPANT_START_ID; ++i) {
-      m_participants[i].newMessage(
-          static_cast<uint8_t *>(packet.buffer.firstElement->payload),
-          packet.buffer.firstElement->len);
+      m_participants[i].newMessage(packet.buffer.firstElement);
     }
     // First Check if UserTraffic Multicast
   } else if (isUserMultiCastPort(packet.destPort)) {
@@ -94,9 +86,7 @@ void Domain::receiveCallback(const PacketInfo &packet) {
     for (auto i = 0; i < m_nextParticipantId - PARTICIPANT_START_ID; ++i) {
       if (m_participants[i].hasReaderWithMulticastLocator(packet.destAddr)) {
         DOMAIN_LOG("Domain: Forward Multicast only to Participant: %u\n", i);
-        m_participants[i].newMessage(
-            static_cast<uint8_t *>(packet.buffer.firstElement->payload),
-            packet.buffer.firstElement->len);
+        m_participants[i].newMessage(packet.buffer.firstElement);
       }
     }
   } else {
@@ -109,8 +99,7 @@ void Domain::receiveCallback(const PacketInfo &packet) {
           id >= PARTICIPANT_START_ID) { // added extra check to avoid segfault
                                         // (id below START_ID)
         m_participants[id - PARTICIPANT_START_ID].newMessage(
-            static_cast<uint8_t *>(packet.buffer.firstElement->payload),
-            packet.buffer.firstElement->len);
+            packet.buffer.firstElement);
       } else {
         DOMAIN_LOG("Domain: Participant id too high or unplausible.\n");
       }
@@ -188,14 +177,14 @@ void Domain::createBuiltinWritersAndReaders(Participant &part) {
           m_statefulReaders);
   sedpAttributes.endpointGuid.entityId =
       ENTITYID_SEDP_BUILTIN_PUBLICATIONS_READER;
-  sedpPubReader->init(sedpAttributes, m_transport);
+  sedpPubReader->init(sedpAttributes, m_transport, &m_threadPool);
 
   StatefulReader *sedpSubReader =
       getNextUnusedEndpoint<decltype(m_statefulReaders), StatefulReader>(
           m_statefulReaders);
   sedpAttributes.endpointGuid.entityId =
       ENTITYID_SEDP_BUILTIN_SUBSCRIPTIONS_READER;
-  sedpSubReader->init(sedpAttributes, m_transport);
+  sedpSubReader->init(sedpAttributes, m_transport, &m_threadPool);
 
   // WRITER
   StatefulWriter *sedpPubWriter =
@@ -329,7 +318,7 @@ rtps::Writer *Domain::writerExists(Participant &part, const char *topicName,
 
 rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
                                    const char *typeName, bool reliable,
-                                   bool enforceUnicast) {
+                                   bool enforceUnicast, TopicKind_t topicKind) {
   Lock lock{m_mutex};
   StatelessWriter *statelessWriter =
       getNextUnusedEndpoint<decltype(m_statelessWriters), StatelessWriter>(
@@ -347,7 +336,6 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
     return nullptr;
   }
 
-  // TODO Distinguish WithKey and NoKey (Also changes EntityKind)
   TopicData attributes;
 
   if (strlen(topicName) > Config::MAX_TOPICNAME_LENGTH ||
@@ -359,7 +347,9 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
   attributes.endpointGuid.prefix = part.m_guidPrefix;
   attributes.endpointGuid.entityId = {
       part.getNextUserEntityKey(),
-      EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY};
+      topicKind == TopicKind_t::WITH_KEY
+          ? EntityKind_t::USER_DEFINED_WRITER_WITH_KEY
+          : EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY};
   attributes.unicastLocator = getUserUnicastLocator(part.m_participantId);
   attributes.durabilityKind = DurabilityKind_t::TRANSIENT_LOCAL;
 
@@ -368,8 +358,8 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
   if (reliable) {
     attributes.reliabilityKind = ReliabilityKind_t::RELIABLE;
 
-    statefulWriter->init(attributes, TopicKind_t::NO_KEY, &m_threadPool,
-                         m_transport, enforceUnicast);
+    statefulWriter->init(attributes, topicKind, &m_threadPool, m_transport,
+                         enforceUnicast);
 
     if (!part.addWriter(statefulWriter)) {
       return nullptr;
@@ -378,8 +368,8 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
   } else {
     attributes.reliabilityKind = ReliabilityKind_t::BEST_EFFORT;
 
-    statelessWriter->init(attributes, TopicKind_t::NO_KEY, &m_threadPool,
-                          m_transport, enforceUnicast);
+    statelessWriter->init(attributes, topicKind, &m_threadPool, m_transport,
+                          enforceUnicast);
 
     if (!part.addWriter(statelessWriter)) {
       return nullptr;
@@ -390,7 +380,8 @@ rtps::Writer *Domain::createWriter(Participant &part, const char *topicName,
 
 rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
                                    const char *typeName, bool reliable,
-                                   ip4_addr_t mcastaddress) {
+                                   ip4_addr_t mcastaddress,
+                                   TopicKind_t topicKind) {
   Lock lock{m_mutex};
   StatelessReader *statelessReader =
       getNextUnusedEndpoint<decltype(m_statelessReaders), StatelessReader>(
@@ -407,7 +398,6 @@ rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
     return nullptr;
   }
 
-  // TODO Distinguish WithKey and NoKey (Also changes EntityKind)
   TopicData attributes;
 
   if (strlen(topicName) > Config::MAX_TOPICNAME_LENGTH ||
@@ -419,7 +409,9 @@ rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
   attributes.endpointGuid.prefix = part.m_guidPrefix;
   attributes.endpointGuid.entityId = {
       part.getNextUserEntityKey(),
-      EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY};
+      topicKind == TopicKind_t::WITH_KEY
+          ? EntityKind_t::USER_DEFINED_READER_WITH_KEY
+          : EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY};
   attributes.unicastLocator = getUserUnicastLocator(part.m_participantId);
   if (!isZeroAddress(mcastaddress)) {
     if (ip4_addr_ismulticast(&mcastaddress)) {
@@ -446,7 +438,7 @@ rtps::Reader *Domain::createReader(Participant &part, const char *topicName,
 
     attributes.reliabilityKind = ReliabilityKind_t::RELIABLE;
 
-    statefulReader->init(attributes, m_transport);
+    statefulReader->init(attributes, m_transport, &m_threadPool);
 
     if (!part.addReader(statefulReader)) {
       DOMAIN_LOG("Failed to add reader to participant.\n");
@@ -25,6 +25,7 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/entities/Participant.h"
 #include "rtps/entities/Reader.h"
 #include "rtps/entities/Writer.h"
+#include "rtps/entities/WriterProxy.h"
 #include "rtps/messages/MessageReceiver.h"
 #include "rtps/utils/Lock.h"
 #include "rtps/utils/Log.h"
@@ -109,6 +110,8 @@ rtps::Writer *Participant::addWriter(Writer *pWriter) {
   for (unsigned int i = 0; i < m_writers.size(); i++) {
     if (m_writers[i] == nullptr) {
       m_writers[i] = pWriter;
+      m_writerIndex.insert(pWriter->m_attributes.endpointGuid.entityId,
+                           pWriter);
       if (m_hasBuilInEndpoints) {
         m_sedpAgent.addWriter(*pWriter);
       }
@@ -134,6 +137,9 @@ rtps::Reader *Participant::addReader(Reader *pReader) {
   for (unsigned int i = 0; i < m_readers.size(); i++) {
     if (m_readers[i] == nullptr) {
       m_readers[i] = pReader;
+      m_readerIndex.insert(pReader->m_attributes.endpointGuid.entityId,
+                           pReader);
+      shareWriterProxiesWithNewReader(*pReader);
       if (m_hasBuilInEndpoints) {
         m_sedpAgent.addReader(*pReader);
       }
@@ -150,6 +156,10 @@ bool Participant::deleteReader(Reader *reader) {
     if (m_readers[i]->getSEDPSequenceNumber() ==
         reader->getSEDPSequenceNumber()) {
       if (m_sedpAgent.deleteReader(reader)) {
+        m_readerIndex.remove(m_readers[i]->m_attributes.endpointGuid.entityId,
+                             m_readers[i]);
+        m_remoteWriterIndex.removeIf(
+            [&](const Guid_t &, Reader *value) { return value == m_readers[i]; });
         m_readers[i] = nullptr;
         return true;
       }
@@ -165,6 +175,8 @@ bool Participant::deleteWriter(Writer *writer) {
     if (m_writers[i]->getSEDPSequenceNumber() ==
         writer->getSEDPSequenceNumber()) {
       if (m_sedpAgent.deleteWriter(writer)) {
+        m_writerIndex.remove(m_writers[i]->m_attributes.endpointGuid.entityId,
+                             m_writers[i]);
         m_writers[i] = nullptr;
         return true;
       }
@@ -187,41 +199,134 @@ bool Participant::isReadersFull() {
 
 rtps::Writer *Participant::getWriter(EntityId_t id) {
   Lock lock{m_mutex};
-  for (uint8_t i = 0; i < m_writers.size(); ++i) {
-    if (m_writers[i] == nullptr) {
+  return m_writerIndex.find(id);
+}
+
+rtps::Reader *Participant::getReader(EntityId_t id) {
+  Lock lock{m_mutex};
+  return m_readerIndex.find(id);
+}
+
+rtps::Reader *Participant::getReaderByWriterId(const Guid_t &guid) {
+  Lock lock{m_mutex};
+  Reader *reader = m_remoteWriterIndex.find(guid);
+  if (reader != nullptr || !m_remoteWriterIndexOverflow) {
+    return reader;
+  }
+
+  for (uint8_t i = 0; i < m_readers.size(); ++i) {
+    if (m_readers[i] == nullptr) {
       continue;
     }
-    if (m_writers[i]->m_attributes.endpointGuid.entityId == id) {
-      return m_writers[i];
+    if (m_readers[i]->isProxy(guid)) {
+      return m_readers[i];
     }
   }
   return nullptr;
 }
 
-rtps::Reader *Participant::getReader(EntityId_t id) {
+uint32_t Participant::getReadersByWriterId(const Guid_t &guid,
+                                           Reader **readers,
+                                           uint32_t maxReaders) {
+  Lock lock{m_mutex};
+  uint32_t numReaders = 0;
+  if (!m_remoteWriterIndexOverflow) {
+    m_remoteWriterIndex.forEach(guid, [&](Reader *reader) {
+      if (numReaders < maxReaders) {
+        readers[numReaders++] = reader;
+      }
+    });
+    return numReaders;
+  }
+
+  for (uint8_t i = 0; i < m_readers.size() && numReaders < maxReaders; ++i) {
+    if (m_readers[i] != nullptr && m_readers[i]->isProxy(guid)) {
+      readers[numReaders++] = m_readers[i];
+    }
+  }
+  return numReaders;
+}
+
+bool Participant::addWriterProxyToReader(Reader &reader,
+                                         const WriterProxy &proxy) {
+  Lock lock{m_mutex};
+  if (reader.isProxy(proxy.remoteWriterGuid)) {
+    return true;
+  }
+  if (!reader.addNewMatchedWriter(proxy)) {
+    return false;
+  }
+  if (!m_remoteWriterIndex.insert(proxy.remoteWriterGuid, &reader)) {
+    PARTICIPANT_LOG("Remote writer index full, falling back to search");
+    m_remoteWriterIndexOverflow = true;
+  }
+  return true;
+}
+
+uint32_t
+Participant::addWriterProxyToMatchingReaders(const TopicData &writerData,
+                                             const WriterProxy &proxy) {
   Lock lock{m_mutex};
+  uint32_t numMatched = 0;
   for (uint8_t i = 0; i < m_readers.size(); ++i) {
     if (m_readers[i] == nullptr) {
       continue;
     }
-    if (m_readers[i]->m_attributes.endpointGuid.entityId == id) {
-      return m_readers[i];
+    if (m_readers[i]->m_attributes.matchesTopicOf(writerData) &&
+        (writerData.reliabilityKind == ReliabilityKind_t::RELIABLE ||
+         m_readers[i]->m_attributes.reliabilityKind ==
+             ReliabilityKind_t::BEST_EFFORT)) {
+      if (addWriterProxyToReader(*m_readers[i], proxy)) {
+        ++numMatched;
+      }
     }
   }
-  return nullptr;
+  return numMatched;
 }
 
-rtps::Reader *Participant::getReaderByWriterId(const Guid_t &guid) {
+uint32_t Participant::addWriterProxyToMatchingReaders(
+    const TopicDataCompressed &writerData, const WriterProxy &proxy) {
   Lock lock{m_mutex};
+  uint32_t numMatched = 0;
   for (uint8_t i = 0; i < m_readers.size(); ++i) {
     if (m_readers[i] == nullptr) {
       continue;
     }
-    if (m_readers[i]->isProxy(guid)) {
-      return m_readers[i];
+    if (writerData.matchesTopicOf(m_readers[i]->m_attributes) &&
+        (writerData.is_reliable == true ||
+         m_readers[i]->m_attributes.reliabilityKind ==
+             ReliabilityKind_t::BEST_EFFORT)) {
+      if (addWriterProxyToReader(*m_readers[i], proxy)) {
+        ++numMatched;
+      }
+    }
+  }
+  return numMatched;
+}
+
+void Participant::shareWriterProxiesWithNewReader(Reader &newReader) {
+  // Remote writers are only announced once. If they are already matched
+  // with a reader of the same topic, the new reader has to take them over.
+  struct Context {
+    Participant *participant;
+    Reader *newReader;
+  } context{this, &newReader};
+  auto jumppad = [](const Reader *, const WriterProxy &proxy, void *arg) {
+    auto ctx = static_cast<Context *>(arg);
+    if (proxy.is_reliable || ctx->newReader->m_attributes.reliabilityKind ==
+                                 ReliabilityKind_t::BEST_EFFORT) {
+      ctx->participant->addWriterProxyToReader(*ctx->newReader, proxy);
+    }
+  };
+
+  for (uint8_t i = 0; i < m_readers.size(); ++i) {
+    if (m_readers[i] == nullptr || m_readers[i] == &newReader) {
+      continue;
+    }
+    if (m_readers[i]->m_attributes.matchesTopicOf(newReader.m_attributes)) {
+      m_readers[i]->dumpAllProxies(jumppad, &context);
     }
   }
-  return nullptr;
 }
 
 rtps::Writer *Participant::getMatchingWriter(const TopicData &readerTopicData) {
@@ -311,6 +416,9 @@ bool Participant::removeRemoteParticipant(const GuidPrefix_t &prefix) {
 
 void Participant::removeAllProxiesOfParticipant(const GuidPrefix_t &prefix) {
   Lock lock{m_mutex};
+  m_remoteWriterIndex.removeIf([&](const Guid_t &guid, Reader *) {
+    return guid.prefix == prefix;
+  });
   for (unsigned int i = 0; i < m_readers.size(); i++) {
     if (m_readers[i] == nullptr) {
       continue;
@@ -328,6 +436,7 @@ void Participant::removeAllProxiesOfParticipant(const GuidPrefix_t &prefix) {
 
 void Participant::removeProxyFromAllEndpoints(const Guid_t &guid) {
   Lock lock{m_mutex};
+  m_remoteWriterIndex.removeAll(guid);
   for (unsigned int i = 0; i < m_writers.size(); i++) {
     if (m_writers[i] == nullptr) {
       continue;
@@ -540,3 +649,9 @@ void Participant::newMessage(const uint8_t *data, DataSize_t size) {
     PARTICIPANT_LOG("MESSAGE PROCESSING FAILE \r\n");
   }
 }
+
+void Participant::newMessage(const pbuf *chain) {
+  if (!m_receiver.processMessage(chain)) {
+    PARTICIPANT_LOG("MESSAGE PROCESSING FAILE \r\n");
+  }
+}
@@ -1,6 +1,8 @@
+#include <rtps/ThreadPool.h>
 #include <rtps/entities/Reader.h>
 #include <rtps/entities/StatefulReader.h>
 #include <rtps/entities/StatelessReader.h>
+#include <rtps/messages/MessageTypes.h>
 #include <rtps/utils/Lock.h>
 #include <rtps/utils/Log.h>
 
@@ -17,6 +19,43 @@ void Reader::executeCallbacks(const ReaderCacheChange &cacheChange) {
   }
 }
 
+void Reader::onNewDataFrag(const SubmessageDataFrag &msg,
+                           const GuidPrefix_t &remotePrefix,
+                           const PBufView &data) {
+  if (!m_is_initialized_ || m_callback_count == 0) {
+    return;
+  }
+  Lock lock{m_proxies_mutex};
+
+  Guid_t writerGuid{remotePrefix, msg.writerId};
+  auto *sample = m_fragments.addFragments(
+      writerGuid, msg.writerSN, msg.sampleSize, msg.fragmentSize,
+      msg.fragmentStartingNum.value, msg.fragmentsInSubmessage, data);
+  if (sample == nullptr) {
+    return;
+  }
+
+  ReaderCacheChange change{ChangeKind_t::ALIVE, writerGuid, msg.writerSN,
+                           sample->getData(),
+                           static_cast<DataSize_t>(sample->sampleSize)};
+  newChange(change);
+  m_fragments.release(*sample);
+}
+
+bool Reader::scheduleResponses() {
+  if (mp_threadPool == nullptr) {
+    return false;
+  }
+  if (m_responsesScheduled.exchange(true)) {
+    return true;
+  }
+  if (!mp_threadPool->addControlWorkload(this)) {
+    m_responsesScheduled = false;
+    return false;
+  }
+  return true;
+}
+
 bool Reader::initMutex() {
   if (m_proxies_mutex == nullptr) {
     if (!createMutex(&m_proxies_mutex)) {
@@ -40,6 +79,7 @@ void Reader::reset() {
   Lock lock2{m_callback_mutex};
 
   m_proxies.clear();
+  m_fragments.clear();
   for (unsigned int i = 0; i < m_callbacks.size(); i++) {
     m_callbacks[i].function = nullptr;
     m_callbacks[i].arg = nullptr;
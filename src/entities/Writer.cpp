@@ -3,7 +3,9 @@
 #include <rtps/entities/ReaderProxy.h>
 #include <rtps/entities/StatefulWriter.h>
 #include <rtps/entities/Writer.h>
+#include <rtps/utils/Diagnostics.h>
 #include <rtps/storages/MemoryPool.h>
+#include <algorithm>
 
 using namespace rtps;
 
@@ -57,6 +59,13 @@ const rtps::CacheChange *rtps::Writer::newChange(ChangeKind_t kind,
   return newChange(kind, data, size, false, false);
 }
 
+const rtps::CacheChange *rtps::Writer::newChange(ChangeKind_t kind,
+                                                 const uint8_t *data,
+                                                 DataSize_t size,
+                                                 const KeyHash_t & /*key*/) {
+  return newChange(kind, data, size, false, false);
+}
+
 void rtps::Writer::manageSendOptions() {
   INIT_GUARD();
   Lock lock{m_mutex};
@@ -95,6 +104,50 @@ void rtps::Writer::manageSendOptions() {
   }
 }
 
+void rtps::Writer::collectDataDestinations(DataDestinations &destinations) {
+  INIT_GUARD();
+  Lock lock{m_mutex};
+  destinations.count = 0;
+  destinations.readerId = ENTITYID_UNKNOWN;
+
+  bool sameReaderId = true;
+  bool multicastUsed = false;
+  for (const auto &proxy : m_proxies) {
+    // Someone else sends for this proxy (Multicast)
+    if (!m_enforceUnicast && !proxy.useMulticast && proxy.suppressUnicast) {
+      continue;
+    }
+
+    const bool multicast = !m_enforceUnicast && proxy.useMulticast;
+    const LocatorIPv4 &locator =
+        multicast ? proxy.remoteMulticastLocator : proxy.remoteLocator;
+    multicastUsed |= multicast;
+
+    if (destinations.count == 0) {
+      destinations.readerId = proxy.remoteReaderGuid.entityId;
+    } else if (destinations.readerId != proxy.remoteReaderGuid.entityId) {
+      sameReaderId = false;
+    }
+
+    bool known = false;
+    for (uint32_t i = 0; i < destinations.count; ++i) {
+      if (destinations.locators[i].address == locator.address &&
+          destinations.locators[i].port == locator.port) {
+        known = true;
+        break;
+      }
+    }
+    if (!known) {
+      destinations.locators[destinations.count] = locator;
+      ++destinations.count;
+    }
+  }
+
+  if (!sameReaderId || multicastUsed) {
+    destinations.readerId = ENTITYID_UNKNOWN;
+  }
+}
+
 void rtps::Writer::removeAllProxiesOfParticipant(
     const GuidPrefix_t &guidPrefix) {
   INIT_GUARD();
@@ -117,6 +170,72 @@ bool rtps::Writer::isBuiltinEndpoint() {
                EntityKind_t::USER_DEFINED_WRITER_WITH_KEY);
 }
 
+void rtps::Writer::setPriority(uint8_t priority) {
+  m_priority = std::min<uint8_t>(priority, Config::THREAD_POOL_NUM_PRIORITIES - 1);
+}
+
+uint8_t rtps::Writer::getPriority() {
+  return isBuiltinEndpoint() ? Config::THREAD_POOL_BUILTIN_WRITER_PRIORITY
+                             : m_priority;
+}
+
+bool rtps::Writer::scheduleProgress() {
+  if (mp_threadPool == nullptr) {
+    return false;
+  }
+  if (m_progressScheduled.exchange(true)) {
+    return true; // progress() will pick up the new changes as well
+  }
+  if (!mp_threadPool->addWorkload(this)) {
+    m_progressScheduled = false;
+    return false;
+  }
+  return true;
+}
+
+void rtps::Writer::onWorkloadDequeued() { m_progressScheduled = false; }
+
+void rtps::Writer::setRateLimit(uint32_t bytesPerSecond, uint32_t burstBytes) {
+  Lock lock{m_mutex};
+  m_rateLimiter.configure(bytesPerSecond, burstBytes);
+}
+
+void rtps::Writer::setStrictReliable(bool enabled,
+                                     uint32_t maxBlockingTimeMs) {
+  Lock lock{m_mutex};
+  m_strictReliable = enabled;
+  m_maxBlockingTimeMs = maxBlockingTimeMs;
+}
+
+bool rtps::Writer::consumeSendBudget(uint32_t bytes) {
+  if (m_rateLimiter.tryConsume(bytes)) {
+    return true;
+  }
+  Diagnostics::Network::rate_limited_sends++;
+  return false;
+}
+
+void rtps::Writer::deferProgress(uint32_t bytes) {
+  if (getTimerWheel() == nullptr || m_progressDeferred.exchange(true)) {
+    return;
+  }
+  getTimerWheel()->schedule(m_deferredProgressTimer,
+                            m_rateLimiter.getWaitTimeMs(bytes));
+}
+
+void rtps::Writer::cancelDeferredProgress() {
+  if (getTimerWheel() != nullptr) {
+    getTimerWheel()->cancel(m_deferredProgressTimer);
+  }
+  m_progressDeferred = false;
+}
+
+void rtps::Writer::deferredProgressJumppad(void *thisPointer) {
+  auto *writer = static_cast<Writer *>(thisPointer);
+  writer->m_progressDeferred = false;
+  writer->scheduleProgress();
+}
+
 bool rtps::Writer::isIrrelevant(ChangeKind_t kind) const {
   // Right now we only allow alive changes
   // return kind == ChangeKind_t::INVALID || (m_topicKind == TopicKind_t::NO_KEY
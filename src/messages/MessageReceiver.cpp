@@ -44,6 +44,36 @@ using rtps::MessageReceiver;
 #define RECV_LOG(...) //
 #endif
 
+namespace {
+/**
+ * Determines where the serialized payload of a DATA or DATA_FRAG starts and
+ * parses the inline QoS in front of it, if there is any. fieldsSize is the
+ * raw size of the submessage up to the inline QoS.
+ */
+bool parseInlineQos(const rtps::MessageProcessingInfo &msgInfo,
+                    const rtps::SubmessageHeader &header,
+                    uint16_t octetsToInlineQos, rtps::DataSize_t fieldsSize,
+                    rtps::InlineQos_t &qos, rtps::DataSize_t &payloadOffset) {
+  using namespace rtps;
+  // Counted from the end of the octetsToInlineQos field
+  payloadOffset = SubmessageHeader::getRawSize() + 4 + octetsToInlineQos;
+  const DataSize_t end =
+      SubmessageHeader::getRawSize() + header.octetsToNextHeader;
+  if (payloadOffset < fieldsSize || payloadOffset > end) {
+    return false;
+  }
+  if (header.flags & SubMessageFlag::FLAG_INLINE_QOS) {
+    DataSize_t length;
+    if (!deserializeInlineQos(msgInfo, header, payloadOffset,
+                              end - payloadOffset, qos, length)) {
+      return false;
+    }
+    payloadOffset += length;
+  }
+  return true;
+}
+} // namespace
+
 MessageReceiver::MessageReceiver(Participant *part) : mp_part(part) {}
 
 void MessageReceiver::resetState() {
@@ -54,8 +84,19 @@ void MessageReceiver::resetState() {
 }
 
 bool MessageReceiver::processMessage(const uint8_t *data, DataSize_t size) {
+  pbuf *chain = pbuf_alloc(PBUF_RAW, size, PBUF_REF);
+  if (chain == nullptr) {
+    return false;
+  }
+  chain->payload = const_cast<uint8_t *>(data);
+  const bool success = processMessage(chain);
+  pbuf_free(chain);
+  return success;
+}
+
+bool MessageReceiver::processMessage(const pbuf *chain) {
   resetState();
-  MessageProcessingInfo msgInfo(data, size);
+  MessageProcessingInfo msgInfo(chain);
 
   if (!processHeader(msgInfo)) {
     return false;
@@ -65,6 +106,12 @@ bool MessageReceiver::processMessage(const uint8_t *data, DataSize_t size) {
     if (!deserializeMessage(msgInfo, submsgHeader)) {
       return false;
     }
+    // Advancing past the end would wrap nextPos
+    if (submsgHeader.octetsToNextHeader >
+        msgInfo.getRemainingSize() - SubmessageHeader::getRawSize()) {
+      RECV_LOG("Submessage exceeds the message. Dropping the rest.\n");
+      return false;
+    }
     processSubmessage(msgInfo, submsgHeader);
   }
 
@@ -108,10 +155,22 @@ bool MessageReceiver::processSubmessage(MessageProcessingInfo &msgInfo,
     RECV_LOG("Processing Data submessage\n");
     success = processDataSubmessage(msgInfo, submsgHeader);
     break;
+  case SubmessageKind::DATA_FRAG:
+    RECV_LOG("Processing DataFrag submessage\n");
+    success = processDataFragSubmessage(msgInfo, submsgHeader);
+    break;
   case SubmessageKind::HEARTBEAT:
     RECV_LOG("Processing Heartbeat submessage\n");
     success = processHeartbeatSubmessage(msgInfo);
     break;
+  case SubmessageKind::HEARTBEAT_FRAG:
+    RECV_LOG("HeartbeatFrag submessage not relevant.\n");
+    success = true; // Missing fragments are requested on HEARTBEAT
+    break;
+  case SubmessageKind::NACK_FRAG:
+    RECV_LOG("Processing NackFrag submessage\n");
+    success = processNackFragSubmessage(msgInfo);
+    break;
   case SubmessageKind::INFO_DST:
     RECV_LOG("Info_DST submessage not relevant.\n");
     success = true; // Not relevant
@@ -141,44 +200,42 @@ bool MessageReceiver::processDataSubmessage(
     return false;
   }
 
-  const uint8_t *serializedData =
-      msgInfo.getPointerToCurrentPos() + SubmessageData::getRawSize();
+  InlineQos_t inlineQos;
+  DataSize_t payloadOffset;
+  if (!parseInlineQos(msgInfo, dataSubmsg.header, dataSubmsg.octetsToInlineQos,
+                      SubmessageData::getRawSize(), inlineQos,
+                      payloadOffset)) {
+    return false;
+  }
 
-  const DataSize_t size = submsgHeader.octetsToNextHeader -
-                          SubmessageData::getRawSize() +
-                          SubmessageHeader::getRawSize();
+  // Disposals and unregistrations may come without any payload
+  const bool hasPayload =
+      dataSubmsg.header.flags & (SubMessageFlag::FLAG_DATA_PAYLOAD |
+                                 SubMessageFlag::FLAG_KEY_PAYLOAD);
+  const DataSize_t size =
+      hasPayload ? SubmessageHeader::getRawSize() +
+                       submsgHeader.octetsToNextHeader - payloadOffset
+                 : 0;
+  const PBufView serializedData = msgInfo.getView(payloadOffset, size);
 
   RECV_LOG("Received data message size %u", (int)size);
 
-  Reader *reader;
-  if (dataSubmsg.readerId == ENTITYID_UNKNOWN) {
-#if RECV_VERBOSE && RTPS_GLOBAL_VERBOSE
-    RECV_LOG("Received ENTITYID_UNKNOWN readerID, searching for writer ID = ");
-    printGuid(Guid_t{sourceGuidPrefix, dataSubmsg.writerId});
-    printf("\n");
-#endif
-    reader = mp_part->getReaderByWriterId(
-        Guid_t{sourceGuidPrefix, dataSubmsg.writerId});
-    if (reader != nullptr)
-      RECV_LOG("Found reader!");
-  } else {
-    reader = mp_part->getReader(dataSubmsg.readerId);
-#if RECV_VERBOSE && RTPS_GLOBAL_VERBOSE
-    auto reader_by_writer = mp_part->getReaderByWriterId(
-        Guid_t{sourceGuidPrefix, dataSubmsg.writerId});
+  // ENTITYID_UNKNOWN addresses all local readers matched with the writer
+  std::array<Reader *, Config::NUM_READERS_PER_PARTICIPANT> readers;
+  const uint32_t numReaders =
+      getAddressedReaders(dataSubmsg.readerId, dataSubmsg.writerId,
+                          readers.data(), readers.size());
+  RECV_LOG("Delivering data to %u readers",
+           static_cast<unsigned int>(numReaders));
 
-    if (reader_by_writer == nullptr && reader != nullptr) {
-      RECV_LOG("FOUND By READER ID, NOT BY WRITER ID =");
-      printGuid(Guid_t{sourceGuidPrefix, dataSubmsg.writerId});
-      printf("\n");
-    }
-#endif
-  }
-  if (reader != nullptr) {
+  if (numReaders != 0) {
+    // Parsed once, handed to every reader
     Guid_t writerGuid{sourceGuidPrefix, dataSubmsg.writerId};
-    ReaderCacheChange change{ChangeKind_t::ALIVE, writerGuid,
-                             dataSubmsg.writerSN, serializedData, size};
-    reader->newChange(change);
+    ReaderCacheChange change{inlineQos.getChangeKind(), writerGuid,
+                             dataSubmsg.writerSN, serializedData, inlineQos};
+    for (uint32_t i = 0; i < numReaders; ++i) {
+      readers[i]->newChange(change);
+    }
   } else {
 #if RECV_VERBOSE && RTPS_GLOBAL_VERBOSE
     RECV_LOG("Couldn't find a reader with id: ");
@@ -190,6 +247,40 @@ bool MessageReceiver::processDataSubmessage(
   return true;
 }
 
+bool MessageReceiver::processDataFragSubmessage(
+    MessageProcessingInfo &msgInfo, const SubmessageHeader &submsgHeader) {
+  SubmessageDataFrag fragSubmsg;
+  if (!deserializeMessage(msgInfo, fragSubmsg)) {
+    return false;
+  }
+
+  // Only the position of the fragment matters, the inline QoS is skipped
+  InlineQos_t inlineQos;
+  DataSize_t payloadOffset;
+  if (!parseInlineQos(msgInfo, fragSubmsg.header, fragSubmsg.octetsToInlineQos,
+                      SubmessageDataFrag::getRawSize(), inlineQos,
+                      payloadOffset)) {
+    return false;
+  }
+
+  const DataSize_t size = SubmessageHeader::getRawSize() +
+                          submsgHeader.octetsToNextHeader - payloadOffset;
+  const PBufView serializedData = msgInfo.getView(payloadOffset, size);
+
+  RECV_LOG("Received fragment %u of SN %u with size %u",
+           (int)fragSubmsg.fragmentStartingNum.value,
+           (int)fragSubmsg.writerSN.low, (int)size);
+
+  std::array<Reader *, Config::NUM_READERS_PER_PARTICIPANT> readers;
+  const uint32_t numReaders =
+      getAddressedReaders(fragSubmsg.readerId, fragSubmsg.writerId,
+                          readers.data(), readers.size());
+  for (uint32_t i = 0; i < numReaders; ++i) {
+    readers[i]->onNewDataFrag(fragSubmsg, sourceGuidPrefix, serializedData);
+  }
+  return numReaders != 0;
+}
+
 bool MessageReceiver::processHeartbeatSubmessage(
     MessageProcessingInfo &msgInfo) {
   SubmessageHeartbeat submsgHB;
@@ -197,9 +288,14 @@ bool MessageReceiver::processHeartbeatSubmessage(
     return false;
   }
 
-  Reader *reader = mp_part->getReader(submsgHB.readerId);
-  if (reader != nullptr) {
-    reader->onNewHeartbeat(submsgHB, sourceGuidPrefix);
+  // Piggybacked heartbeats may address all readers of the writer
+  std::array<Reader *, Config::NUM_READERS_PER_PARTICIPANT> readers;
+  const uint32_t numReaders = getAddressedReaders(
+      submsgHB.readerId, submsgHB.writerId, readers.data(), readers.size());
+  for (uint32_t i = 0; i < numReaders; ++i) {
+    readers[i]->onNewHeartbeat(submsgHB, sourceGuidPrefix);
+  }
+  if (numReaders != 0) {
     mp_part->refreshRemoteParticipantLiveliness(sourceGuidPrefix);
     return true;
   } else {
@@ -222,18 +318,46 @@ bool MessageReceiver::processAckNackSubmessage(MessageProcessingInfo &msgInfo) {
   }
 }
 
-bool MessageReceiver::processGapSubmessage(MessageProcessingInfo &msgInfo) {
-  SubmessageGap submsgGap;
-  if (!deserializeMessage(msgInfo, submsgGap)) {
+bool MessageReceiver::processNackFragSubmessage(
+    MessageProcessingInfo &msgInfo) {
+  SubmessageNackFrag submsgNackFrag;
+  if (!deserializeMessage(msgInfo, submsgNackFrag)) {
     return false;
   }
 
-  Reader *reader = mp_part->getReader(submsgGap.readerId);
-  if (reader != nullptr) {
-    reader->onNewGapMessage(submsgGap, sourceGuidPrefix);
+  Writer *writer = mp_part->getWriter(submsgNackFrag.writerId);
+  if (writer != nullptr) {
+    writer->onNewNackFrag(submsgNackFrag, sourceGuidPrefix);
     return true;
   } else {
     return false;
   }
 }
+
+bool MessageReceiver::processGapSubmessage(MessageProcessingInfo &msgInfo) {
+  SubmessageGap submsgGap;
+  if (!deserializeMessage(msgInfo, submsgGap)) {
+    return false;
+  }
+
+  std::array<Reader *, Config::NUM_READERS_PER_PARTICIPANT> readers;
+  const uint32_t numReaders = getAddressedReaders(
+      submsgGap.readerId, submsgGap.writerId, readers.data(), readers.size());
+  for (uint32_t i = 0; i < numReaders; ++i) {
+    readers[i]->onNewGapMessage(submsgGap, sourceGuidPrefix);
+  }
+  return numReaders != 0;
+}
+
+uint32_t MessageReceiver::getAddressedReaders(const EntityId_t &readerId,
+                                              const EntityId_t &writerId,
+                                              Reader **readers,
+                                              uint32_t maxReaders) {
+  if (readerId == ENTITYID_UNKNOWN) {
+    return mp_part->getReadersByWriterId(Guid_t{sourceGuidPrefix, writerId},
+                                         readers, maxReaders);
+  }
+  readers[0] = mp_part->getReader(readerId);
+  return (readers[0] != nullptr) ? 1 : 0;
+}
 #undef RECV_VERBOSE
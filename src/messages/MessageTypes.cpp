@@ -22,32 +22,251 @@ This file is part of embeddedRTPS.
 Author: i11 - Embedded Software, RWTH Aachen University
 */
 
+#include "rtps/config.h"
 #include "rtps/messages/MessageTypes.h"
 #include <cstring>
 
 #include <stdio.h>
 using namespace rtps;
+using rtps::SMElement::ParameterId;
 
-void doCopyAndMoveOn(uint8_t *dst, const uint8_t *&src, size_t size) {
-  memcpy(dst, src, size);
-  src += size;
+namespace {
+
+inline uint16_t byteSwap(uint16_t value) {
+  return static_cast<uint16_t>((value << 8) | (value >> 8));
+}
+
+inline uint32_t byteSwap(uint32_t value) {
+  return ((value & 0x000000FFu) << 24) | ((value & 0x0000FF00u) << 8) |
+         ((value & 0x00FF0000u) >> 8) | ((value & 0xFF000000u) >> 24);
+}
+
+inline int32_t byteSwap(int32_t value) {
+  return static_cast<int32_t>(byteSwap(static_cast<uint32_t>(value)));
+}
+
+/**
+ * Reads fields straight from the received bytes. Whether multi-byte fields
+ * have to be swapped is decided once per submessage, so the per field code
+ * is a plain (possibly unaligned) load plus an optional byte reversal.
+ */
+template <bool Swap> class FieldReader {
+public:
+  explicit FieldReader(const uint8_t *position) : m_pos(position) {}
+
+  template <typename T> T read() {
+    T value;
+    memcpy(&value, m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return Swap ? byteSwap(value) : value;
+  }
+
+  void read(EntityId_t &id) {
+    memcpy(id.entityKey.data(), m_pos, id.entityKey.size());
+    id.entityKind = static_cast<EntityKind_t>(m_pos[id.entityKey.size()]);
+    m_pos += id.entityKey.size() + sizeof(EntityKind_t);
+  }
+
+  void read(SequenceNumber_t &sn) {
+    sn.high = read<int32_t>();
+    sn.low = read<uint32_t>();
+  }
+
+  //! Reads up to the size of bitMap and skips the rest of the wire bitmap
+  template <size_t N>
+  void readBitmap(std::array<uint32_t, N> &bitMap, size_t wireBytes) {
+    const size_t wireWords = wireBytes / 4;
+    const size_t words = wireWords > N ? N : wireWords;
+    for (size_t i = 0; i < words; ++i) {
+      bitMap[i] = read<uint32_t>();
+    }
+    m_pos += wireBytes - words * 4;
+  }
+
+  void skip(size_t bytes) { m_pos += bytes; }
+
+private:
+  const uint8_t *m_pos;
+};
+
+//! Bytes of the bitmap of a SequenceNumberSet or FragmentNumberSet
+inline uint32_t getBitmapSize(uint32_t numBits) {
+  return 4 * ((numBits + 31) / 32);
+}
+
+//! True if the submessage was written with the other byte order than ours
+inline bool needsByteSwap(uint8_t flags) {
+#if IS_LITTLE_ENDIAN
+  return (flags & SubMessageFlag::FLAG_ENDIANESS) ==
+         SubMessageFlag::FLAG_BIG_ENDIAN;
+#else
+  return (flags & SubMessageFlag::FLAG_ENDIANESS) ==
+         SubMessageFlag::FLAG_LITTLE_ENDIAN;
+#endif
+}
+
+template <bool Swap>
+bool decode(FieldReader<Swap> &in, SubmessageData &msg) {
+  msg.extraFlags = in.template read<uint16_t>();
+  msg.octetsToInlineQos = in.template read<uint16_t>();
+  in.read(msg.readerId);
+  in.read(msg.writerId);
+  in.read(msg.writerSN);
+  return true;
+}
+
+template <bool Swap>
+bool decode(FieldReader<Swap> &in, SubmessageDataFrag &msg) {
+  msg.extraFlags = in.template read<uint16_t>();
+  msg.octetsToInlineQos = in.template read<uint16_t>();
+  in.read(msg.readerId);
+  in.read(msg.writerId);
+  in.read(msg.writerSN);
+  msg.fragmentStartingNum.value = in.template read<uint32_t>();
+  msg.fragmentsInSubmessage = in.template read<uint16_t>();
+  msg.fragmentSize = in.template read<uint16_t>();
+  msg.sampleSize = in.template read<uint32_t>();
+  return true;
+}
+
+template <bool Swap>
+bool decode(FieldReader<Swap> &in, SubmessageHeartbeat &msg) {
+  if (msg.header.octetsToNextHeader <
+      SubmessageHeartbeat::getRawSize() - SubmessageHeader::getRawSize()) {
+    return false;
+  }
+  in.read(msg.readerId);
+  in.read(msg.writerId);
+  in.read(msg.firstSN);
+  in.read(msg.lastSN);
+  msg.count.value = in.template read<int32_t>();
+  return true;
+}
+
+template <bool Swap>
+bool decode(FieldReader<Swap> &in, SubmessageAckNack &msg) {
+  // readerId, writerId, bitmap base and numBits, followed by bitmap and count
+  constexpr uint16_t fixedSize = 4 + 4 + 8 + 4;
+  if (msg.header.octetsToNextHeader < fixedSize + 4) {
+    return false;
+  }
+  in.read(msg.readerId);
+  in.read(msg.writerId);
+
+  // The bitmap length follows from numBits, there may be padding behind count
+  SequenceNumberSet &set = msg.readerSNState;
+  in.read(set.base);
+  set.numBits = in.template read<uint32_t>();
+  if (set.numBits > SNS_MAX_NUM_BITS ||
+      msg.header.octetsToNextHeader <
+          fixedSize + getBitmapSize(set.numBits) + 4) {
+    return false;
+  }
+  set.bitMap = {};
+  in.readBitmap(set.bitMap, getBitmapSize(set.numBits));
+
+  msg.count.value = in.template read<int32_t>();
+  return true;
+}
+
+template <bool Swap>
+bool decode(FieldReader<Swap> &in, SubmessageGap &msg) {
+  // readerId, writerId, gapStart, bitmap base and numBits
+  constexpr uint16_t fixedSize = 4 + 4 + 8 + 8 + 4;
+  if (msg.header.octetsToNextHeader < fixedSize) {
+    return false;
+  }
+  in.read(msg.readerId);
+  in.read(msg.writerId);
+  in.read(msg.gapStart);
+
+  SequenceNumberSet &set = msg.gapList;
+  in.read(set.base);
+  set.numBits = in.template read<uint32_t>();
+  if (set.numBits > SNS_MAX_NUM_BITS ||
+      msg.header.octetsToNextHeader < fixedSize + getBitmapSize(set.numBits)) {
+    return false;
+  }
+  set.bitMap = {};
+  in.readBitmap(set.bitMap, getBitmapSize(set.numBits));
+  return true;
+}
+
+template <bool Swap>
+bool decode(FieldReader<Swap> &in, SubmessageNackFrag &msg) {
+  in.read(msg.readerId);
+  in.read(msg.writerId);
+  in.read(msg.writerSN);
+
+  FragmentNumberSet &set = msg.fragmentNumberState;
+  set.base.value = in.template read<uint32_t>();
+  set.numBits = in.template read<uint32_t>();
+
+  // Ensure that we copy not more bits than our set can hold
+  const size_t num_bitfields = getBitmapSize(set.numBits);
+  if (set.numBits > SNS_MAX_NUM_BITS ||
+      msg.header.octetsToNextHeader < 4 + 4 + 8 + 4 + 4 + num_bitfields + 4) {
+    return false;
+  }
+  set.bitMap = {};
+  in.readBitmap(set.bitMap, num_bitfields);
+
+  msg.count.value = in.template read<int32_t>();
+  return true;
+}
+
+//! Decodes the fields following the submessage header in its byte order
+template <typename Submessage>
+bool decodeSubmessage(const uint8_t *position, Submessage &msg) {
+  position += SubmessageHeader::getRawSize();
+  if (needsByteSwap(msg.header.flags)) {
+    FieldReader<true> in(position);
+    return decode(in, msg);
+  } else {
+    FieldReader<false> in(position);
+    return decode(in, msg);
+  }
+}
+
+/**
+ * Returns the submessage at the current position, at most maxSize bytes of
+ * it including the header. Anything behind is padding or unknown extensions,
+ * which must not need to be linearized. nullptr if the message ends before
+ * the submessage.
+ */
+const uint8_t *getSubmessagePointer(const MessageProcessingInfo &info,
+                                    const SubmessageHeader &header,
+                                    DataSize_t maxSize) {
+  const DataSize_t size =
+      SubmessageHeader::getRawSize() + header.octetsToNextHeader;
+  if (info.getRemainingSize() < size) {
+    return nullptr;
+  }
+  return info.getPointerToCurrentPos(size < maxSize ? size : maxSize);
 }
 
+} // namespace
+
 bool rtps::deserializeMessage(const MessageProcessingInfo &info,
                               Header &header) {
   if (info.getRemainingSize() < Header::getRawSize()) {
     return false;
   }
 
-  const uint8_t *currentPos = info.getPointerToCurrentPos();
-  doCopyAndMoveOn(header.protocolName.data(), currentPos,
-                  sizeof(std::array<uint8_t, 4>));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&header.protocolVersion),
-                  currentPos, sizeof(ProtocolVersion_t));
-  doCopyAndMoveOn(header.vendorId.vendorId.data(), currentPos,
-                  header.vendorId.vendorId.size());
-  doCopyAndMoveOn(header.guidPrefix.id.data(), currentPos,
-                  header.guidPrefix.id.size());
+  const uint8_t *currentPos = info.getPointerToCurrentPos(Header::getRawSize());
+  if (currentPos == nullptr) {
+    return false;
+  }
+  // Only single bytes, nothing depends on the byte order
+  memcpy(header.protocolName.data(), currentPos, header.protocolName.size());
+  currentPos += header.protocolName.size();
+  header.protocolVersion.major = currentPos[0];
+  header.protocolVersion.minor = currentPos[1];
+  currentPos += sizeof(ProtocolVersion_t);
+  memcpy(header.vendorId.vendorId.data(), currentPos,
+         header.vendorId.vendorId.size());
+  currentPos += header.vendorId.vendorId.size();
+  memcpy(header.guidPrefix.id.data(), currentPos, header.guidPrefix.id.size());
   return true;
 }
 
@@ -57,11 +276,20 @@ bool rtps::deserializeMessage(const MessageProcessingInfo &info,
     return false;
   }
 
-  const uint8_t *currentPos = info.getPointerToCurrentPos();
-  header.submessageId = static_cast<SubmessageKind>(*currentPos++);
-  header.flags = *(currentPos++);
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&header.octetsToNextHeader),
-                  currentPos, sizeof(uint16_t));
+  const uint8_t *currentPos = info.getPointerToCurrentPos(SubmessageHeader::getRawSize());
+  if (currentPos == nullptr) {
+    return false;
+  }
+  header.submessageId = static_cast<SubmessageKind>(currentPos[0]);
+  header.flags = currentPos[1];
+  // The endianness flag applies to the length of the submessage as well
+  if (needsByteSwap(header.flags)) {
+    header.octetsToNextHeader =
+        FieldReader<true>(currentPos + 2).read<uint16_t>();
+  } else {
+    header.octetsToNextHeader =
+        FieldReader<false>(currentPos + 2).read<uint16_t>();
+  }
   return true;
 }
 
@@ -80,75 +308,56 @@ bool rtps::deserializeMessage(const MessageProcessingInfo &info,
     return false;
   }
 
-  const uint8_t *currentPos =
-      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
-
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.extraFlags), currentPos,
-                  sizeof(uint16_t));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.octetsToInlineQos),
-                  currentPos, sizeof(uint16_t));
-  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
-                  msg.readerId.entityKey.size());
-  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
-                  msg.writerId.entityKey.size());
-  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.high), currentPos,
-                  sizeof(msg.writerSN.high));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.writerSN.low), currentPos,
-                  sizeof(msg.writerSN.low));
-  return true;
+  const uint8_t *currentPos = info.getPointerToCurrentPos(SubmessageData::getRawSize());
+  if (currentPos == nullptr) {
+    return false;
+  }
+  return decodeSubmessage(currentPos, msg);
 }
 
 bool rtps::deserializeMessage(const MessageProcessingInfo &info,
-                              SubmessageHeartbeat &msg) {
-  if (info.getRemainingSize() < SubmessageHeartbeat::getRawSize()) {
+                              SubmessageDataFrag &msg) {
+  if (info.getRemainingSize() < SubmessageDataFrag::getRawSize()) {
     return false;
   }
   if (!deserializeMessage(info, msg.header)) {
     return false;
   }
 
-  const uint8_t *currentPos =
-      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
-
-  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
-                  msg.readerId.entityKey.size());
-  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
-                  msg.writerId.entityKey.size());
-  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.firstSN.high), currentPos,
-                  sizeof(msg.firstSN.high));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.firstSN.low), currentPos,
-                  sizeof(msg.firstSN.low));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.lastSN.high), currentPos,
-                  sizeof(msg.lastSN.high));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.lastSN.low), currentPos,
-                  sizeof(msg.lastSN.low));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.count.value), currentPos,
-                  sizeof(msg.count.value));
-  return true;
+  // Check for length including data
+  if (info.getRemainingSize() <
+          SubmessageHeader::getRawSize() + msg.header.octetsToNextHeader ||
+      SubmessageHeader::getRawSize() + msg.header.octetsToNextHeader <
+          SubmessageDataFrag::getRawSize()) {
+    return false;
+  }
+
+  const uint8_t *currentPos = info.getPointerToCurrentPos(SubmessageDataFrag::getRawSize());
+  if (currentPos == nullptr) {
+    return false;
+  }
+  return decodeSubmessage(currentPos, msg);
 }
 
-void rtps::deserializeSNS(const uint8_t *&position, SequenceNumberSet &set,
-                          size_t num_bitfields) {
+bool rtps::deserializeMessage(const MessageProcessingInfo &info,
+                              SubmessageHeartbeat &msg) {
+  if (info.getRemainingSize() < SubmessageHeartbeat::getRawSize()) {
+    return false;
+  }
+  if (!deserializeMessage(info, msg.header)) {
+    return false;
+  }
 
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&set.base.high), position,
-                  sizeof(SequenceNumber_t::high));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&set.base.low), position,
-                  sizeof(SequenceNumber_t::low));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&set.numBits), position,
-                  sizeof(uint32_t));
+  if (info.getRemainingSize() <
+      SubmessageHeader::getRawSize() + msg.header.octetsToNextHeader) {
+    return false;
+  }
 
-  // Ensure that we copy not more bits than our sequence number set can hold
-  if (set.numBits != 0) {
-    // equal to size = std::min(SNS_NUM_BYTES, num_bitfields)
-    size_t size = num_bitfields > SNS_NUM_BYTES ? SNS_NUM_BYTES : num_bitfields;
-    doCopyAndMoveOn(reinterpret_cast<uint8_t *>(set.bitMap.data()), position,
-                    size);
-    position += (num_bitfields - size);
+  const uint8_t *currentPos = info.getPointerToCurrentPos(SubmessageHeartbeat::getRawSize());
+  if (currentPos == nullptr) {
+    return false;
   }
+  return decodeSubmessage(currentPos, msg);
 }
 
 bool rtps::deserializeMessage(const MessageProcessingInfo &info,
@@ -163,22 +372,14 @@ bool rtps::deserializeMessage(const MessageProcessingInfo &info,
     return false;
   }
 
-  const uint8_t *currentPos =
-      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
-
-  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
-                  msg.readerId.entityKey.size());
-  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
-                  msg.writerId.entityKey.size());
-  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-
-  size_t num_bitfields = msg.header.octetsToNextHeader - 4 - 4 - 8 - 4 - 4;
-  deserializeSNS(currentPos, msg.readerSNState, num_bitfields);
-
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.count.value), currentPos,
-                  sizeof(msg.count.value));
-  return true;
+  // Fixed fields, the largest bitmap and count
+  const uint8_t *currentPos = getSubmessagePointer(
+      info, msg.header, SubmessageAckNack::getRawSizeWithoutSNSet() +
+                            sizeof(SequenceNumber_t) + 4 + SNS_NUM_BYTES);
+  if (currentPos == nullptr) {
+    return false;
+  }
+  return decodeSubmessage(currentPos, msg);
 }
 
 bool rtps::deserializeMessage(const MessageProcessingInfo &info,
@@ -194,24 +395,90 @@ bool rtps::deserializeMessage(const MessageProcessingInfo &info,
     return false;
   }
 
-  const uint8_t *currentPos =
-      info.getPointerToCurrentPos() + SubmessageHeader::getRawSize();
+  // Fixed fields and the largest bitmap
+  const uint8_t *currentPos = getSubmessagePointer(
+      info, msg.header, SubmessageGap::getRawSizeWithoutSNSet() +
+                            sizeof(SequenceNumber_t) + 4 + SNS_NUM_BYTES);
+  if (currentPos == nullptr) {
+    return false;
+  }
+  return decodeSubmessage(currentPos, msg);
+}
+
+bool rtps::deserializeMessage(const MessageProcessingInfo &info,
+                              SubmessageNackFrag &msg) {
+  if (info.getRemainingSize() <
+      SubmessageNackFrag::getRawSizeWithoutFNSet() + sizeof(FragmentNumber_t) +
+          sizeof(uint32_t)) {
+    return false;
+  }
+  if (!deserializeMessage(info, msg.header)) {
+    return false;
+  }
 
-  doCopyAndMoveOn(msg.readerId.entityKey.data(), currentPos,
-                  msg.readerId.entityKey.size());
-  msg.readerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
-  doCopyAndMoveOn(msg.writerId.entityKey.data(), currentPos,
-                  msg.writerId.entityKey.size());
-  msg.writerId.entityKind = static_cast<EntityKind_t>(*currentPos++);
+  // Fixed fields, the largest bitmap and count
+  const uint8_t *currentPos = getSubmessagePointer(
+      info, msg.header, SubmessageNackFrag::getRawSizeWithoutFNSet() +
+                            sizeof(FragmentNumber_t) + 4 + SNS_NUM_BYTES);
+  if (currentPos == nullptr) {
+    return false;
+  }
+  return decodeSubmessage(currentPos, msg);
+}
 
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.gapStart.high), currentPos,
-                  sizeof(msg.gapStart.high));
-  doCopyAndMoveOn(reinterpret_cast<uint8_t *>(&msg.gapStart.low), currentPos,
-                  sizeof(msg.gapStart.low));
+bool rtps::deserializeInlineQos(const MessageProcessingInfo &info,
+                                const SubmessageHeader &header,
+                                DataSize_t offset, DataSize_t maxLength,
+                                InlineQos_t &qos, DataSize_t &length) {
+  const bool swap = needsByteSwap(header.flags);
+  constexpr DataSize_t parameterHeaderSize = 4;
+  DataSize_t pos = 0;
+  while (pos + parameterHeaderSize <= maxLength) {
+    const uint8_t *parameter =
+        info.getPointer(offset + pos, parameterHeaderSize);
+    if (parameter == nullptr) {
+      return false;
+    }
+    uint16_t pid;
+    uint16_t parameterLength;
+    if (swap) {
+      FieldReader<true> in(parameter);
+      pid = in.read<uint16_t>();
+      parameterLength = in.read<uint16_t>();
+    } else {
+      FieldReader<false> in(parameter);
+      pid = in.read<uint16_t>();
+      parameterLength = in.read<uint16_t>();
+    }
+    pos += parameterHeaderSize;
 
-  size_t num_bitfields = msg.header.octetsToNextHeader - 4 - 4 - 8 - 8 - 4;
-      remainingSizeAtBeginning - (currentPos - info.getPointerToCurrentPos());
-  deserializeSNS(currentPos, msg.gapList, num_bitfields);
+    if (pid == ParameterId::PID_SENTINEL) {
+      length = pos;
+      return true;
+    }
+    if (parameterLength > maxLength - pos) {
+      return false;
+    }
 
-  return true;
+    if (pid == ParameterId::PID_KEY_HASH &&
+        parameterLength >= qos.keyHash.value.size()) {
+      const uint8_t *value =
+          info.getPointer(offset + pos, qos.keyHash.value.size());
+      if (value == nullptr) {
+        return false;
+      }
+      memcpy(qos.keyHash.value.data(), value, qos.keyHash.value.size());
+      qos.hasKeyHash = true;
+    } else if (pid == ParameterId::PID_STATUS_INFO && parameterLength >= 4) {
+      // Flags are an octet array, the last one holds the defined flags
+      const uint8_t *value = info.getPointer(offset + pos, 4);
+      if (value == nullptr) {
+        return false;
+      }
+      qos.statusInfo = value[3];
+      qos.hasStatusInfo = true;
+    }
+    pos += parameterLength;
+  }
+  return false;
 }
@@ -28,6 +28,8 @@ Author: i11 - Embedded Software, RWTH Aachen University
 #include "rtps/storages/PBufWrapper.h"
 #include "rtps/utils/Log.h"
 
+#include <algorithm>
+
 using rtps::PBufWrapper;
 
 #if PBUF_WRAP_VERBOSE && RTPS_GLOBAL_VERBOSE
@@ -117,6 +119,14 @@ bool PBufWrapper::append(const uint8_t *data, DataSize_t length) {
 }
 
 void PBufWrapper::append(const PBufWrapper &other) {
+  if (!other.isValid()) {
+    return;
+  }
+
+  if (this->firstElement != nullptr && spaceUsed() == 0) {
+    destroy();
+  }
+
   if (this->firstElement == nullptr) {
     m_freeSpace = other.m_freeSpace;
     this->firstElement = other.firstElement;
@@ -124,17 +134,74 @@ void PBufWrapper::append(const PBufWrapper &other) {
     return;
   }
 
-  m_freeSpace += other.m_freeSpace;
+  // Otherwise the reserved but unused bytes end up between our data and the
+  // chained one
+  shrinkToFit();
+
+  m_freeSpace = other.m_freeSpace;
   pbuf_chain(this->firstElement, other.firstElement);
 }
 
+bool PBufWrapper::appendCopy(const PBufWrapper &other) {
+  return appendCopy(other, 0, other.spaceUsed());
+}
+
+bool PBufWrapper::appendCopy(const PBufWrapper &other, DataSize_t offset,
+                             DataSize_t length) {
+  if (length > m_freeSpace ||
+      static_cast<uint32_t>(offset) + length > other.spaceUsed()) {
+    return false;
+  }
+
+  for (const pbuf *current = other.firstElement;
+       current != nullptr && length != 0; current = current->next) {
+    if (offset >= current->len) {
+      offset -= current->len;
+      continue;
+    }
+    DataSize_t chunk = std::min<DataSize_t>(current->len - offset, length);
+    if (!append(static_cast<const uint8_t *>(current->payload) + offset,
+                chunk)) {
+      return false;
+    }
+    length -= chunk;
+    offset = 0;
+  }
+  return true;
+}
+
+void PBufWrapper::shrinkToFit() {
+  if (firstElement == nullptr || m_freeSpace == 0) {
+    return;
+  }
+
+  PBUF_WRAP_LOG("Releasing %u unused bytes.", m_freeSpace);
+  pbuf_realloc(firstElement, spaceUsed());
+  m_freeSpace = 0;
+}
+
+bool PBufWrapper::wrapShared(const PBufWrapper &other) {
+  destroy();
+  if (!other.isValid()) {
+    return false;
+  }
+
+  // Zero length, only the space for the headers of the lower layers
+  firstElement = pbuf_alloc(m_layer, 0, PBUF_RAM);
+  if (firstElement == nullptr) {
+    return false;
+  }
+
+  pbuf_chain(firstElement, other.firstElement);
+  return true;
+}
+
 bool PBufWrapper::reserve(DataSize_t length) {
-  int16_t additionalAllocation = length - m_freeSpace;
-  if (additionalAllocation <= 0) {
+  if (length <= m_freeSpace) {
     return true;
   }
 
-  return increaseSizeBy(additionalAllocation);
+  return increaseSizeBy(length - m_freeSpace);
 }
 
 void PBufWrapper::reset() {
@@ -160,4 +227,21 @@ bool PBufWrapper::increaseSizeBy(uint16_t length) {
   return true;
 }
 
+const uint8_t *rtps::PBufView::getContiguous() const {
+  u16_t offsetInSegment = 0;
+  const pbuf *segment =
+      pbuf_skip(const_cast<pbuf *>(chain), offset, &offsetInSegment);
+  if (segment == nullptr || offsetInSegment + size > segment->len) {
+    return nullptr;
+  }
+  return static_cast<const uint8_t *>(segment->payload) + offsetInSegment;
+}
+
+bool rtps::PBufView::copyInto(uint8_t *buffer, DataSize_t destSize) const {
+  if (destSize < size) {
+    return false;
+  }
+  return pbuf_copy_partial(chain, buffer, size, offset) == size;
+}
+
 #undef PBUF_WRAP_VERBOSE
@@ -14,6 +14,8 @@ uint32_t processed_incoming_metatraffic = 0;
 uint32_t processed_outgoing_metatraffic = 0;
 uint32_t processed_incoming_usertraffic = 0;
 uint32_t processed_outgoing_usertraffic = 0;
+uint32_t processed_outgoing_control = 0;
+uint32_t dropped_outgoing_control = 0;
 
 uint32_t max_ever_elements_outgoing_usertraffic_queue;
 uint32_t max_ever_elements_incoming_usertraffic_queue;
@@ -21,15 +23,26 @@ uint32_t max_ever_elements_incoming_usertraffic_queue;
 uint32_t max_ever_elements_outgoing_metatraffic_queue;
 uint32_t max_ever_elements_incoming_metatraffic_queue;
 
+uint32_t outgoing_queueing_delay_histogram[Config::THREAD_POOL_NUM_PRIORITIES]
+                                          [QUEUEING_DELAY_BUCKETS];
+uint32_t max_ever_outgoing_queueing_delay_ms[Config::THREAD_POOL_NUM_PRIORITIES];
 } // namespace ThreadPool
 
 namespace StatefulReader {
 uint32_t sfr_unexpected_sn;
 uint32_t sfr_retransmit_requests;
+uint32_t sfr_buffered_out_of_order;
+uint32_t sfr_reorder_buffer_full;
 } // namespace StatefulReader
 
+namespace StatefulWriter {
+uint32_t sfw_would_block;
+uint32_t sfw_unresponsive_readers;
+} // namespace StatefulWriter
+
 namespace Network {
 uint32_t lwip_allocation_failures;
+uint32_t rate_limited_sends;
 }
 
 namespace SEDP {
@@ -0,0 +1,240 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "rtps/utils/TimerWheel.h"
+
+#include "rtps/utils/Log.h"
+
+using rtps::TimerWheel;
+
+#if TIMER_WHEEL_VERBOSE && RTPS_GLOBAL_VERBOSE
+#include "rtps/utils/printutils.h"
+#define TIMER_WHEEL_LOG(...)                                                   \
+  if (true) {                                                                  \
+    printf("[TimerWheel] ");                                                   \
+    printf(__VA_ARGS__);                                                       \
+    printf("\r\n");                                                            \
+  }
+#else
+#define TIMER_WHEEL_LOG(...) //
+#endif
+
+TimerWheel::TimerWheel() {
+  if (!createMutex(&m_mutex) || !createMutex(&m_callbackMutex)) {
+    TIMER_WHEEL_LOG("Failed to create mutexes.\n");
+    return;
+  }
+  if (sys_sem_new(&m_wakeupSem, 0) != ERR_OK ||
+      sys_sem_new(&m_exitSem, 0) != ERR_OK) {
+    TIMER_WHEEL_LOG("Failed to create semaphores.\n");
+  }
+  m_lastTick = sys_now() / Config::TIMER_WHEEL_TICK_MS;
+}
+
+TimerWheel::~TimerWheel() {
+  stop();
+  if (sys_sem_valid(&m_wakeupSem)) {
+    sys_sem_free(&m_wakeupSem);
+  }
+  if (sys_sem_valid(&m_exitSem)) {
+    sys_sem_free(&m_exitSem);
+  }
+}
+
+bool TimerWheel::start() {
+  if (m_running) {
+    return true;
+  }
+  if (m_mutex == nullptr || m_callbackMutex == nullptr ||
+      !sys_sem_valid(&m_wakeupSem) || !sys_sem_valid(&m_exitSem)) {
+    return false;
+  }
+  m_running = true;
+  sys_thread_new("TimerThread", threadFunction, this,
+                 Config::TIMER_THREAD_STACKSIZE, Config::TIMER_THREAD_PRIO);
+  return true;
+}
+
+void TimerWheel::stop() {
+  if (!m_running) {
+    return;
+  }
+  m_running = false;
+  sys_sem_signal(&m_wakeupSem);
+  // Wait for the thread to leave run(), it may still be in a callback
+  sys_arch_sem_wait(&m_exitSem, 0);
+}
+
+void TimerWheel::schedule(Timer &timer, uint32_t delayMs) {
+  if (m_mutex == nullptr) {
+    return;
+  }
+  Lock lock{m_mutex};
+  if (timer.m_armed) {
+    unlink(timer);
+  }
+  timer.m_deadline = sys_now() + delayMs;
+  link(timer);
+
+  // Wake up the thread if it sleeps past the new deadline
+  const uint32_t wakeup = timer.m_tick * Config::TIMER_WHEEL_TICK_MS;
+  if (!m_wakeupScheduled || isBefore(wakeup, m_nextWakeup)) {
+    m_nextWakeup = wakeup;
+    m_wakeupScheduled = true;
+    sys_sem_signal(&m_wakeupSem);
+  }
+}
+
+void TimerWheel::cancel(Timer &timer) {
+  if (m_mutex == nullptr) {
+    return;
+  }
+  // No callback runs while this is held
+  Lock callbackLock{m_callbackMutex};
+  Lock lock{m_mutex};
+  if (timer.m_armed) {
+    unlink(timer);
+  }
+  if (m_firing == &timer) {
+    m_firing = nullptr;
+  }
+}
+
+void TimerWheel::link(Timer &timer) {
+  constexpr uint32_t tickMs = Config::TIMER_WHEEL_TICK_MS;
+  timer.m_tick = (timer.m_deadline + tickMs - 1) / tickMs;
+  // Ticks up to m_lastTick were processed already
+  if (!isBefore(m_lastTick, timer.m_tick)) {
+    timer.m_tick = m_lastTick + 1;
+  }
+
+  Timer *&head = m_slots[timer.m_tick % m_slots.size()];
+  timer.m_prev = nullptr;
+  timer.m_next = head;
+  if (head != nullptr) {
+    head->m_prev = &timer;
+  }
+  head = &timer;
+  timer.m_armed = true;
+}
+
+void TimerWheel::unlink(Timer &timer) {
+  if (timer.m_prev != nullptr) {
+    timer.m_prev->m_next = timer.m_next;
+  } else {
+    m_slots[timer.m_tick % m_slots.size()] = timer.m_next;
+  }
+  if (timer.m_next != nullptr) {
+    timer.m_next->m_prev = timer.m_prev;
+  }
+  timer.m_prev = nullptr;
+  timer.m_next = nullptr;
+  timer.m_armed = false;
+}
+
+void TimerWheel::advance() {
+  const uint32_t nowTick = sys_now() / Config::TIMER_WHEEL_TICK_MS;
+  // After a long stall, every slot is visited once
+  if (nowTick - m_lastTick > m_slots.size()) {
+    m_lastTick = nowTick - m_slots.size();
+  }
+
+  while (m_lastTick != nowTick) {
+    ++m_lastTick;
+    const uint32_t slot = m_lastTick % m_slots.size();
+    Timer *timer = m_slots[slot];
+    while (timer != nullptr) {
+      // Timers further away than one rotation share the slot
+      if (isBefore(m_lastTick, timer->m_tick)) {
+        timer = timer->m_next;
+        continue;
+      }
+      unlink(*timer);
+      fire(*timer);
+      // The callback may have changed the slot
+      timer = m_slots[slot];
+    }
+  }
+}
+
+void TimerWheel::fire(Timer &timer) {
+  // Taking m_callbackMutex while holding m_mutex could deadlock with cancel()
+  m_firing = &timer;
+  xSemaphoreGiveRecursive(m_mutex);
+  xSemaphoreTakeRecursive(m_callbackMutex, portMAX_DELAY);
+
+  Timer *firing;
+  {
+    Lock lock{m_mutex};
+    firing = m_firing; // nullptr if cancelled meanwhile
+    m_firing = nullptr;
+  }
+  if (firing != nullptr) {
+    firing->m_callback(firing->m_arg);
+  }
+
+  xSemaphoreGiveRecursive(m_callbackMutex);
+  xSemaphoreTakeRecursive(m_mutex, portMAX_DELAY);
+}
+
+uint32_t TimerWheel::getSleepTime() {
+  bool found = false;
+  uint32_t earliestTick = 0;
+  for (const Timer *head : m_slots) {
+    for (const Timer *timer = head; timer != nullptr; timer = timer->m_next) {
+      if (!found || isBefore(timer->m_tick, earliestTick)) {
+        earliestTick = timer->m_tick;
+        found = true;
+      }
+    }
+  }
+  m_wakeupScheduled = found;
+  if (!found) {
+    return 0; // Until the next schedule()
+  }
+
+  m_nextWakeup = earliestTick * Config::TIMER_WHEEL_TICK_MS;
+  const uint32_t now = sys_now();
+  if (!isBefore(now, m_nextWakeup)) {
+    return 1;
+  }
+  return m_nextWakeup - now;
+}
+
+void TimerWheel::threadFunction(void *arg) {
+  static_cast<TimerWheel *>(arg)->run();
+}
+
+void TimerWheel::run() {
+  while (m_running) {
+    xSemaphoreTakeRecursive(m_mutex, portMAX_DELAY);
+    advance();
+    const uint32_t sleepTime = getSleepTime();
+    xSemaphoreGiveRecursive(m_mutex);
+
+    // A timeout of 0 waits until a timer is scheduled
+    sys_arch_sem_wait(&m_wakeupSem, sleepTime);
+  }
+  sys_sem_signal(&m_exitSem);
+}
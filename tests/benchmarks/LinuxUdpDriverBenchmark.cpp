@@ -0,0 +1,190 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+/*
+ * Packet rate over loopback of LinuxUdpDriver against one sendto/recvfrom
+ * per packet, which is what UdpDriver does through lwIP on a Linux port. The
+ * sender keeps at most WINDOW packets in flight, so the receive socket buffer
+ * doesn't overflow and the rate is the end-to-end one of both sides.
+ *
+ * Usage: LinuxUdpDriverBenchmark [packets per configuration]
+ */
+
+#include "rtps/communication/LinuxUdpDriver.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace rtps;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Distinct per process, so parallel benchmark runs don't share ports
+const Ip4Port_t basePort = static_cast<Ip4Port_t>(40000 + getpid() % 20000);
+constexpr uint32_t IDLE_TIMEOUT_MS = 200;
+constexpr uint32_t WINDOW = 64;
+
+struct Result {
+  uint32_t received;
+  double seconds;
+};
+
+struct RxCounter {
+  std::atomic<uint32_t> packets{0};
+  std::atomic<int64_t> lastNs{0};
+};
+
+void countPacket(void *arg, PacketInfo &) {
+  auto *counter = static_cast<RxCounter *>(arg);
+  counter->lastNs = Clock::now().time_since_epoch().count();
+  counter->packets++;
+}
+
+//! Blocks while WINDOW packets are in flight, gives up after IDLE_TIMEOUT_MS
+//! without progress
+void waitForWindow(uint32_t sent, const std::atomic<uint32_t> &received,
+                   uint32_t window) {
+  uint32_t last = received;
+  auto lastProgress = Clock::now();
+  while (sent - received >= window) {
+    if (received != last) {
+      last = received;
+      lastProgress = Clock::now();
+    } else if (Clock::now() - lastProgress >
+               std::chrono::milliseconds(IDLE_TIMEOUT_MS)) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+Result runDriver(uint32_t numPackets, uint16_t payloadSize) {
+  RxCounter counter;
+  LinuxUdpDriver driver(countPacket, &counter);
+  const Ip4Port_t port = basePort;
+  if (!driver.createUdpConnection(port)) {
+    return {0, 0};
+  }
+
+  // All packets share one buffer, only its reference count changes
+  PacketInfo packet;
+  packet.srcPort = port;
+  packet.destAddr.addr = PP_HTONL(LWIP_MAKEU32(127, 0, 0, 1));
+  packet.destPort = port;
+  packet.buffer = PBufWrapper{payloadSize};
+  std::vector<uint8_t> payload(payloadSize, 0xAB);
+  packet.buffer.append(payload.data(), payloadSize);
+
+  const auto start = Clock::now();
+  for (uint32_t i = 0; i < numPackets; ++i) {
+    waitForWindow(i, counter.packets, WINDOW);
+    driver.sendPacket(packet);
+  }
+  driver.flush();
+  waitForWindow(numPackets, counter.packets, 1);
+
+  const int64_t elapsedNs =
+      counter.lastNs - start.time_since_epoch().count();
+  return {counter.packets, elapsedNs / 1e9};
+}
+
+Result runPerPacket(uint32_t numPackets, uint16_t payloadSize) {
+  const int rxFd = socket(AF_INET, SOCK_DGRAM, 0);
+  const int txFd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(basePort + 1);
+  if (rxFd < 0 || txFd < 0 ||
+      bind(rxFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    close(rxFd);
+    close(txFd);
+    return {0, 0};
+  }
+  timeval timeout{0, IDLE_TIMEOUT_MS * 1000};
+  setsockopt(rxFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::atomic<uint32_t> received{0};
+  std::atomic<int64_t> lastNs{0};
+  std::thread receiver([&] {
+    uint8_t buffer[LinuxUdpDriver::RX_BUFFER_SIZE];
+    while (recv(rxFd, buffer, sizeof(buffer), 0) >= 0) {
+      lastNs = Clock::now().time_since_epoch().count();
+      received++;
+    }
+  });
+
+  std::vector<uint8_t> payload(payloadSize, 0xAB);
+  const auto start = Clock::now();
+  for (uint32_t i = 0; i < numPackets; ++i) {
+    waitForWindow(i, received, WINDOW);
+    sendto(txFd, payload.data(), payload.size(), 0,
+           reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+  }
+  receiver.join();
+  close(rxFd);
+  close(txFd);
+
+  return {received, (lastNs - start.time_since_epoch().count()) / 1e9};
+}
+
+bool report(const char *name, uint16_t payloadSize, uint32_t numPackets,
+            const Result &result) {
+  const double kpps =
+      result.seconds > 0 ? result.received / result.seconds / 1e3 : 0;
+  printf("%-16s %8u %12.1f %10.2f\n", name, payloadSize, kpps,
+         100.0 * (numPackets - result.received) / numPackets);
+  if (result.received == 0) {
+    printf("%s received nothing\n", name);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t numPackets =
+      argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+
+  bool success = true;
+  printf("%-16s %8s %12s %10s\n", "path", "payload", "rx kpps", "loss %");
+  for (const uint16_t payloadSize : {64, 512, 1400}) {
+    success &= report("per-packet", payloadSize, numPackets,
+                      runPerPacket(numPackets, payloadSize));
+    success &= report("LinuxUdpDriver", payloadSize, numPackets,
+                      runDriver(numPackets, payloadSize));
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
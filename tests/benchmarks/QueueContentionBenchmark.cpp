@@ -0,0 +1,134 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+/*
+ * Throughput of the thread pool queues with one producer and 1, 2 and 4
+ * consumers that dequeue in batches like the worker threads. Compares the
+ * lock-free queues against the mutex based ThreadSafeCircularBuffer.
+ *
+ * Usage: QueueContentionBenchmark [elements per configuration]
+ */
+
+#include "rtps/config.h"
+#include "rtps/storages/LockFreeCircularBuffer.h"
+#include "rtps/storages/ThreadSafeCircularBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace rtps;
+
+namespace {
+
+constexpr uint16_t QUEUE_SIZE =
+    Config::THREAD_POOL_WORKLOAD_QUEUE_LENGTH_USERTRAFFIC;
+constexpr uint32_t BATCH_SIZE = Config::THREAD_POOL_WRITER_BATCH_SIZE;
+
+template <typename Buffer>
+bool run(const char *name, uint32_t numConsumers, uint32_t numElements) {
+  auto buffer = std::make_unique<Buffer>();
+  if (!buffer->init()) {
+    fprintf(stderr, "Failed to initialize %s\n", name);
+    return false;
+  }
+
+  std::atomic<uint32_t> numReceived{0};
+  std::atomic<uint64_t> checksum{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> consumers;
+  for (uint32_t c = 0; c < numConsumers; ++c) {
+    consumers.emplace_back([&] {
+      while (!go) {
+        std::this_thread::yield();
+      }
+      uint32_t hulls[BATCH_SIZE];
+      uint64_t sum = 0;
+      while (numReceived < numElements) {
+        const uint32_t moved = buffer->moveFirstN(hulls, BATCH_SIZE);
+        if (moved == 0) {
+          std::this_thread::yield();
+          continue;
+        }
+        for (uint32_t i = 0; i < moved; ++i) {
+          sum += hulls[i];
+        }
+        numReceived += moved;
+      }
+      checksum += sum;
+    });
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  go = true;
+  uint64_t retries = 0;
+  for (uint32_t i = 1; i <= numElements; ++i) {
+    while (!buffer->copyElementIntoBuffer(i)) {
+      ++retries;
+      std::this_thread::yield();
+    }
+  }
+  for (auto &consumer : consumers) {
+    consumer.join();
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  printf("%-28s %9u %14.2f %12.3f\n", name, numConsumers,
+         numElements / seconds / 1e6,
+         static_cast<double>(retries) / numElements);
+
+  const uint64_t expected = static_cast<uint64_t>(numElements) *
+                            (static_cast<uint64_t>(numElements) + 1) / 2;
+  if (checksum != expected) {
+    printf("%s lost or duplicated elements\n", name);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t numElements =
+      argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+  bool success = true;
+  printf("%-28s %9s %14s %12s\n", "queue", "consumers", "Melements/s",
+         "full/elem");
+  success &= run<SpscCircularBuffer<uint32_t, QUEUE_SIZE>>(
+      "SpscCircularBuffer", 1, numElements);
+  for (const uint32_t numConsumers : {1u, 2u, 4u}) {
+    success &= run<MpmcCircularBuffer<uint32_t, QUEUE_SIZE>>(
+        "MpmcCircularBuffer", numConsumers, numElements);
+    success &= run<ThreadSafeCircularBuffer<uint32_t, QUEUE_SIZE>>(
+        "ThreadSafeCircularBuffer", numConsumers, numElements);
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+/*
+ * Endpoint churn on a keyed HistoryCacheWithDeletion as in the SEDP writers:
+ * half of the history holds the announcements of live endpoints, one
+ * instance each. Every round removes a random endpoint, which adds a dispose
+ * change that replaces its announcement and is dropped once sent, looks up a
+ * random sequence number as a resend would and announces a new endpoint.
+ * This leaves holes all over the history. The time per round should not
+ * depend on the history size.
+ *
+ * Usage: SedpChurnBenchmark [rounds per history size]
+ */
+
+#include "rtps/storages/HistoryCacheWithDeletion.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace rtps;
+
+namespace {
+
+constexpr DataSize_t ANNOUNCEMENT_SIZE = 128;
+const uint8_t announcement[ANNOUNCEMENT_SIZE] = {};
+
+KeyHash_t makeKey(uint32_t id) {
+  KeyHash_t key;
+  key.value[12] = static_cast<uint8_t>(id >> 24);
+  key.value[13] = static_cast<uint8_t>(id >> 16);
+  key.value[14] = static_cast<uint8_t>(id >> 8);
+  key.value[15] = static_cast<uint8_t>(id);
+  return key;
+}
+
+template <uint16_t SIZE> bool run(uint32_t numRounds) {
+  static HistoryCacheWithDeletion<SIZE, SIZE> history;
+  history.clear();
+  std::mt19937 random(SIZE);
+
+  std::vector<uint32_t> live(SIZE / 2);
+  uint32_t nextId = 0;
+  for (uint32_t &id : live) {
+    id = nextId++;
+    const KeyHash_t key = makeKey(id);
+    history.addChange(announcement, ANNOUNCEMENT_SIZE, false, false, &key);
+  }
+
+  bool success = true;
+  uint32_t numFound = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t round = 0; round < numRounds; ++round) {
+    uint32_t &id = live[random() % live.size()];
+    const KeyHash_t removed = makeKey(id);
+    const CacheChange *dispose = history.addChange(
+        announcement, ANNOUNCEMENT_SIZE, false, true, &removed);
+    if (dispose == nullptr) {
+      success = false;
+      break;
+    }
+    const SequenceNumber_t disposeSN = dispose->sequenceNumber;
+    success &= history.getNextChange(disposeSN) == dispose;
+    success &= history.dropChange(disposeSN);
+
+    SequenceNumber_t resent = history.getCurrentSeqNumMin();
+    resent.low += random() % (history.getCurrentSeqNumMax().low - resent.low);
+    numFound += history.getChangeBySN(resent) != nullptr ? 1 : 0;
+
+    id = nextId++;
+    const KeyHash_t added = makeKey(id);
+    success &= history.addChange(announcement, ANNOUNCEMENT_SIZE, false,
+                                 false, &added) != nullptr;
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  // Exactly the announcements of the live endpoints are left
+  uint32_t numLeft = 0;
+  for (const CacheChange *change = history.getNextChange({0, 0});
+       change != nullptr; ++numLeft) {
+    SequenceNumber_t next = change->sequenceNumber;
+    change = history.getNextChange(++next);
+  }
+  success &= numLeft == live.size() && history.m_dispose_after_write_cnt == 0;
+
+  printf("%8u %8zu %12.1f %12.0f %10u\n", SIZE, live.size(),
+         numRounds / seconds / 1e3, seconds / numRounds * 1e9, numFound);
+  if (!success) {
+    printf("History of size %u failed\n", SIZE);
+  }
+  history.clear();
+  return success;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t numRounds =
+      argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+
+  printf("%8s %8s %12s %12s %10s\n", "history", "live", "krounds/s",
+         "ns/round", "resends");
+  bool success = true;
+  success &= run<16>(numRounds);
+  success &= run<64>(numRounds);
+  success &= run<256>(numRounds);
+  success &= run<1024>(numRounds);
+  success &= run<4096>(numRounds);
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,173 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+/*
+ * Submessages per second through the deserializers alone and through
+ * MessageReceiver, for messages batching HEARTBEAT, ACKNACK, GAP and small
+ * DATA submessages. The messages come from the MessageFactory as a chain of
+ * pool pbufs and, for comparison, copied into a single pbuf. No endpoint is
+ * matched, so the receiver drops every submessage after looking up its
+ * addressee.
+ *
+ * Usage: SubmessageBenchmark [messages per configuration]
+ */
+
+#include "rtps/entities/Participant.h"
+#include "rtps/messages/MessageFactory.h"
+#include "rtps/messages/MessageReceiver.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace rtps;
+
+namespace {
+
+constexpr uint32_t GROUPS_PER_MESSAGE = 8;
+constexpr uint32_t SUBMESSAGES_PER_MESSAGE = 4 * GROUPS_PER_MESSAGE;
+constexpr DataSize_t PAYLOAD_SIZE = 64;
+
+const GuidPrefix_t ownPrefix = {{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}};
+const GuidPrefix_t remotePrefix = {{9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}};
+
+PBufWrapper buildMessage() {
+  const EntityId_t writerId = {{0, 0, 1},
+                               EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY};
+  const EntityId_t readerId = {{0, 0, 2},
+                               EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY};
+  PBufWrapper payload(PAYLOAD_SIZE);
+  uint8_t data[PAYLOAD_SIZE] = {};
+  payload.append(data, PAYLOAD_SIZE);
+
+  PBufWrapper message;
+  MessageFactory::addHeader(message, remotePrefix);
+  for (uint32_t i = 1; i <= GROUPS_PER_MESSAGE; ++i) {
+    MessageFactory::addHeartbeat(message, writerId, readerId, {0, 1}, {0, i},
+                                 {static_cast<int32_t>(i)});
+    SequenceNumberSet missing({0, i});
+    missing.numBits = 64;
+    missing.bitMap[0] = 0x80000001u;
+    MessageFactory::addAckNack(message, writerId, readerId, missing,
+                               {static_cast<int32_t>(i)}, false);
+    MessageFactory::addSubmessageGap(message, writerId, readerId, {0, i},
+                                     {0, i + 1});
+    message.reserve(MessageFactory::getBatchedDataSize(payload));
+    MessageFactory::addSubMessageData(message, payload, false, {0, i},
+                                      writerId, readerId, true);
+  }
+  return message;
+}
+
+//! Deserializes every submessage, returns how many succeeded
+uint32_t deserializeAll(const pbuf *chain) {
+  MessageProcessingInfo info(chain);
+  info.nextPos = Header::getRawSize();
+  uint32_t numDeserialized = 0;
+  SubmessageHeader header;
+  while (info.nextPos < info.size && deserializeMessage(info, header)) {
+    bool success = false;
+    switch (header.submessageId) {
+    case SubmessageKind::HEARTBEAT: {
+      SubmessageHeartbeat msg;
+      success = deserializeMessage(info, msg);
+      break;
+    }
+    case SubmessageKind::ACKNACK: {
+      SubmessageAckNack msg;
+      success = deserializeMessage(info, msg);
+      break;
+    }
+    case SubmessageKind::GAP: {
+      SubmessageGap msg;
+      success = deserializeMessage(info, msg);
+      break;
+    }
+    case SubmessageKind::DATA: {
+      SubmessageData msg;
+      success = deserializeMessage(info, msg);
+      break;
+    }
+    default:
+      break;
+    }
+    numDeserialized += success ? 1 : 0;
+    info.nextPos += SubmessageHeader::getRawSize() + header.octetsToNextHeader;
+  }
+  return numDeserialized;
+}
+
+template <typename FUNC>
+bool run(const char *name, const char *layout, uint32_t numMessages,
+         FUNC processMessage) {
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t numProcessed = 0;
+  for (uint32_t i = 0; i < numMessages; ++i) {
+    numProcessed += processMessage();
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  printf("%-16s %-12s %14.2f\n", name, layout,
+         numProcessed / seconds / 1e6);
+  if (numProcessed != static_cast<uint64_t>(numMessages) *
+                          SUBMESSAGES_PER_MESSAGE) {
+    printf("%s failed on %s messages\n", name, layout);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t numMessages =
+      argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+
+  PBufWrapper chained = buildMessage();
+  const uint16_t size = chained.firstElement->tot_len;
+  pbuf *contiguous = pbuf_alloc(PBUF_RAW, size, PBUF_RAM);
+  pbuf_copy(contiguous, chained.firstElement);
+
+  static Participant participant(ownPrefix, 1);
+  MessageReceiver *receiver = participant.getMessageReceiver();
+
+  bool success = true;
+  printf("%u submessages in %u bytes per message\n", SUBMESSAGES_PER_MESSAGE,
+         size);
+  printf("%-16s %-12s %14s\n", "path", "message", "Msubmsg/s");
+  const pbuf *messages[] = {contiguous, chained.firstElement};
+  for (const pbuf *message : messages) {
+    const char *layout = message == contiguous ? "contiguous" : "chained";
+    success &= run("deserializers", layout, numMessages,
+                   [&] { return deserializeAll(message); });
+    success &= run("MessageReceiver", layout, numMessages, [&] {
+      return receiver->processMessage(message) ? SUBMESSAGES_PER_MESSAGE : 0;
+    });
+  }
+
+  pbuf_free(contiguous);
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
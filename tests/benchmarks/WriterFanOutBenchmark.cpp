@@ -0,0 +1,132 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+/*
+ * Bytes a StatefulWriter copies per matched reader proxy when it sends a
+ * change. Payloads above Config::MESSAGE_BATCH_MAX_PAYLOAD_SIZE are chained
+ * into every message by reference, so for them each additional proxy may
+ * only cost the copy of its message prefix.
+ *
+ * Usage: WriterFanOutBenchmark [changes per configuration]
+ */
+
+#include "HostPort.h"
+#include "rtps/entities/StatefulWriter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace rtps;
+
+namespace {
+
+struct CountingDriver {
+  uint32_t numPackets = 0;
+
+  void sendPacket(PacketInfo &packet) {
+    if (packet.buffer.isValid()) {
+      ++numPackets;
+    }
+  }
+};
+
+struct Result {
+  double bytesCopiedPerChange;
+  double packetsPerChange;
+};
+
+Result run(uint32_t numProxies, DataSize_t payloadSize, uint32_t numChanges) {
+  CountingDriver driver;
+  auto writer = std::make_unique<StatefulWriterT<CountingDriver>>();
+  TopicData attributes;
+  attributes.reliabilityKind = ReliabilityKind_t::RELIABLE;
+  if (!writer->init(attributes, TopicKind_t::NO_KEY, nullptr, driver)) {
+    fprintf(stderr, "Failed to initialize the writer\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint32_t i = 0; i < numProxies; ++i) {
+    Guid_t guid = GUID_UNKNOWN;
+    guid.prefix.id[0] = static_cast<uint8_t>(i + 1);
+    const LocatorIPv4 locator = FullLengthLocator::createUDPv4Locator(
+        192, 168, 1, static_cast<uint8_t>(10 + i), getUserUnicastPort(0));
+    if (!writer->addNewMatchedReader(ReaderProxy{guid, locator, true})) {
+      fprintf(stderr, "Failed to add reader proxy %u\n", i);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  std::vector<uint8_t> payload(payloadSize, 0xAB);
+  hostport::resetCounters();
+  for (uint32_t i = 0; i < numChanges; ++i) {
+    writer->newChange(ChangeKind_t::ALIVE, payload.data(), payloadSize);
+    writer->progress();
+    writer->flushBatches();
+  }
+
+  const hostport::Counters counters = hostport::getCounters();
+  return Result{static_cast<double>(counters.bytesCopied) / numChanges,
+                static_cast<double>(driver.numPackets) / numChanges};
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const uint32_t numChanges = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+  const DataSize_t payloadSizes[] = {64, Config::MESSAGE_BATCH_MAX_PAYLOAD_SIZE,
+                                     1000};
+  const uint32_t maxProxies = Config::NUM_READER_PROXIES_PER_WRITER;
+
+  bool success = true;
+  printf("%8s %8s %16s %16s %16s\n", "payload", "proxies", "copied/change",
+         "copied/proxy", "packets/change");
+  for (const DataSize_t payloadSize : payloadSizes) {
+    Result single{};
+    for (uint32_t numProxies = 1; numProxies <= maxProxies; ++numProxies) {
+      const Result result = run(numProxies, payloadSize, numChanges);
+      if (numProxies == 1) {
+        single = result;
+      }
+      printf("%8u %8u %16.1f %16.1f %16.2f\n", payloadSize, numProxies,
+             result.bytesCopiedPerChange,
+             result.bytesCopiedPerChange / numProxies,
+             result.packetsPerChange);
+
+      // Each proxy beyond the first may not copy the payload again
+      const double perAdditionalProxy =
+          numProxies == 1 ? 0
+                          : (result.bytesCopiedPerChange -
+                             single.bytesCopiedPerChange) /
+                                (numProxies - 1);
+      if (Config::MESSAGE_BATCH_MAX_PAYLOAD_SIZE < payloadSize &&
+          perAdditionalProxy >= payloadSize) {
+        printf("Payload of %u bytes copied for every proxy\n", payloadSize);
+        success = false;
+      }
+    }
+  }
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
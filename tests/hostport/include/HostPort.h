@@ -0,0 +1,54 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_HOSTPORT_H
+#define RTPS_HOSTPORT_H
+
+#include <cstdint>
+
+/*
+ * Counters of the host port of FreeRTOS and lwIP, so tests and benchmarks can
+ * check what the library did below its own API.
+ */
+namespace hostport {
+
+struct Counters {
+  //! Bytes copied by pbuf_take(_at), pbuf_copy and pbuf_copy_partial
+  uint64_t bytesCopied = 0;
+  uint64_t pbufsAllocated = 0;
+  uint64_t pbufsFreed = 0;
+  uint64_t udpPacketsSent = 0;
+  uint64_t udpBytesSent = 0;
+};
+
+Counters getCounters();
+void resetCounters();
+
+//! Moves sys_now() and the tick count forward without sleeping, for code that
+//! only looks at the time
+void advanceClock(uint32_t ms);
+
+} // namespace hostport
+
+#endif // RTPS_HOSTPORT_H
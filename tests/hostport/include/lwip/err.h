@@ -0,0 +1,52 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_HOSTPORT_LWIP_ERR_H
+#define RTPS_HOSTPORT_LWIP_ERR_H
+
+#include "lwip/arch.h"
+
+typedef s8_t err_t;
+
+enum err_enum_t {
+  ERR_OK = 0,
+  ERR_MEM = -1,
+  ERR_BUF = -2,
+  ERR_TIMEOUT = -3,
+  ERR_RTE = -4,
+  ERR_INPROGRESS = -5,
+  ERR_VAL = -6,
+  ERR_WOULDBLOCK = -7,
+  ERR_USE = -8,
+  ERR_ALREADY = -9,
+  ERR_ISCONN = -10,
+  ERR_CONN = -11,
+  ERR_IF = -12,
+  ERR_ABRT = -13,
+  ERR_RST = -14,
+  ERR_CLSD = -15,
+  ERR_ARG = -16
+};
+
+#endif // RTPS_HOSTPORT_LWIP_ERR_H
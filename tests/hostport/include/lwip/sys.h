@@ -0,0 +1,66 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_HOSTPORT_LWIP_SYS_H
+#define RTPS_HOSTPORT_LWIP_SYS_H
+
+#include "FreeRTOS.h"
+#include "lwip/arch.h"
+#include "lwip/err.h"
+#include "semphr.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SYS_ARCH_TIMEOUT 0xffffffffUL
+
+typedef struct {
+  struct HostSemaphore *sem;
+} sys_sem_t;
+
+typedef void *sys_thread_t;
+typedef void (*lwip_thread_fn)(void *arg);
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count);
+void sys_sem_signal(sys_sem_t *sem);
+//! A timeout of 0 waits forever, returns SYS_ARCH_TIMEOUT on timeout
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout);
+void sys_sem_free(sys_sem_t *sem);
+int sys_sem_valid(sys_sem_t *sem);
+void sys_sem_set_invalid(sys_sem_t *sem);
+#define sys_sem_wait(sem) sys_arch_sem_wait(sem, 0)
+
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread,
+                            void *arg, int stacksize, int prio);
+
+void sys_msleep(u32_t ms);
+u32_t sys_now(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTPS_HOSTPORT_LWIP_SYS_H
@@ -0,0 +1,297 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "lwip/pbuf.h"
+
+#include "Counters.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+/*
+ * pbufs with the semantics of lwIP: reference counted, chainable and with
+ * room for the headers of the layers below in front of the payload. PBUF_POOL
+ * allocations are split into chains of PBUF_POOL_BUFSIZE segments.
+ */
+
+namespace {
+
+// Reference counts are shared between threads, like SYS_ARCH_PROTECT in lwIP
+std::mutex refMutex;
+
+u8_t *getDataStart(struct pbuf *p) { return reinterpret_cast<u8_t *>(p + 1); }
+
+struct pbuf *allocSegment(u16_t offset, u16_t length, pbuf_type type) {
+  const bool ownsPayload = type == PBUF_RAM || type == PBUF_POOL;
+  const size_t size =
+      sizeof(struct pbuf) + (ownsPayload ? offset + length : 0);
+  auto *p = static_cast<struct pbuf *>(malloc(size));
+  if (p == nullptr) {
+    return nullptr;
+  }
+  p->next = nullptr;
+  p->payload = ownsPayload ? getDataStart(p) + offset : nullptr;
+  p->tot_len = length;
+  p->len = length;
+  p->type_internal = static_cast<u8_t>(type);
+  p->flags = 0;
+  p->ref = 1;
+  ++hostport::counters::pbufsAllocated;
+  return p;
+}
+
+u16_t copyPartial(const struct pbuf *p, void *dataptr, u16_t len,
+                  u16_t offset) {
+  auto *dest = static_cast<u8_t *>(dataptr);
+  u16_t copied = 0;
+  for (const struct pbuf *q = p; q != nullptr && copied < len; q = q->next) {
+    if (offset >= q->len) {
+      offset -= q->len;
+      continue;
+    }
+    u16_t chunk = q->len - offset;
+    if (chunk > len - copied) {
+      chunk = len - copied;
+    }
+    memcpy(dest + copied, static_cast<const u8_t *>(q->payload) + offset,
+           chunk);
+    copied += chunk;
+    offset = 0;
+  }
+  return copied;
+}
+
+} // namespace
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type) {
+  const u16_t offset = static_cast<u16_t>(layer);
+  if (type != PBUF_POOL) {
+    return allocSegment(offset, length, type);
+  }
+
+  struct pbuf *head = nullptr;
+  struct pbuf *last = nullptr;
+  u16_t remaining = length;
+  u16_t segmentOffset = offset;
+  do {
+    u16_t segmentLength = PBUF_POOL_BUFSIZE - segmentOffset;
+    if (segmentLength > remaining) {
+      segmentLength = remaining;
+    }
+    struct pbuf *q = allocSegment(segmentOffset, segmentLength, type);
+    if (q == nullptr) {
+      pbuf_free(head);
+      return nullptr;
+    }
+    q->tot_len = remaining;
+    if (head == nullptr) {
+      head = q;
+    } else {
+      last->next = q;
+    }
+    last = q;
+    remaining -= segmentLength;
+    segmentOffset = 0;
+  } while (remaining != 0);
+  return head;
+}
+
+void pbuf_realloc(struct pbuf *p, u16_t size) {
+  if (size >= p->tot_len) {
+    return; // Can only shrink
+  }
+  const u16_t shrink = p->tot_len - size;
+  struct pbuf *q = p;
+  u16_t remaining = size;
+  while (remaining > q->len) {
+    remaining -= q->len;
+    q->tot_len -= shrink;
+    q = q->next;
+  }
+  q->len = remaining;
+  q->tot_len = remaining;
+  if (q->next != nullptr) {
+    pbuf_free(q->next);
+  }
+  q->next = nullptr;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+  u8_t count = 0;
+  while (p != nullptr) {
+    u16_t ref;
+    {
+      std::lock_guard<std::mutex> lock(refMutex);
+      LWIP_ASSERT("pbuf_free: p->ref > 0", p->ref > 0);
+      ref = --p->ref;
+    }
+    if (ref != 0) {
+      break; // Still used by someone else, so are the following ones
+    }
+    struct pbuf *next = p->next;
+    free(p);
+    ++hostport::counters::pbufsFreed;
+    ++count;
+    p = next;
+  }
+  return count;
+}
+
+void pbuf_ref(struct pbuf *p) {
+  if (p != nullptr) {
+    std::lock_guard<std::mutex> lock(refMutex);
+    ++p->ref;
+  }
+}
+
+u16_t pbuf_clen(const struct pbuf *p) {
+  u16_t length = 0;
+  for (; p != nullptr; p = p->next) {
+    ++length;
+  }
+  return length;
+}
+
+void pbuf_cat(struct pbuf *head, struct pbuf *tail) {
+  LWIP_ASSERT("pbuf_cat: arguments not NULL", head != nullptr && tail != nullptr);
+  struct pbuf *p = head;
+  for (; p->next != nullptr; p = p->next) {
+    p->tot_len += tail->tot_len;
+  }
+  p->tot_len += tail->tot_len;
+  p->next = tail;
+}
+
+void pbuf_chain(struct pbuf *head, struct pbuf *tail) {
+  pbuf_cat(head, tail);
+  pbuf_ref(tail);
+}
+
+u8_t pbuf_add_header(struct pbuf *p, size_t header_size_increment) {
+  const auto type = static_cast<pbuf_type>(p->type_internal);
+  if (type != PBUF_RAM && type != PBUF_POOL) {
+    return 1;
+  }
+  u8_t *payload = static_cast<u8_t *>(p->payload) - header_size_increment;
+  if (payload < getDataStart(p)) {
+    return 1;
+  }
+  p->payload = payload;
+  p->len += header_size_increment;
+  p->tot_len += header_size_increment;
+  return 0;
+}
+
+u8_t pbuf_remove_header(struct pbuf *p, size_t header_size) {
+  if (header_size > p->len) {
+    return 1;
+  }
+  p->payload = static_cast<u8_t *>(p->payload) + header_size;
+  p->len -= header_size;
+  p->tot_len -= header_size;
+  return 0;
+}
+
+err_t pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from) {
+  if (p_to == nullptr || p_from == nullptr || p_to->tot_len < p_from->tot_len) {
+    return ERR_ARG;
+  }
+  u16_t offset = 0;
+  for (const struct pbuf *q = p_from; q != nullptr; q = q->next) {
+    if (pbuf_take_at(p_to, q->payload, q->len, offset) != ERR_OK) {
+      return ERR_VAL;
+    }
+    offset += q->len;
+  }
+  return ERR_OK;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len,
+                        u16_t offset) {
+  if (p == nullptr || dataptr == nullptr) {
+    return 0;
+  }
+  const u16_t copied = copyPartial(p, dataptr, len, offset);
+  hostport::counters::bytesCopied += copied;
+  return copied;
+}
+
+void *pbuf_get_contiguous(const struct pbuf *p, void *buffer, size_t bufsize,
+                          u16_t len, u16_t offset) {
+  u16_t outOffset;
+  const struct pbuf *q =
+      pbuf_skip(const_cast<struct pbuf *>(p), offset, &outOffset);
+  if (q == nullptr) {
+    return nullptr;
+  }
+  if (q->len >= outOffset + len) {
+    return static_cast<u8_t *>(q->payload) + outOffset;
+  }
+  if (bufsize < len || pbuf_copy_partial(q, buffer, len, outOffset) != len) {
+    return nullptr;
+  }
+  return buffer;
+}
+
+err_t pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len) {
+  return pbuf_take_at(buf, dataptr, len, 0);
+}
+
+err_t pbuf_take_at(struct pbuf *buf, const void *dataptr, u16_t len,
+                   u16_t offset) {
+  if (buf == nullptr || dataptr == nullptr ||
+      buf->tot_len < static_cast<u32_t>(offset) + len) {
+    return ERR_MEM;
+  }
+  u16_t outOffset;
+  struct pbuf *q = pbuf_skip(buf, offset, &outOffset);
+  const auto *src = static_cast<const u8_t *>(dataptr);
+  u16_t remaining = len;
+  for (; q != nullptr && remaining != 0; q = q->next) {
+    u16_t chunk = q->len - outOffset;
+    if (chunk > remaining) {
+      chunk = remaining;
+    }
+    memcpy(static_cast<u8_t *>(q->payload) + outOffset, src, chunk);
+    src += chunk;
+    remaining -= chunk;
+    outOffset = 0;
+  }
+  hostport::counters::bytesCopied += len;
+  return ERR_OK;
+}
+
+struct pbuf *pbuf_skip(struct pbuf *in, u16_t in_offset, u16_t *out_offset) {
+  struct pbuf *q = in;
+  u16_t offset = in_offset;
+  while (q != nullptr && offset >= q->len) {
+    offset -= q->len;
+    q = q->next;
+  }
+  if (out_offset != nullptr) {
+    *out_offset = offset;
+  }
+  return q;
+}
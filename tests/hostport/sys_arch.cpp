@@ -0,0 +1,150 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "HostPort.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "semphr.h"
+#include "task.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+ * Mutexes and semaphores share one handle type like in FreeRTOS. Semaphores
+ * are binary, as with the lwIP port for FreeRTOS: signaling an available
+ * semaphore again has no effect.
+ */
+struct HostSemaphore {
+  std::recursive_timed_mutex mutex;
+
+  std::mutex stateMutex;
+  std::condition_variable available;
+  bool signaled = false;
+};
+
+namespace {
+
+const auto startTime = std::chrono::steady_clock::now();
+std::atomic<uint32_t> clockOffset{0};
+
+std::recursive_mutex tcpipCoreMutex;
+
+} // namespace
+
+TickType_t xTaskGetTickCount(void) { return sys_now(); }
+
+void vTaskDelay(TickType_t xTicksToDelay) { sys_msleep(xTicksToDelay); }
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+  return new HostSemaphore;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex,
+                                   TickType_t xBlockTime) {
+  if (xBlockTime == portMAX_DELAY) {
+    xMutex->mutex.lock();
+    return pdTRUE;
+  }
+  return xMutex->mutex.try_lock_for(std::chrono::milliseconds(xBlockTime))
+             ? pdTRUE
+             : pdFALSE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex) {
+  xMutex->mutex.unlock();
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore) { delete xSemaphore; }
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count) {
+  sem->sem = new HostSemaphore;
+  sem->sem->signaled = count != 0;
+  return ERR_OK;
+}
+
+void sys_sem_signal(sys_sem_t *sem) {
+  {
+    std::lock_guard<std::mutex> lock(sem->sem->stateMutex);
+    sem->sem->signaled = true;
+  }
+  sem->sem->available.notify_one();
+}
+
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout) {
+  const uint32_t start = sys_now();
+  std::unique_lock<std::mutex> lock(sem->sem->stateMutex);
+  auto isSignaled = [sem] { return sem->sem->signaled; };
+  if (timeout == 0) {
+    sem->sem->available.wait(lock, isSignaled);
+  } else if (!sem->sem->available.wait_for(
+                 lock, std::chrono::milliseconds(timeout), isSignaled)) {
+    return SYS_ARCH_TIMEOUT;
+  }
+  sem->sem->signaled = false;
+  return sys_now() - start;
+}
+
+void sys_sem_free(sys_sem_t *sem) {
+  delete sem->sem;
+  sem->sem = nullptr;
+}
+
+int sys_sem_valid(sys_sem_t *sem) { return sem->sem != nullptr; }
+
+void sys_sem_set_invalid(sys_sem_t *sem) { sem->sem = nullptr; }
+
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread,
+                            void *arg, int stacksize, int prio) {
+  LWIP_UNUSED_ARG(name);
+  LWIP_UNUSED_ARG(stacksize);
+  LWIP_UNUSED_ARG(prio);
+  // Threads of the library run until the process exits
+  std::thread handle(thread, arg);
+  sys_thread_t id = reinterpret_cast<sys_thread_t>(handle.native_handle());
+  handle.detach();
+  return id;
+}
+
+void sys_msleep(u32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+u32_t sys_now(void) {
+  return static_cast<u32_t>(
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::steady_clock::now() - startTime)
+                 .count()) +
+         clockOffset;
+}
+
+void sys_lock_tcpip_core(void) { tcpipCoreMutex.lock(); }
+
+void sys_unlock_tcpip_core(void) { tcpipCoreMutex.unlock(); }
+
+void hostport::advanceClock(uint32_t ms) { clockOffset += ms; }
@@ -0,0 +1,99 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "lwip/igmp.h"
+#include "lwip/udp.h"
+#include "rtps/config.h"
+
+#include "Counters.h"
+
+#include <cstdio>
+
+const ip_addr_t ip_addr_any = {0};
+
+namespace {
+
+struct netif makeDefaultNetif() {
+  struct netif result {};
+  const auto &ip = rtps::Config::IP_ADDRESS;
+  result.ip_addr.addr = PP_HTONL(LWIP_MAKEU32(ip[0], ip[1], ip[2], ip[3]));
+  result.netmask.addr = PP_HTONL(LWIP_MAKEU32(255, 255, 255, 0));
+  result.gw.addr = PP_HTONL(LWIP_MAKEU32(ip[0], ip[1], ip[2], 1));
+  result.mtu = 1500;
+  return result;
+}
+
+struct netif defaultNetif = makeDefaultNetif();
+
+const u16_t UDP_HLEN = 8;
+
+} // namespace
+
+struct netif *netif_default = &defaultNetif;
+
+char *ip4addr_ntoa(const ip4_addr_t *addr) {
+  static char buffer[16];
+  snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", ip4_addr1(addr),
+           ip4_addr2(addr), ip4_addr3(addr), ip4_addr4(addr));
+  return buffer;
+}
+
+struct udp_pcb *udp_new(void) {
+  return new udp_pcb{};
+}
+
+void udp_remove(struct udp_pcb *pcb) { delete pcb; }
+
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+  LWIP_UNUSED_ARG(ipaddr);
+  pcb->local_port = port;
+  return ERR_OK;
+}
+
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {
+  pcb->recv = recv;
+  pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip,
+                 u16_t dst_port) {
+  LWIP_UNUSED_ARG(pcb);
+  LWIP_UNUSED_ARG(dst_ip);
+  LWIP_UNUSED_ARG(dst_port);
+  // Like lwIP, the header goes in front of the payload of the first pbuf if
+  // there is room and is removed again once the packet was sent. Otherwise
+  // lwIP would chain a separate header pbuf, which leaves p unchanged.
+  const bool headerInPlace = pbuf_add_header(p, UDP_HLEN) == 0;
+  ++hostport::counters::udpPacketsSent;
+  hostport::counters::udpBytesSent += p->tot_len - (headerInPlace ? UDP_HLEN : 0);
+  if (headerInPlace) {
+    pbuf_remove_header(p, UDP_HLEN);
+  }
+  return ERR_OK;
+}
+
+err_t igmp_joingroup(const ip4_addr_t *ifaddr, const ip4_addr_t *groupaddr) {
+  LWIP_UNUSED_ARG(ifaddr);
+  return ip4_addr_ismulticast(groupaddr) ? ERR_OK : ERR_VAL;
+}
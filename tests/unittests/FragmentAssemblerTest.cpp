@@ -0,0 +1,274 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "HostPort.h"
+#include "rtps/storages/FragmentAssembler.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace rtps;
+
+namespace {
+
+class FragmentAssemblerTest : public ::testing::Test {
+protected:
+  static constexpr uint32_t SAMPLE_SIZE = 1000;
+  static constexpr uint16_t FRAGMENT_SIZE = 300; // 4 fragments, last is short
+
+  FragmentAssembler<2> assembler;
+  Guid_t writer{};
+  Guid_t otherWriter{};
+  std::vector<uint8_t> sample;
+  std::vector<pbuf *> pbufs;
+
+  void SetUp() override {
+    hostport::resetCounters();
+    writer.prefix.id[0] = 1;
+    otherWriter.prefix.id[0] = 2;
+    sample = makeSample(SAMPLE_SIZE);
+  }
+
+  void TearDown() override {
+    assembler.clear();
+    for (pbuf *p : pbufs) {
+      pbuf_free(p);
+    }
+    const auto counters = hostport::getCounters();
+    EXPECT_EQ(counters.pbufsAllocated, counters.pbufsFreed);
+  }
+
+  static std::vector<uint8_t> makeSample(uint32_t size) {
+    std::vector<uint8_t> data(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      data[i] = static_cast<uint8_t>(i * 7 + i / 256);
+    }
+    return data;
+  }
+
+  //! View of fragments [first, first + num) behind offset bytes of other
+  //! data, in a chain of PBUF_POOL segments if type says so
+  PBufView makeView(const std::vector<uint8_t> &data, uint16_t fragmentSize,
+                    uint32_t first, uint32_t num, DataSize_t offset = 0,
+                    pbuf_type type = PBUF_RAM) {
+    const uint32_t begin = (first - 1) * fragmentSize;
+    uint32_t end = begin + num * fragmentSize;
+    if (end > data.size()) {
+      end = static_cast<uint32_t>(data.size());
+    }
+    const auto size = static_cast<DataSize_t>(end - begin);
+    pbuf *p = pbuf_alloc(PBUF_RAW, offset + size, type);
+    pbufs.push_back(p);
+    pbuf_take_at(p, data.data() + begin, size, offset);
+    return {p, offset, size};
+  }
+
+  FragmentAssembler<2>::Sample *add(uint32_t first, uint16_t num,
+                                    const SequenceNumber_t &sn = {0, 1}) {
+    return assembler.addFragments(writer, sn, SAMPLE_SIZE, FRAGMENT_SIZE,
+                                  first, num,
+                                  makeView(sample, FRAGMENT_SIZE, first, num));
+  }
+
+  static std::vector<uint8_t> contentOf(const FragmentAssembler<2>::Sample &s) {
+    return {s.getData(), s.getData() + s.sampleSize};
+  }
+};
+
+} // namespace
+
+TEST_F(FragmentAssemblerTest, CompletesInOrder) {
+  EXPECT_EQ(add(1, 1), nullptr);
+  EXPECT_EQ(add(2, 1), nullptr);
+  EXPECT_EQ(add(3, 1), nullptr);
+  EXPECT_TRUE(assembler.isAssembling(writer, {0, 1}));
+
+  auto *complete = add(4, 1);
+  ASSERT_NE(complete, nullptr);
+  EXPECT_EQ(complete->numFragments, 4u);
+  EXPECT_EQ(contentOf(*complete), sample);
+
+  assembler.release(*complete);
+  EXPECT_FALSE(assembler.isAssembling(writer, {0, 1}));
+}
+
+TEST_F(FragmentAssemblerTest, CompletesOutOfOrderWithSeveralFragmentsAtOnce) {
+  EXPECT_EQ(add(3, 2), nullptr);
+  EXPECT_EQ(add(1, 1), nullptr);
+  auto *complete = add(2, 1);
+  ASSERT_NE(complete, nullptr);
+  EXPECT_EQ(contentOf(*complete), sample);
+}
+
+TEST_F(FragmentAssemblerTest, IgnoresDuplicateFragments) {
+  EXPECT_EQ(add(1, 2), nullptr);
+  EXPECT_EQ(add(2, 1), nullptr);
+  EXPECT_EQ(add(1, 1), nullptr);
+  EXPECT_EQ(add(3, 1), nullptr);
+  auto *complete = add(3, 2);
+  ASSERT_NE(complete, nullptr);
+  EXPECT_EQ(complete->numReceived, 4u);
+  EXPECT_EQ(contentOf(*complete), sample);
+}
+
+TEST_F(FragmentAssemblerTest, RejectsInvalidParameters) {
+  const PBufView view = makeView(sample, FRAGMENT_SIZE, 1, 1);
+  const SequenceNumber_t sn{0, 1};
+
+  EXPECT_EQ(assembler.addFragments(writer, sn, SAMPLE_SIZE, 0, 1, 1, view),
+            nullptr);
+  EXPECT_EQ(assembler.addFragments(writer, sn, SAMPLE_SIZE, FRAGMENT_SIZE, 0,
+                                   1, view),
+            nullptr);
+  EXPECT_EQ(assembler.addFragments(writer, sn, 0, FRAGMENT_SIZE, 1, 1, view),
+            nullptr);
+  EXPECT_EQ(assembler.addFragments(writer, sn, Config::FRAG_MAX_SAMPLE_SIZE + 1,
+                                   FRAGMENT_SIZE, 1, 1, view),
+            nullptr);
+  // Beyond the last fragment
+  EXPECT_EQ(assembler.addFragments(writer, sn, SAMPLE_SIZE, FRAGMENT_SIZE, 5,
+                                   1, view),
+            nullptr);
+  // More fragments than one NACK_FRAG can request
+  EXPECT_EQ(assembler.addFragments(
+                writer, sn, FragmentAssembler<2>::MAX_NUM_FRAGMENTS + 1, 1, 1,
+                1, view),
+            nullptr);
+
+  EXPECT_FALSE(assembler.isAssembling(writer, sn));
+}
+
+TEST_F(FragmentAssemblerTest, RejectsFragmentsOfMismatchingSize) {
+  EXPECT_EQ(add(1, 1), nullptr);
+
+  const PBufView view = makeView(sample, FRAGMENT_SIZE, 2, 1);
+  EXPECT_EQ(assembler.addFragments(writer, {0, 1}, SAMPLE_SIZE + 1,
+                                   FRAGMENT_SIZE, 2, 1, view),
+            nullptr);
+  EXPECT_EQ(assembler.addFragments(writer, {0, 1}, SAMPLE_SIZE,
+                                   FRAGMENT_SIZE + 1, 2, 1, view),
+            nullptr);
+
+  // The sample is untouched and still completes
+  EXPECT_EQ(add(2, 2), nullptr);
+  auto *complete = add(4, 1);
+  ASSERT_NE(complete, nullptr);
+  EXPECT_EQ(contentOf(*complete), sample);
+}
+
+TEST_F(FragmentAssemblerTest, OnlyTakesFragmentsContainedInTheData) {
+  // Claims two fragments, but only holds one and a half
+  pbuf *p = pbuf_alloc(PBUF_RAW, FRAGMENT_SIZE + FRAGMENT_SIZE / 2, PBUF_RAM);
+  pbufs.push_back(p);
+  pbuf_take(p, sample.data(), p->tot_len);
+  EXPECT_EQ(assembler.addFragments(writer, {0, 1}, SAMPLE_SIZE, FRAGMENT_SIZE,
+                                   1, 2, PBufView{p, 0, p->tot_len}),
+            nullptr);
+
+  uint32_t calls = 0;
+  assembler.forEachIncomplete(
+      writer, {0, 1},
+      [&](const SequenceNumber_t &, const FragmentNumberSet &missing) {
+        ++calls;
+        EXPECT_EQ(missing.base.value, 2u);
+      });
+  EXPECT_EQ(calls, 1u);
+}
+
+TEST_F(FragmentAssemblerTest, ReportsMissingFragments) {
+  constexpr uint16_t fragmentSize = 100; // 10 fragments
+  for (const uint32_t fragment : {1u, 2u, 5u, 10u}) {
+    assembler.addFragments(writer, {0, 3}, SAMPLE_SIZE, fragmentSize, fragment,
+                           1, makeView(sample, fragmentSize, fragment, 1));
+  }
+  // Beyond lastSN
+  add(1, 1, {0, 7});
+
+  std::vector<SequenceNumber_t> reported;
+  assembler.forEachIncomplete(
+      writer, {0, 5},
+      [&](const SequenceNumber_t &sn, const FragmentNumberSet &missing) {
+        reported.push_back(sn);
+        EXPECT_EQ(missing.base.value, 3u);
+        EXPECT_EQ(missing.numBits, 7u); // 3 to 9
+        for (uint32_t fragment = 3; fragment <= 9; ++fragment) {
+          EXPECT_EQ(missing.isSet(fragment - 3), fragment != 5) << fragment;
+        }
+      });
+  ASSERT_EQ(reported.size(), 1u);
+  EXPECT_EQ(reported[0], (SequenceNumber_t{0, 3}));
+}
+
+TEST_F(FragmentAssemblerTest, EvictsOldestSampleWhenFull) {
+  add(1, 1, {0, 1});
+  add(1, 1, {0, 2});
+  add(1, 1, {0, 3});
+
+  EXPECT_FALSE(assembler.isAssembling(writer, {0, 1}));
+  EXPECT_TRUE(assembler.isAssembling(writer, {0, 2}));
+  EXPECT_TRUE(assembler.isAssembling(writer, {0, 3}));
+
+  // Fragments of the evicted sample start over and evict the next oldest
+  EXPECT_EQ(add(2, 3, {0, 1}), nullptr);
+  EXPECT_FALSE(assembler.isAssembling(writer, {0, 2}));
+  EXPECT_TRUE(assembler.isAssembling(writer, {0, 3}));
+  EXPECT_EQ(add(1, 1, {0, 3}), nullptr);
+  auto *complete = add(1, 1, {0, 1});
+  ASSERT_NE(complete, nullptr);
+  EXPECT_EQ(contentOf(*complete), sample);
+}
+
+TEST_F(FragmentAssemblerTest, RemovesSamplesOlderThanSequenceNumber) {
+  add(1, 1, {0, 1});
+  assembler.addFragments(otherWriter, {0, 1}, SAMPLE_SIZE, FRAGMENT_SIZE, 1, 1,
+                         makeView(sample, FRAGMENT_SIZE, 1, 1));
+
+  assembler.removeOlderThan(writer, {0, 1});
+  EXPECT_TRUE(assembler.isAssembling(writer, {0, 1}));
+  assembler.removeOlderThan(writer, {0, 2});
+  EXPECT_FALSE(assembler.isAssembling(writer, {0, 1}));
+  EXPECT_TRUE(assembler.isAssembling(otherWriter, {0, 1}));
+}
+
+TEST_F(FragmentAssemblerTest, CopiesFragmentsFromChainedPbufs) {
+  constexpr uint32_t sampleSize = 3000;
+  constexpr uint16_t fragmentSize = 1400;
+  const auto large = makeSample(sampleSize);
+
+  // Both fragments cross the boundaries of 1024 byte pool segments
+  const PBufView first = makeView(large, fragmentSize, 1, 2, 100, PBUF_POOL);
+  ASSERT_NE(first.chain->next, nullptr);
+  EXPECT_EQ(assembler.addFragments(writer, {0, 1}, sampleSize, fragmentSize,
+                                   1, 2, first),
+            nullptr);
+  auto *complete = assembler.addFragments(
+      writer, {0, 1}, sampleSize, fragmentSize, 3, 1,
+      makeView(large, fragmentSize, 3, 1, 13, PBUF_POOL));
+  ASSERT_NE(complete, nullptr);
+  EXPECT_EQ(complete->data.firstElement->next, nullptr);
+  EXPECT_EQ(std::vector<uint8_t>(complete->getData(),
+                                 complete->getData() + sampleSize),
+            large);
+}
@@ -0,0 +1,550 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "HostPort.h"
+#include "rtps/storages/HistoryCacheWithDeletion.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <set>
+
+using namespace rtps;
+
+namespace {
+
+constexpr uint16_t SIZE = 8;
+
+SequenceNumber_t sn(uint32_t low) { return {0, low}; }
+
+//! Exposes the constructor that starts at a given sequence number
+template <uint16_t N>
+class TestHistory : public HistoryCacheWithDeletion<N> {
+public:
+  TestHistory() = default;
+  explicit TestHistory(SequenceNumber_t lastUsed)
+      : HistoryCacheWithDeletion<N>(lastUsed) {}
+};
+
+class HistoryCacheWithDeletionTest : public ::testing::Test {
+protected:
+  TestHistory<SIZE> history;
+  uint8_t data[4] = {};
+
+  void SetUp() override { hostport::resetCounters(); }
+
+  void TearDown() override {
+    history.clear();
+    const auto counters = hostport::getCounters();
+    EXPECT_EQ(counters.pbufsAllocated, counters.pbufsFreed);
+  }
+
+  void addChanges(uint32_t num) {
+    for (uint32_t i = 0; i < num; ++i) {
+      data[0] = static_cast<uint8_t>(history.getLastUsedSequenceNumber().low +
+                                     1);
+      ASSERT_NE(history.addChange(data, sizeof(data)), nullptr);
+    }
+  }
+
+  static uint8_t firstByte(const CacheChange *change) {
+    uint8_t byte = 0;
+    pbuf_copy_partial(change->data.firstElement, &byte, 1, 0);
+    return byte;
+  }
+};
+
+TEST_F(HistoryCacheWithDeletionTest, AddsChangesWithIncreasingSNs) {
+  EXPECT_TRUE(history.isEmpty());
+  EXPECT_EQ(history.getCurrentSeqNumMin(), SEQUENCENUMBER_UNKNOWN);
+  EXPECT_EQ(history.getCurrentSeqNumMax(), SEQUENCENUMBER_UNKNOWN);
+
+  addChanges(3);
+
+  EXPECT_FALSE(history.isEmpty());
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(1));
+  EXPECT_EQ(history.getCurrentSeqNumMax(), sn(3));
+  for (uint32_t i = 1; i <= 3; ++i) {
+    const CacheChange *change = history.getChangeBySN(sn(i));
+    ASSERT_NE(change, nullptr);
+    EXPECT_EQ(change->sequenceNumber, sn(i));
+    EXPECT_EQ(change->kind, ChangeKind_t::ALIVE);
+    EXPECT_EQ(firstByte(change), i);
+  }
+  EXPECT_EQ(history.getChangeBySN(sn(0)), nullptr);
+  EXPECT_EQ(history.getChangeBySN(sn(4)), nullptr);
+}
+
+TEST_F(HistoryCacheWithDeletionTest, DroppedChangesLeaveHoles) {
+  addChanges(5);
+
+  EXPECT_TRUE(history.dropChange(sn(2)));
+  EXPECT_TRUE(history.dropChange(sn(4)));
+  EXPECT_FALSE(history.dropChange(sn(2)));
+  EXPECT_FALSE(history.dropChange(sn(6)));
+
+  EXPECT_EQ(history.getChangeBySN(sn(2)), nullptr);
+  EXPECT_EQ(history.getChangeBySN(sn(4)), nullptr);
+  for (uint32_t i : {1, 3, 5}) {
+    const CacheChange *change = history.getChangeBySN(sn(i));
+    ASSERT_NE(change, nullptr);
+    EXPECT_EQ(firstByte(change), i);
+  }
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(1));
+
+  EXPECT_TRUE(history.dropChange(sn(1)));
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(3));
+  EXPECT_TRUE(history.dropChange(sn(5)));
+  EXPECT_EQ(history.getCurrentSeqNumMax(), sn(5))
+      << "The maximum is the last used number";
+  EXPECT_TRUE(history.dropChange(sn(3)));
+  EXPECT_TRUE(history.isEmpty());
+
+  addChanges(1);
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(6));
+}
+
+TEST_F(HistoryCacheWithDeletionTest, DroppedSlotsAreReused) {
+  // Many more changes than slots, each dropped out of order
+  for (uint32_t i = 0; i < 10 * SIZE; ++i) {
+    addChanges(2);
+    const uint32_t last = history.getLastUsedSequenceNumber().low;
+    EXPECT_TRUE(history.dropChange(sn(last - 1)));
+    EXPECT_TRUE(history.dropChange(sn(last)));
+  }
+  EXPECT_TRUE(history.isEmpty());
+  EXPECT_FALSE(history.isFull());
+  addChanges(SIZE);
+  EXPECT_TRUE(history.isFull());
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(20 * SIZE + 1));
+}
+
+TEST_F(HistoryCacheWithDeletionTest, GetNextChangeStepsOverHoles) {
+  addChanges(SIZE);
+  for (uint32_t i : {1, 3, 4, 7, 8}) {
+    ASSERT_TRUE(history.dropChange(sn(i)));
+  }
+  // Left are 2, 5 and 6
+  const uint32_t expected[] = {2, 2, 2, 5, 5, 5, 6, 0, 0, 0};
+  for (uint32_t i = 0; i < 10; ++i) {
+    const CacheChange *next = history.getNextChange(sn(i));
+    if (expected[i] == 0) {
+      EXPECT_EQ(next, nullptr) << "sn " << i;
+    } else {
+      ASSERT_NE(next, nullptr) << "sn " << i;
+      EXPECT_EQ(next->sequenceNumber, sn(expected[i])) << "sn " << i;
+    }
+  }
+}
+
+TEST_F(HistoryCacheWithDeletionTest, FullHistoryDropsOldestChange) {
+  addChanges(SIZE);
+  EXPECT_TRUE(history.isFull());
+  EXPECT_EQ(history.getChangeToEvict(nullptr), sn(1));
+
+  addChanges(2);
+
+  EXPECT_TRUE(history.isFull());
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(3));
+  EXPECT_EQ(history.getCurrentSeqNumMax(), sn(SIZE + 2));
+  EXPECT_EQ(history.getChangeBySN(sn(1)), nullptr);
+  EXPECT_EQ(history.getChangeBySN(sn(2)), nullptr);
+  EXPECT_EQ(firstByte(history.getChangeBySN(sn(SIZE + 2))), SIZE + 2);
+
+  ASSERT_TRUE(history.dropChange(sn(5)));
+  EXPECT_EQ(history.getChangeToEvict(nullptr), SEQUENCENUMBER_UNKNOWN);
+}
+
+TEST_F(HistoryCacheWithDeletionTest, RemovesChangesUpToSN) {
+  addChanges(6);
+  ASSERT_TRUE(history.dropChange(sn(2)));
+
+  history.removeUntilIncl(sn(3));
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(4));
+  EXPECT_EQ(history.getChangeBySN(sn(3)), nullptr);
+
+  history.dropOldest();
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(5));
+
+  history.removeUntilIncl(sn(100));
+  EXPECT_TRUE(history.isEmpty());
+  history.dropOldest();
+  EXPECT_TRUE(history.isEmpty());
+}
+
+TEST_F(HistoryCacheWithDeletionTest, ChecksRangeOfSNs) {
+  EXPECT_FALSE(history.isSNInRange(sn(0)));
+  addChanges(4);
+  history.dropOldest();
+
+  EXPECT_FALSE(history.isSNInRange(sn(1)));
+  EXPECT_TRUE(history.isSNInRange(sn(2)));
+  EXPECT_TRUE(history.isSNInRange(sn(4)));
+  EXPECT_FALSE(history.isSNInRange(sn(5)));
+}
+
+TEST_F(HistoryCacheWithDeletionTest, SetsKindOfChange) {
+  addChanges(2);
+  EXPECT_TRUE(
+      history.setCacheChangeKind(sn(2), ChangeKind_t::NOT_ALIVE_DISPOSED));
+  EXPECT_EQ(history.getChangeBySN(sn(2))->kind,
+            ChangeKind_t::NOT_ALIVE_DISPOSED);
+  EXPECT_EQ(history.getChangeBySN(sn(1))->kind, ChangeKind_t::ALIVE);
+  EXPECT_FALSE(
+      history.setCacheChangeKind(sn(3), ChangeKind_t::NOT_ALIVE_DISPOSED));
+}
+
+TEST_F(HistoryCacheWithDeletionTest, CountsDisposeAfterWriteChanges) {
+  for (uint32_t i = 0; i < SIZE; ++i) {
+    history.addChange(data, sizeof(data), false, i % 2 == 0);
+  }
+  EXPECT_EQ(history.m_dispose_after_write_cnt, SIZE / 2);
+
+  ASSERT_TRUE(history.dropChange(sn(3)));
+  EXPECT_EQ(history.m_dispose_after_write_cnt, SIZE / 2 - 1);
+  ASSERT_TRUE(history.dropChange(sn(4)));
+  EXPECT_EQ(history.m_dispose_after_write_cnt, SIZE / 2 - 1);
+
+  history.dropOldest();
+  EXPECT_EQ(history.m_dispose_after_write_cnt, SIZE / 2 - 2);
+
+  // Fills the history and evicts 2, which isn't disposed after write, and 5
+  for (uint32_t i = 0; i < 5; ++i) {
+    history.addChange(data, sizeof(data), false, false);
+  }
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(6));
+  EXPECT_EQ(history.m_dispose_after_write_cnt, SIZE / 2 - 3);
+
+  history.clear();
+  EXPECT_EQ(history.m_dispose_after_write_cnt, 0u);
+}
+
+TEST_F(HistoryCacheWithDeletionTest, ClearStartsOver) {
+  addChanges(SIZE + 3);
+  history.setCountedRange(sn(5), sn(8));
+
+  history.clear();
+
+  EXPECT_TRUE(history.isEmpty());
+  EXPECT_EQ(history.getLastUsedSequenceNumber(), sn(0));
+  EXPECT_EQ(history.getNumCountedChanges(), 0);
+  EXPECT_EQ(history.getChangeBySN(sn(5)), nullptr);
+  addChanges(1);
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(1));
+  EXPECT_NE(history.getChangeBySN(sn(1)), nullptr);
+}
+
+TEST_F(HistoryCacheWithDeletionTest, CountedRangeFollowsChanges) {
+  addChanges(6);
+  history.setCountedRange(sn(2), sn(5));
+  EXPECT_EQ(history.getNumCountedChanges(), 3);
+
+  ASSERT_TRUE(history.dropChange(sn(3)));
+  EXPECT_EQ(history.getNumCountedChanges(), 2);
+  ASSERT_TRUE(history.dropChange(sn(6)));
+  EXPECT_EQ(history.getNumCountedChanges(), 2);
+
+  history.setCountedRange(sn(2), sn(9));
+  EXPECT_EQ(history.getNumCountedChanges(), 3);
+  addChanges(2); // 7 and 8
+  EXPECT_EQ(history.getNumCountedChanges(), 5);
+  addChanges(1); // 9
+  EXPECT_EQ(history.getNumCountedChanges(), 5);
+
+  history.removeUntilIncl(sn(4));
+  EXPECT_EQ(history.getNumCountedChanges(), 3); // 5, 7 and 8
+}
+
+TEST_F(HistoryCacheWithDeletionTest, CountedRangeMatchesBruteForce) {
+  std::mt19937 random(42);
+  std::set<uint32_t> present;
+  uint32_t first = 1;
+  uint32_t end = 1;
+
+  for (uint32_t step = 0; step < 5000; ++step) {
+    const uint32_t last = history.getLastUsedSequenceNumber().low;
+    switch (random() % 4) {
+    case 0:
+    case 1:
+      if (history.isFull()) {
+        present.erase(present.begin());
+      }
+      addChanges(1);
+      present.insert(last + 1);
+      break;
+    case 2:
+      if (!present.empty()) {
+        const uint32_t dropped = last - random() % (2 * SIZE);
+        EXPECT_EQ(history.dropChange(sn(dropped)), present.erase(dropped) == 1);
+      }
+      break;
+    default: {
+      // Moves both bounds forth and back around the present changes
+      first = last > 2 * SIZE ? last - random() % (2 * SIZE) : 1;
+      end = first + random() % (2 * SIZE);
+      history.setCountedRange(sn(first), sn(end));
+      break;
+    }
+    }
+
+    const auto counted =
+        std::distance(present.lower_bound(first), present.lower_bound(end));
+    ASSERT_EQ(history.getNumCountedChanges(), counted) << "step " << step;
+
+    const auto next = present.lower_bound(first);
+    const CacheChange *change = history.getNextChange(sn(first));
+    if (next == present.end()) {
+      ASSERT_EQ(change, nullptr) << "step " << step;
+    } else {
+      ASSERT_NE(change, nullptr) << "step " << step;
+      ASSERT_EQ(change->sequenceNumber, sn(*next)) << "step " << step;
+    }
+  }
+}
+
+TEST_F(HistoryCacheWithDeletionTest, FindsChangesAcrossLowWordOverflow) {
+  TestHistory<SIZE> wrapping({0, UINT32_MAX - 2});
+  for (uint32_t i = 0; i < 6; ++i) {
+    ASSERT_NE(wrapping.addChange(data, sizeof(data)), nullptr);
+  }
+  ASSERT_TRUE(wrapping.dropChange({1, 0}));
+
+  const SequenceNumber_t beforeOverflow{0, UINT32_MAX};
+  const SequenceNumber_t afterOverflow{1, 1};
+  EXPECT_EQ(wrapping.getCurrentSeqNumMin(),
+            SequenceNumber_t({0, UINT32_MAX - 1}));
+  EXPECT_EQ(wrapping.getCurrentSeqNumMax(), SequenceNumber_t({1, 3}));
+  EXPECT_NE(wrapping.getChangeBySN(beforeOverflow), nullptr);
+  EXPECT_EQ(wrapping.getChangeBySN({1, 0}), nullptr);
+  ASSERT_NE(wrapping.getNextChange({1, 0}), nullptr);
+  EXPECT_EQ(wrapping.getNextChange({1, 0})->sequenceNumber, afterOverflow);
+  wrapping.clear();
+}
+
+class KeyedHistoryCacheWithDeletionTest : public ::testing::Test {
+protected:
+  static constexpr uint16_t MAX_INSTANCES = 3;
+
+  HistoryCacheWithDeletion<SIZE, MAX_INSTANCES> history;
+  uint8_t data[4] = {};
+
+  void SetUp() override { hostport::resetCounters(); }
+
+  void TearDown() override {
+    history.clear();
+    const auto counters = hostport::getCounters();
+    EXPECT_EQ(counters.pbufsAllocated, counters.pbufsFreed);
+  }
+
+  static KeyHash_t key(uint8_t id) {
+    KeyHash_t key;
+    key.value[15] = id;
+    return key;
+  }
+
+  //! Adds a change of the given instance, returns its sequence number
+  uint32_t add(uint8_t id, bool disposeAfterWrite = false) {
+    const KeyHash_t instance = key(id);
+    const CacheChange *change = history.addChange(data, sizeof(data), false,
+                                                  disposeAfterWrite, &instance);
+    EXPECT_NE(change, nullptr);
+    return change == nullptr ? 0 : change->sequenceNumber.low;
+  }
+
+  bool contains(uint32_t low) {
+    return history.getChangeBySN(sn(low)) != nullptr;
+  }
+};
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, KeepsLastChangesPerInstance) {
+  history.setInstanceDepth(2);
+  add(1); // 1
+  add(2); // 2
+  add(1); // 3
+  add(1); // 4, drops 1
+
+  EXPECT_FALSE(contains(1));
+  EXPECT_TRUE(contains(2));
+  EXPECT_TRUE(contains(3));
+  EXPECT_TRUE(contains(4));
+
+  add(2); // 5
+  add(2); // 6, drops 2
+  EXPECT_FALSE(contains(2));
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(3));
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, DepthOfZeroKeepsLatestChange) {
+  history.setInstanceDepth(0);
+  add(1);
+  add(1);
+  add(1);
+  EXPECT_EQ(history.getCurrentSeqNumMin(), sn(3));
+  EXPECT_TRUE(contains(3));
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, KeepsChangesWithoutInstance) {
+  history.setInstanceDepth(1);
+  history.addChange(data, sizeof(data));
+  add(1);
+  history.addChange(data, sizeof(data));
+  add(1); // 4, drops 2
+
+  EXPECT_TRUE(contains(1));
+  EXPECT_FALSE(contains(2));
+  EXPECT_TRUE(contains(3));
+  EXPECT_TRUE(contains(4));
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, DropsFromMiddleOfInstance) {
+  history.setInstanceDepth(3);
+  add(1); // 1
+  add(1); // 2
+  add(1); // 3
+  ASSERT_TRUE(history.dropChange(sn(3)));
+  add(1); // 4
+  add(1); // 5, drops 1
+  EXPECT_FALSE(contains(1));
+
+  ASSERT_TRUE(history.dropChange(sn(4)));
+  add(1); // 6
+  EXPECT_TRUE(contains(2));
+  add(1); // 7, drops 2
+  EXPECT_FALSE(contains(2));
+  EXPECT_TRUE(contains(5));
+  EXPECT_TRUE(contains(6));
+  EXPECT_TRUE(contains(7));
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, RejectsInstancesBeyondLimit) {
+  for (uint8_t id = 1; id <= MAX_INSTANCES; ++id) {
+    add(id);
+  }
+  const KeyHash_t another = key(MAX_INSTANCES + 1);
+  EXPECT_EQ(history.addChange(data, sizeof(data), false, false, &another),
+            nullptr);
+  EXPECT_EQ(history.getLastUsedSequenceNumber(), sn(MAX_INSTANCES));
+
+  // Known instances and changes without one are still accepted
+  add(1);
+  EXPECT_NE(history.addChange(data, sizeof(data)), nullptr);
+
+  // Dropping all changes of an instance makes room for another one
+  ASSERT_TRUE(history.dropChange(sn(2)));
+  EXPECT_NE(history.addChange(data, sizeof(data), false, false, &another),
+            nullptr);
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, ReusesInstancesOfDroppedChanges) {
+  // Many more instances than fit at once, each disposed and dropped as SEDP
+  // does for removed endpoints
+  uint8_t live[MAX_INSTANCES] = {1, 2, 3};
+  for (uint8_t id : live) {
+    add(id);
+  }
+  for (uint8_t id = MAX_INSTANCES + 1; id < 200; ++id) {
+    uint8_t &removed = live[id % MAX_INSTANCES];
+    const uint32_t dispose = add(removed, true);
+    ASSERT_NE(dispose, 0u);
+    ASSERT_TRUE(history.dropChange(sn(dispose)));
+    removed = id;
+    ASSERT_NE(add(id), 0u);
+  }
+  EXPECT_EQ(history.m_dispose_after_write_cnt, 0u);
+
+  uint32_t numLeft = 0;
+  for (uint32_t low = 0; low <= history.getLastUsedSequenceNumber().low;
+       ++low) {
+    numLeft += contains(low) ? 1 : 0;
+  }
+  EXPECT_EQ(numLeft, MAX_INSTANCES);
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, FullHistoryKeepsLatestOfInstances) {
+  history.setInstanceDepth(SIZE);
+  add(1); // 1
+  for (uint32_t i = 0; i < SIZE - 1; ++i) {
+    add(2); // 2 to 8
+  }
+  ASSERT_TRUE(history.isFull());
+
+  // 1 is the only change of its instance
+  const KeyHash_t first = key(1);
+  const KeyHash_t second = key(2);
+  const KeyHash_t third = key(3);
+  EXPECT_EQ(history.getChangeToEvict(&first), sn(2));
+  EXPECT_EQ(history.getChangeToEvict(&second), sn(2));
+  EXPECT_EQ(history.getChangeToEvict(&third), sn(2));
+  EXPECT_EQ(history.getChangeToEvict(nullptr), sn(2));
+
+  add(3); // 9, drops 2
+  EXPECT_TRUE(contains(1));
+  EXPECT_FALSE(contains(2));
+  add(1); // 10, drops 3
+  EXPECT_TRUE(contains(1));
+  EXPECT_FALSE(contains(3));
+  add(1); // 11, drops 1 as instance 1 has a newer change now
+  EXPECT_FALSE(contains(1));
+  EXPECT_TRUE(contains(4));
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, FullHistoryOfLatestDropsOldest) {
+  history.setInstanceDepth(SIZE);
+  add(1); // 1
+  add(2); // 2
+  for (uint32_t i = 0; i < SIZE - 2; ++i) {
+    history.addChange(data, sizeof(data)); // 3 to 8
+  }
+  ASSERT_TRUE(history.isFull());
+
+  // No instance has more than its latest change, the oldest goes
+  EXPECT_EQ(history.getChangeToEvict(nullptr), sn(1));
+  add(3);
+  EXPECT_FALSE(contains(1));
+  EXPECT_TRUE(contains(2));
+}
+
+TEST_F(KeyedHistoryCacheWithDeletionTest, InstanceAtDepthEvictsItself) {
+  history.setInstanceDepth(2);
+  const KeyHash_t first = key(1);
+  EXPECT_EQ(history.getChangeToEvict(&first), SEQUENCENUMBER_UNKNOWN);
+
+  add(1); // 1
+  add(1); // 2
+  for (uint32_t i = 0; i < SIZE - 2; ++i) {
+    history.addChange(data, sizeof(data)); // 3 to 8
+  }
+  ASSERT_TRUE(history.isFull());
+
+  EXPECT_EQ(history.getChangeToEvict(&first), SEQUENCENUMBER_UNKNOWN);
+  const KeyHash_t second = key(2);
+  EXPECT_EQ(history.getChangeToEvict(&second), sn(1));
+
+  add(1); // 9, drops 1 of its own
+  EXPECT_TRUE(history.isFull());
+  EXPECT_FALSE(contains(1));
+  EXPECT_TRUE(contains(3));
+}
+
+} // namespace
@@ -0,0 +1,182 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "HostPort.h"
+#include "rtps/communication/LinuxUdpDriver.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+using namespace rtps;
+
+namespace {
+
+struct Received {
+  Ip4Port_t srcPort;
+  Ip4Port_t destPort;
+  std::vector<uint8_t> data;
+};
+
+class LinuxUdpDriverTest : public ::testing::Test {
+protected:
+  // Distinct per process, so parallel test runs don't share ports
+  const Ip4Port_t rxPort = static_cast<Ip4Port_t>(20000 + getpid() % 20000);
+  const Ip4Port_t txPort = rxPort + 1;
+  const ip4_addr_t loopback = {PP_HTONL(LWIP_MAKEU32(127, 0, 0, 1))};
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<Received> received;
+
+  LinuxUdpDriver driver{receiveJumppad, this};
+
+  static void receiveJumppad(void *arg, PacketInfo &packet) {
+    auto *test = static_cast<LinuxUdpDriverTest *>(arg);
+    Received entry{packet.srcPort, packet.destPort, {}};
+    entry.data.resize(packet.buffer.firstElement->tot_len);
+    pbuf_copy_partial(packet.buffer.firstElement, entry.data.data(),
+                      entry.data.size(), 0);
+    {
+      std::lock_guard<std::mutex> lock(test->mutex);
+      test->received.push_back(std::move(entry));
+    }
+    test->condition.notify_all();
+  }
+
+  bool waitForPackets(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return condition.wait_for(lock, std::chrono::seconds(2),
+                              [&] { return received.size() >= count; });
+  }
+
+  //! Fills packet with the given payload split into numSegments pbufs
+  void makePacket(PacketInfo &packet, const std::vector<uint8_t> &payload,
+                  uint16_t numSegments) {
+    packet.srcPort = txPort;
+    packet.destAddr = loopback;
+    packet.destPort = rxPort;
+    const size_t segmentSize = payload.size() / numSegments;
+    size_t offset = 0;
+    for (uint16_t i = 0; i < numSegments; ++i) {
+      const size_t size =
+          (i + 1 == numSegments) ? payload.size() - offset : segmentSize;
+      PBufWrapper segment{static_cast<DataSize_t>(size)};
+      segment.append(payload.data() + offset, static_cast<DataSize_t>(size));
+      if (packet.buffer.isValid()) {
+        packet.buffer.append(segment);
+      } else {
+        packet.buffer = std::move(segment);
+      }
+      offset += size;
+    }
+  }
+
+  static std::vector<uint8_t> makePayload(size_t size, uint8_t seed) {
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; ++i) {
+      payload[i] = static_cast<uint8_t>(seed + i);
+    }
+    return payload;
+  }
+
+  void SetUp() override { ASSERT_TRUE(driver.createUdpConnection(rxPort)); }
+};
+
+} // namespace
+
+TEST_F(LinuxUdpDriverTest, DeliversPacketOverLoopback) {
+  const auto payload = makePayload(100, 1);
+  PacketInfo packet;
+  makePacket(packet, payload, 1);
+  driver.sendPacket(packet);
+  driver.flush();
+
+  ASSERT_TRUE(waitForPackets(1));
+  EXPECT_EQ(received[0].data, payload);
+  EXPECT_EQ(received[0].srcPort, txPort);
+  EXPECT_EQ(received[0].destPort, rxPort);
+}
+
+TEST_F(LinuxUdpDriverTest, SendsChainedPbufsWithoutCopying) {
+  const auto payload = makePayload(800, 2);
+  PacketInfo packet;
+  makePacket(packet, payload, LinuxUdpDriver::MAX_IOV_PER_PACKET);
+
+  hostport::resetCounters();
+  driver.sendPacket(packet);
+  driver.flush();
+  EXPECT_EQ(hostport::getCounters().bytesCopied, 0u);
+
+  ASSERT_TRUE(waitForPackets(1));
+  EXPECT_EQ(received[0].data, payload);
+}
+
+TEST_F(LinuxUdpDriverTest, FlattensChainsWithTooManyPbufs) {
+  const auto payload = makePayload(1200, 3);
+  PacketInfo packet;
+  makePacket(packet, payload, 2 * LinuxUdpDriver::MAX_IOV_PER_PACKET);
+  driver.sendPacket(packet);
+  driver.flush();
+
+  ASSERT_TRUE(waitForPackets(1));
+  EXPECT_EQ(received[0].data, payload);
+}
+
+TEST_F(LinuxUdpDriverTest, KeepsOrderOfQueuedPackets) {
+  // More than fit into one sendmmsg batch
+  const uint32_t numPackets = 3 * LinuxUdpDriver::TX_BATCH_SIZE;
+  for (uint32_t i = 0; i < numPackets; ++i) {
+    PacketInfo packet;
+    makePacket(packet, makePayload(16, static_cast<uint8_t>(i)), 1);
+    driver.sendPacket(packet);
+  }
+  driver.flush();
+
+  ASSERT_TRUE(waitForPackets(numPackets));
+  for (uint32_t i = 0; i < numPackets; ++i) {
+    EXPECT_EQ(received[i].data[0], static_cast<uint8_t>(i));
+  }
+}
+
+TEST_F(LinuxUdpDriverTest, CallerKeepsItsReference) {
+  const auto payload = makePayload(64, 4);
+  PacketInfo packet;
+  makePacket(packet, payload, 1);
+  driver.sendPacket(packet);
+  driver.flush();
+  ASSERT_TRUE(waitForPackets(1));
+
+  // The same buffer can be sent again
+  ASSERT_TRUE(packet.buffer.isValid());
+  EXPECT_EQ(packet.buffer.firstElement->ref, 1);
+  driver.sendPacket(packet);
+  driver.flush();
+  ASSERT_TRUE(waitForPackets(2));
+  EXPECT_EQ(received[1].data, payload);
+}
@@ -0,0 +1,247 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "rtps/storages/LockFreeCircularBuffer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using rtps::MpmcCircularBuffer;
+using rtps::SpscCircularBuffer;
+
+template <typename Buffer> class CircularBufferTest : public ::testing::Test {
+protected:
+  Buffer buffer;
+
+  void SetUp() override { ASSERT_TRUE(buffer.init()); }
+};
+
+// Both capacities are exactly 8, the MPMC one is rounded up to a power of two
+using BufferTypes = ::testing::Types<MpmcCircularBuffer<uint32_t, 8>,
+                                     SpscCircularBuffer<uint32_t, 8>>;
+TYPED_TEST_SUITE(CircularBufferTest, BufferTypes);
+
+TYPED_TEST(CircularBufferTest, StartsEmpty) {
+  uint32_t hull = 0;
+  EXPECT_EQ(this->buffer.numElements(), 0u);
+  EXPECT_FALSE(this->buffer.moveFirstInto(hull));
+  EXPECT_EQ(this->buffer.moveFirstN(&hull, 1), 0u);
+}
+
+TYPED_TEST(CircularBufferTest, KeepsInsertionOrder) {
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_TRUE(this->buffer.copyElementIntoBuffer(i));
+  }
+  EXPECT_EQ(this->buffer.numElements(), 5u);
+  for (uint32_t i = 0; i < 5; ++i) {
+    uint32_t hull = 0;
+    ASSERT_TRUE(this->buffer.moveFirstInto(hull));
+    EXPECT_EQ(hull, i);
+  }
+  EXPECT_EQ(this->buffer.numElements(), 0u);
+}
+
+TYPED_TEST(CircularBufferTest, RejectsInsertionWhenFull) {
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(this->buffer.copyElementIntoBuffer(i));
+  }
+  EXPECT_FALSE(this->buffer.copyElementIntoBuffer(8));
+  EXPECT_FALSE(this->buffer.moveElementIntoBuffer(9));
+  EXPECT_EQ(this->buffer.insertionFailures(), 2u);
+  EXPECT_EQ(this->buffer.numElements(), 8u);
+
+  // Room for one again
+  uint32_t hull = 0;
+  ASSERT_TRUE(this->buffer.moveFirstInto(hull));
+  EXPECT_EQ(hull, 0u);
+  EXPECT_TRUE(this->buffer.copyElementIntoBuffer(10));
+  EXPECT_FALSE(this->buffer.copyElementIntoBuffer(11));
+}
+
+TYPED_TEST(CircularBufferTest, WrapsAroundManyTimes) {
+  uint32_t next = 0;
+  uint32_t expected = 0;
+  for (uint32_t round = 0; round < 1000; ++round) {
+    // Varying fill levels move the wrap point through all slots
+    const uint32_t count = 1 + round % 8;
+    for (uint32_t i = 0; i < count; ++i) {
+      ASSERT_TRUE(this->buffer.copyElementIntoBuffer(next++));
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      uint32_t hull = 0;
+      ASSERT_TRUE(this->buffer.moveFirstInto(hull));
+      ASSERT_EQ(hull, expected++);
+    }
+  }
+  EXPECT_EQ(this->buffer.numElements(), 0u);
+  EXPECT_EQ(this->buffer.insertionFailures(), 0u);
+}
+
+TYPED_TEST(CircularBufferTest, MovesUpToNElements) {
+  for (uint32_t i = 0; i < 6; ++i) {
+    ASSERT_TRUE(this->buffer.copyElementIntoBuffer(i));
+  }
+  uint32_t hulls[8] = {};
+  ASSERT_EQ(this->buffer.moveFirstN(hulls, 4), 4u);
+  EXPECT_EQ(hulls[0], 0u);
+  EXPECT_EQ(hulls[3], 3u);
+  ASSERT_EQ(this->buffer.moveFirstN(hulls, 8), 2u);
+  EXPECT_EQ(hulls[0], 4u);
+  EXPECT_EQ(hulls[1], 5u);
+  EXPECT_EQ(this->buffer.moveFirstN(hulls, 8), 0u);
+}
+
+TYPED_TEST(CircularBufferTest, ClearDrainsAllElements) {
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(this->buffer.copyElementIntoBuffer(i));
+  }
+  this->buffer.clear();
+  EXPECT_EQ(this->buffer.numElements(), 0u);
+  uint32_t hull = 0;
+  EXPECT_FALSE(this->buffer.moveFirstInto(hull));
+  EXPECT_TRUE(this->buffer.copyElementIntoBuffer(42));
+  ASSERT_TRUE(this->buffer.moveFirstInto(hull));
+  EXPECT_EQ(hull, 42u);
+}
+
+TEST(MpmcCircularBufferTest, RoundsCapacityUpToPowerOfTwo) {
+  MpmcCircularBuffer<uint32_t, 5> buffer;
+  ASSERT_TRUE(buffer.init());
+  uint32_t inserted = 0;
+  while (buffer.copyElementIntoBuffer(inserted)) {
+    ++inserted;
+  }
+  EXPECT_EQ(inserted, 8u);
+}
+
+TEST(MpmcCircularBufferTest, MovesResponsibilityForResources) {
+  MpmcCircularBuffer<std::unique_ptr<int>, 4> buffer;
+  ASSERT_TRUE(buffer.init());
+  ASSERT_TRUE(buffer.moveElementIntoBuffer(std::make_unique<int>(7)));
+  std::unique_ptr<int> hull;
+  ASSERT_TRUE(buffer.moveFirstInto(hull));
+  ASSERT_NE(hull, nullptr);
+  EXPECT_EQ(*hull, 7);
+}
+
+TEST(SpscCircularBufferTest, PeakFirstKeepsTheElement) {
+  SpscCircularBuffer<uint32_t, 4> buffer;
+  ASSERT_TRUE(buffer.init());
+  uint32_t hull = 0;
+  EXPECT_FALSE(buffer.peakFirst(hull));
+  ASSERT_TRUE(buffer.copyElementIntoBuffer(3));
+  ASSERT_TRUE(buffer.copyElementIntoBuffer(4));
+  ASSERT_TRUE(buffer.peakFirst(hull));
+  EXPECT_EQ(hull, 3u);
+  EXPECT_EQ(buffer.numElements(), 2u);
+  ASSERT_TRUE(buffer.moveFirstInto(hull));
+  EXPECT_EQ(hull, 3u);
+}
+
+TEST(MpmcCircularBufferTest, DeliversEveryElementOnceUnderContention) {
+  constexpr uint32_t numProducers = 4;
+  constexpr uint32_t numConsumers = 4;
+  constexpr uint32_t perProducer = 10000;
+  static MpmcCircularBuffer<uint32_t, 64> buffer;
+  ASSERT_TRUE(buffer.init());
+
+  std::vector<std::atomic<uint8_t>> received(numProducers * perProducer);
+  std::atomic<uint32_t> numReceived{0};
+  std::atomic<bool> sizeInRange{true};
+  std::vector<std::thread> threads;
+
+  for (uint32_t p = 0; p < numProducers; ++p) {
+    threads.emplace_back([p] {
+      for (uint32_t i = 0; i < perProducer; ++i) {
+        while (!buffer.copyElementIntoBuffer(p * perProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (uint32_t c = 0; c < numConsumers; ++c) {
+    threads.emplace_back([&] {
+      uint32_t hulls[8];
+      while (numReceived < numProducers * perProducer) {
+        const uint32_t moved = buffer.moveFirstN(hulls, 8);
+        if (moved == 0) {
+          std::this_thread::yield();
+        }
+        for (uint32_t i = 0; i < moved; ++i) {
+          received[hulls[i]]++;
+        }
+        numReceived += moved;
+        if (buffer.numElements() > 64) {
+          sizeInRange = false;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(numReceived, numProducers * perProducer);
+  EXPECT_TRUE(std::all_of(received.begin(), received.end(),
+                          [](const std::atomic<uint8_t> &count) {
+                            return count == 1;
+                          }));
+  EXPECT_TRUE(sizeInRange);
+  EXPECT_EQ(buffer.numElements(), 0u);
+}
+
+TEST(SpscCircularBufferTest, KeepsOrderAcrossThreads) {
+  constexpr uint32_t numElements = 100000;
+  static SpscCircularBuffer<uint32_t, 16> buffer;
+  ASSERT_TRUE(buffer.init());
+
+  std::thread producer([] {
+    for (uint32_t i = 0; i < numElements; ++i) {
+      while (!buffer.copyElementIntoBuffer(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  bool inOrder = true;
+  uint32_t hulls[4];
+  while (expected < numElements) {
+    const uint32_t moved = buffer.moveFirstN(hulls, 4);
+    if (moved == 0) {
+      std::this_thread::yield();
+    }
+    for (uint32_t i = 0; i < moved; ++i) {
+      inOrder = inOrder && hulls[i] == expected;
+      ++expected;
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(inOrder);
+}
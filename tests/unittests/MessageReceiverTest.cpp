@@ -0,0 +1,97 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "RawMessage.h"
+#include "rtps/entities/Participant.h"
+
+#include <gtest/gtest.h>
+
+using namespace rtps;
+using rtps::test::Chain;
+using rtps::test::RawMessage;
+
+namespace {
+
+class MessageReceiverTest : public ::testing::Test {
+protected:
+  const GuidPrefix_t ownPrefix = {{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}};
+  const GuidPrefix_t remotePrefix = {{9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9}};
+  Participant participant{ownPrefix, 1};
+  RawMessage msg{IS_LITTLE_ENDIAN != 0};
+
+  bool process(uint16_t segmentSize = 0xFFFF) {
+    Chain chain(msg.bytes, segmentSize);
+    return participant.getMessageReceiver()->processMessage(chain.get());
+  }
+
+  void addInfoDst() {
+    msg.begin(SubmessageKind::INFO_DST);
+    msg.bytes.insert(msg.bytes.end(), ownPrefix.id.begin(),
+                     ownPrefix.id.end());
+    msg.end();
+  }
+
+  void addHeartbeat() {
+    msg.begin(SubmessageKind::HEARTBEAT)
+        .entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+        .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+        .sn(0, 1)
+        .sn(0, 1)
+        .u32(1)
+        .end();
+  }
+};
+
+} // namespace
+
+TEST_F(MessageReceiverTest, ProcessesAllSubmessages) {
+  msg.header(remotePrefix);
+  addInfoDst();
+  addHeartbeat();
+  EXPECT_TRUE(process());
+  EXPECT_TRUE(process(10));
+  EXPECT_EQ(participant.getMessageReceiver()->sourceGuidPrefix, remotePrefix);
+}
+
+TEST_F(MessageReceiverTest, DropsOwnMessages) {
+  msg.header(ownPrefix);
+  addInfoDst();
+  EXPECT_FALSE(process());
+}
+
+TEST_F(MessageReceiverTest, StopsAtSubmessageExceedingTheMessage) {
+  msg.header(remotePrefix);
+  addInfoDst();
+  msg.begin(SubmessageKind::INFO_TS).u32(0).u32(0).end(1);
+  EXPECT_FALSE(process());
+}
+
+TEST_F(MessageReceiverTest, StopsAtLengthThatWouldWrapAround) {
+  msg.header(remotePrefix);
+  // Advancing by 0xFFFF + 4 would move the position back by one
+  msg.begin(SubmessageKind::INFO_TS).setLength(0xFFFF);
+  msg.u32(0).u32(0);
+  addHeartbeat();
+  EXPECT_FALSE(process());
+}
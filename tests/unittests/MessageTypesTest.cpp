@@ -0,0 +1,401 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "RawMessage.h"
+#include "rtps/messages/MessageTypes.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace rtps;
+using rtps::test::Chain;
+using rtps::test::RawMessage;
+
+namespace {
+
+class MessageTypesTest : public ::testing::TestWithParam<bool> {
+protected:
+  RawMessage msg{GetParam()};
+
+  template <typename Submessage>
+  bool deserialize(Submessage &result, uint16_t segmentSize = 0xFFFF,
+                   DataSize_t offset = 0) {
+    Chain chain(msg.bytes, segmentSize);
+    MessageProcessingInfo info(chain.get());
+    info.nextPos = offset;
+    return deserializeMessage(info, result);
+  }
+
+  void writeHeartbeat() {
+    msg.entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+        .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+        .sn(0, 3)
+        .sn(1, 7)
+        .u32(42);
+  }
+
+  //! readerSNState with base 5 and 40 bits, count 9
+  void writeAckNack(uint32_t numBits = 40) {
+    msg.entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+        .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+        .sn(0, 5)
+        .u32(numBits);
+    for (uint32_t i = 0; i < (numBits + 31) / 32; ++i) {
+      msg.u32(0x80000001u + i);
+    }
+    msg.u32(9);
+  }
+
+  //! Gap from 4 up to the list starting at 10 with 33 bits
+  void writeGap() {
+    msg.entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+        .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+        .sn(0, 4)
+        .sn(0, 10)
+        .u32(33)
+        .u32(0xA0000000u)
+        .u32(0x80000000u);
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(ByteOrders, MessageTypesTest, ::testing::Bool(),
+                         [](const ::testing::TestParamInfo<bool> &info) {
+                           return info.param ? "LittleEndian" : "BigEndian";
+                         });
+
+} // namespace
+
+TEST_P(MessageTypesTest, Header) {
+  msg.u8('R').u8('T').u8('P').u8('S').u8(2).u8(2).u8(1).u8(15);
+  for (uint8_t i = 0; i < 12; ++i) {
+    msg.u8(i);
+  }
+  Header header;
+  ASSERT_TRUE(deserialize(header));
+  EXPECT_EQ(header.protocolName, RTPS_PROTOCOL_NAME);
+  EXPECT_EQ(header.protocolVersion.major, 2);
+  EXPECT_EQ(header.vendorId.vendorId[1], 15);
+  EXPECT_EQ(header.guidPrefix.id[11], 11);
+
+  msg.bytes.pop_back();
+  EXPECT_FALSE(deserialize(header));
+}
+
+TEST_P(MessageTypesTest, SubmessageHeader) {
+  msg.begin(SubmessageKind::HEARTBEAT, SubMessageFlag::FLAG_FINAL)
+      .padding(300)
+      .end();
+  SubmessageHeader header;
+  ASSERT_TRUE(deserialize(header));
+  EXPECT_EQ(header.submessageId, SubmessageKind::HEARTBEAT);
+  EXPECT_TRUE(header.flags & SubMessageFlag::FLAG_FINAL);
+  EXPECT_EQ(header.octetsToNextHeader, 300);
+}
+
+TEST_P(MessageTypesTest, Heartbeat) {
+  msg.begin(SubmessageKind::HEARTBEAT);
+  writeHeartbeat();
+  msg.end();
+
+  SubmessageHeartbeat hb;
+  ASSERT_TRUE(deserialize(hb));
+  EXPECT_EQ(hb.readerId.entityKey[2], 1);
+  EXPECT_EQ(hb.writerId.entityKind,
+            EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY);
+  EXPECT_EQ(hb.firstSN, (SequenceNumber_t{0, 3}));
+  EXPECT_EQ(hb.lastSN, (SequenceNumber_t{1, 7}));
+  EXPECT_EQ(hb.count.value, 42);
+}
+
+TEST_P(MessageTypesTest, HeartbeatIgnoresPadding) {
+  msg.begin(SubmessageKind::HEARTBEAT);
+  writeHeartbeat();
+  msg.padding(8).end();
+
+  SubmessageHeartbeat hb;
+  ASSERT_TRUE(deserialize(hb));
+  EXPECT_EQ(hb.count.value, 42);
+}
+
+TEST_P(MessageTypesTest, HeartbeatShorterThanItsFieldsIsRejected) {
+  msg.begin(SubmessageKind::HEARTBEAT);
+  writeHeartbeat();
+  // Count would be read from the next submessage
+  msg.end(-4);
+
+  SubmessageHeartbeat hb;
+  EXPECT_FALSE(deserialize(hb));
+}
+
+TEST_P(MessageTypesTest, HeartbeatLongerThanTheMessageIsRejected) {
+  msg.begin(SubmessageKind::HEARTBEAT);
+  writeHeartbeat();
+  msg.end(4);
+
+  SubmessageHeartbeat hb;
+  EXPECT_FALSE(deserialize(hb));
+}
+
+TEST_P(MessageTypesTest, AckNack) {
+  msg.begin(SubmessageKind::ACKNACK);
+  writeAckNack();
+  msg.end();
+
+  SubmessageAckNack ackNack;
+  ASSERT_TRUE(deserialize(ackNack));
+  EXPECT_EQ(ackNack.readerSNState.base, (SequenceNumber_t{0, 5}));
+  EXPECT_EQ(ackNack.readerSNState.numBits, 40u);
+  EXPECT_EQ(ackNack.readerSNState.bitMap[0], 0x80000001u);
+  EXPECT_EQ(ackNack.readerSNState.bitMap[1], 0x80000002u);
+  EXPECT_EQ(ackNack.readerSNState.bitMap[2], 0u);
+  EXPECT_TRUE(ackNack.readerSNState.isSet(0));
+  EXPECT_TRUE(ackNack.readerSNState.isSet(31));
+  EXPECT_FALSE(ackNack.readerSNState.isSet(1));
+  EXPECT_EQ(ackNack.count.value, 9);
+}
+
+TEST_P(MessageTypesTest, AckNackWithEmptySet) {
+  msg.begin(SubmessageKind::ACKNACK);
+  writeAckNack(0);
+  msg.end();
+
+  SubmessageAckNack ackNack;
+  ASSERT_TRUE(deserialize(ackNack));
+  EXPECT_EQ(ackNack.readerSNState.numBits, 0u);
+  EXPECT_EQ(ackNack.count.value, 9);
+}
+
+TEST_P(MessageTypesTest, AckNackTakesBitmapLengthFromNumBits) {
+  msg.begin(SubmessageKind::ACKNACK);
+  writeAckNack();
+  msg.padding(12).end();
+
+  SubmessageAckNack ackNack;
+  ASSERT_TRUE(deserialize(ackNack));
+  EXPECT_EQ(ackNack.readerSNState.bitMap[1], 0x80000002u);
+  EXPECT_EQ(ackNack.readerSNState.bitMap[2], 0u);
+  EXPECT_EQ(ackNack.count.value, 9);
+}
+
+TEST_P(MessageTypesTest, AckNackWithInvalidLengthIsRejected) {
+  SubmessageAckNack ackNack;
+
+  // Bitmap and count don't fit
+  msg.begin(SubmessageKind::ACKNACK);
+  writeAckNack();
+  msg.end(-4);
+  EXPECT_FALSE(deserialize(ackNack));
+
+  // Ends behind the message
+  msg.bytes.clear();
+  msg.begin(SubmessageKind::ACKNACK);
+  writeAckNack();
+  msg.end(4);
+  EXPECT_FALSE(deserialize(ackNack));
+}
+
+TEST_P(MessageTypesTest, AckNackWithTooManyBitsIsRejected) {
+  msg.begin(SubmessageKind::ACKNACK);
+  writeAckNack(SNS_MAX_NUM_BITS + 1);
+  msg.end();
+
+  SubmessageAckNack ackNack;
+  EXPECT_FALSE(deserialize(ackNack));
+}
+
+TEST_P(MessageTypesTest, Gap) {
+  msg.begin(SubmessageKind::GAP);
+  writeGap();
+  msg.end();
+
+  SubmessageGap gap;
+  ASSERT_TRUE(deserialize(gap));
+  EXPECT_EQ(gap.gapStart, (SequenceNumber_t{0, 4}));
+  EXPECT_EQ(gap.gapList.base, (SequenceNumber_t{0, 10}));
+  EXPECT_EQ(gap.gapList.numBits, 33u);
+  EXPECT_TRUE(gap.gapList.isSet(0));
+  EXPECT_FALSE(gap.gapList.isSet(1));
+  EXPECT_TRUE(gap.gapList.isSet(2));
+  EXPECT_TRUE(gap.gapList.isSet(32));
+}
+
+TEST_P(MessageTypesTest, GapWithPaddingOrShortBitmap) {
+  msg.begin(SubmessageKind::GAP);
+  writeGap();
+  msg.padding(16).end();
+  SubmessageGap gap;
+  ASSERT_TRUE(deserialize(gap));
+  EXPECT_EQ(gap.gapList.bitMap[1], 0x80000000u);
+  EXPECT_EQ(gap.gapList.bitMap[2], 0u);
+
+  msg.bytes.clear();
+  msg.begin(SubmessageKind::GAP);
+  writeGap();
+  msg.end(-4);
+  EXPECT_FALSE(deserialize(gap));
+}
+
+TEST_P(MessageTypesTest, NackFrag) {
+  msg.begin(SubmessageKind::NACK_FRAG)
+      .entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+      .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+      .sn(0, 12)
+      .u32(3)
+      .u32(2)
+      .u32(0xC0000000u)
+      .u32(6)
+      .end();
+
+  SubmessageNackFrag nackFrag;
+  ASSERT_TRUE(deserialize(nackFrag));
+  EXPECT_EQ(nackFrag.writerSN, (SequenceNumber_t{0, 12}));
+  EXPECT_EQ(nackFrag.fragmentNumberState.base.value, 3u);
+  EXPECT_EQ(nackFrag.fragmentNumberState.numBits, 2u);
+  EXPECT_TRUE(nackFrag.fragmentNumberState.isSet(1));
+  EXPECT_EQ(nackFrag.count.value, 6);
+
+  msg.setLength(static_cast<uint16_t>(msg.bytes.size()));
+  EXPECT_FALSE(deserialize(nackFrag));
+}
+
+TEST_P(MessageTypesTest, Data) {
+  msg.begin(SubmessageKind::DATA, SubMessageFlag::FLAG_DATA_PAYLOAD)
+      .u16(0)
+      .u16(16)
+      .entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+      .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+      .sn(0, 8)
+      .padding(20)
+      .end();
+
+  SubmessageData data;
+  ASSERT_TRUE(deserialize(data));
+  EXPECT_EQ(data.octetsToInlineQos, 16);
+  EXPECT_EQ(data.writerId.entityKey[2], 2);
+  EXPECT_EQ(data.writerSN, (SequenceNumber_t{0, 8}));
+
+  msg.end(1);
+  EXPECT_FALSE(deserialize(data));
+}
+
+TEST_P(MessageTypesTest, DataFrag) {
+  msg.begin(SubmessageKind::DATA_FRAG)
+      .u16(0)
+      .u16(28)
+      .entityId(1, EntityKind_t::USER_DEFINED_READER_WITHOUT_KEY)
+      .entityId(2, EntityKind_t::USER_DEFINED_WRITER_WITHOUT_KEY)
+      .sn(0, 8)
+      .u32(4)
+      .u16(2)
+      .u16(1000)
+      .u32(9000)
+      .padding(2000)
+      .end();
+
+  SubmessageDataFrag dataFrag;
+  ASSERT_TRUE(deserialize(dataFrag));
+  EXPECT_EQ(dataFrag.fragmentStartingNum.value, 4u);
+  EXPECT_EQ(dataFrag.fragmentsInSubmessage, 2);
+  EXPECT_EQ(dataFrag.fragmentSize, 1000);
+  EXPECT_EQ(dataFrag.sampleSize, 9000u);
+
+  // Shorter than its own fields
+  msg.setLength(20);
+  EXPECT_FALSE(deserialize(dataFrag));
+}
+
+TEST_P(MessageTypesTest, SubmessagesSpanningSeveralPbufs) {
+  msg.padding(5).begin(SubmessageKind::ACKNACK);
+  writeAckNack(SNS_MAX_NUM_BITS);
+  // Padding makes it larger than what is linearized at once
+  msg.padding(200).end();
+
+  SubmessageAckNack ackNack;
+  ASSERT_TRUE(deserialize(ackNack, 7, 5));
+  EXPECT_EQ(ackNack.readerSNState.numBits, SNS_MAX_NUM_BITS);
+  EXPECT_EQ(ackNack.readerSNState.bitMap[7], 0x80000008u);
+  EXPECT_EQ(ackNack.count.value, 9);
+
+  SubmessageHeader header;
+  ASSERT_TRUE(deserialize(header, 3, 5));
+  EXPECT_EQ(header.octetsToNextHeader, msg.bytes.size() - 5 - 4);
+}
+
+TEST_P(MessageTypesTest, InlineQos) {
+  msg.begin(SubmessageKind::DATA, SubMessageFlag::FLAG_INLINE_QOS)
+      .u16(SMElement::PID_KEY_HASH)
+      .u16(16);
+  for (uint8_t i = 0; i < 16; ++i) {
+    msg.u8(i);
+  }
+  msg.u16(SMElement::PID_STATUS_INFO).u16(4).u8(0).u8(0).u8(0).u8(3);
+  msg.u16(SMElement::PID_SENTINEL).u16(0).end();
+  const auto size = static_cast<DataSize_t>(msg.bytes.size() - 4);
+
+  Chain chain(msg.bytes, 9);
+  MessageProcessingInfo info(chain.get());
+  SubmessageHeader header;
+  ASSERT_TRUE(deserializeMessage(info, header));
+
+  InlineQos_t qos;
+  DataSize_t length = 0;
+  ASSERT_TRUE(deserializeInlineQos(info, header, 4, size, qos, length));
+  EXPECT_EQ(length, size);
+  ASSERT_TRUE(qos.hasKeyHash);
+  EXPECT_EQ(qos.keyHash.value[15], 15);
+  ASSERT_TRUE(qos.hasStatusInfo);
+  EXPECT_EQ(qos.statusInfo, 3);
+
+  // The sentinel lies behind maxLength
+  InlineQos_t truncated;
+  EXPECT_FALSE(deserializeInlineQos(info, header, 4, size - 4, truncated,
+                                    length));
+}
+
+TEST_P(MessageTypesTest, ReadsPositionsOfAChainInAnyOrder) {
+  msg.begin(SubmessageKind::HEARTBEAT);
+  writeHeartbeat();
+  msg.end();
+  const auto heartbeatSize = static_cast<DataSize_t>(msg.bytes.size());
+  msg.begin(SubmessageKind::GAP);
+  writeGap();
+  msg.end();
+
+  Chain chain(msg.bytes, 5);
+  MessageProcessingInfo info(chain.get());
+  SubmessageGap gap;
+  SubmessageHeartbeat hb;
+  info.nextPos = heartbeatSize;
+  ASSERT_TRUE(deserializeMessage(info, gap));
+  EXPECT_EQ(gap.gapList.base, (SequenceNumber_t{0, 10}));
+
+  info.nextPos = 0;
+  ASSERT_TRUE(deserializeMessage(info, hb));
+  EXPECT_EQ(hb.lastSN, (SequenceNumber_t{1, 7}));
+
+  info.nextPos = heartbeatSize;
+  ASSERT_TRUE(deserializeMessage(info, gap));
+  EXPECT_EQ(gap.gapStart, (SequenceNumber_t{0, 4}));
+}
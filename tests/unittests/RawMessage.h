@@ -0,0 +1,143 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#ifndef RTPS_TESTS_RAWMESSAGE_H
+#define RTPS_TESTS_RAWMESSAGE_H
+
+#include "lwip/pbuf.h"
+#include "rtps/messages/MessageTypes.h"
+
+#include <vector>
+
+namespace rtps {
+namespace test {
+
+//! Writes submessages in either byte order
+class RawMessage {
+public:
+  explicit RawMessage(bool littleEndian) : m_littleEndian(littleEndian) {}
+
+  std::vector<uint8_t> bytes;
+
+  RawMessage &u8(uint8_t value) {
+    bytes.push_back(value);
+    return *this;
+  }
+
+  RawMessage &u16(uint16_t value) {
+    return m_littleEndian ? u8(value & 0xFF).u8(value >> 8)
+                          : u8(value >> 8).u8(value & 0xFF);
+  }
+
+  RawMessage &u32(uint32_t value) {
+    return m_littleEndian ? u16(value & 0xFFFF).u16(value >> 16)
+                          : u16(value >> 16).u16(value & 0xFFFF);
+  }
+
+  RawMessage &sn(int32_t high, uint32_t low) {
+    return u32(static_cast<uint32_t>(high)).u32(low);
+  }
+
+  RawMessage &entityId(uint8_t key, EntityKind_t kind) {
+    return u8(0).u8(0).u8(key).u8(static_cast<uint8_t>(kind));
+  }
+
+  RawMessage &padding(size_t size) {
+    bytes.insert(bytes.end(), size, 0xEE);
+    return *this;
+  }
+
+  //! RTPS header of a message from the participant with the given prefix
+  RawMessage &header(const GuidPrefix_t &prefix) {
+    bytes.insert(bytes.end(), RTPS_PROTOCOL_NAME.begin(),
+                 RTPS_PROTOCOL_NAME.end());
+    u8(PROTOCOLVERSION.major).u8(PROTOCOLVERSION.minor);
+    bytes.insert(bytes.end(), VENDOR_UNKNOWN.vendorId.begin(),
+                 VENDOR_UNKNOWN.vendorId.end());
+    bytes.insert(bytes.end(), prefix.id.begin(), prefix.id.end());
+    return *this;
+  }
+
+  //! Starts a submessage, end() fills in its length
+  RawMessage &begin(SubmessageKind kind, uint8_t flags = 0) {
+    m_start = bytes.size();
+    u8(static_cast<uint8_t>(kind));
+    u8(flags | (m_littleEndian ? SubMessageFlag::FLAG_LITTLE_ENDIAN
+                               : SubMessageFlag::FLAG_BIG_ENDIAN));
+    return u16(0);
+  }
+
+  //! Sets octetsToNextHeader to the written length plus delta
+  RawMessage &end(int delta = 0) {
+    return setLength(
+        static_cast<uint16_t>(bytes.size() - m_start - 4 + delta));
+  }
+
+  RawMessage &setLength(uint16_t length) {
+    const size_t pos = m_start + 2;
+    if (m_littleEndian) {
+      bytes[pos] = length & 0xFF;
+      bytes[pos + 1] = length >> 8;
+    } else {
+      bytes[pos] = length >> 8;
+      bytes[pos + 1] = length & 0xFF;
+    }
+    return *this;
+  }
+
+private:
+  bool m_littleEndian;
+  size_t m_start = 0;
+};
+
+//! Owns the bytes as a chain of pbufs of at most segmentSize bytes each
+class Chain {
+public:
+  Chain(const std::vector<uint8_t> &bytes, uint16_t segmentSize = 0xFFFF) {
+    for (size_t pos = 0; pos < bytes.size(); pos += segmentSize) {
+      const auto size = static_cast<uint16_t>(
+          bytes.size() - pos < segmentSize ? bytes.size() - pos : segmentSize);
+      pbuf *segment = pbuf_alloc(PBUF_RAW, size, PBUF_RAM);
+      pbuf_take(segment, bytes.data() + pos, size);
+      if (m_head == nullptr) {
+        m_head = segment;
+      } else {
+        pbuf_cat(m_head, segment);
+      }
+    }
+  }
+  ~Chain() { pbuf_free(m_head); }
+  Chain(const Chain &) = delete;
+  Chain &operator=(const Chain &) = delete;
+
+  const pbuf *get() const { return m_head; }
+
+private:
+  pbuf *m_head = nullptr;
+};
+
+} // namespace test
+} // namespace rtps
+
+#endif // RTPS_TESTS_RAWMESSAGE_H
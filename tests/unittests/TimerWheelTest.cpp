@@ -0,0 +1,249 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "rtps/utils/TimerWheel.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using rtps::Timer;
+using rtps::TimerWheel;
+
+namespace {
+
+// Upper bound on the delay of a callback, generous for loaded test machines
+constexpr uint32_t MAX_LATENESS_MS = 500;
+
+struct Probe {
+  Timer timer{onFire, this};
+  std::atomic<uint32_t> count{0};
+  std::atomic<uint32_t> firedAt{0};
+  TimerWheel *wheel = nullptr;
+  uint32_t rescheduleMs = 0;
+  uint32_t maxCount = 0;
+  uint32_t busyMs = 0;
+  std::atomic<bool> running{false};
+  std::mutex *orderMutex = nullptr;
+  std::vector<Probe *> *order = nullptr;
+
+  static void onFire(void *arg) {
+    auto *probe = static_cast<Probe *>(arg);
+    probe->running = true;
+    probe->firedAt = sys_now();
+    if (probe->order != nullptr) {
+      std::lock_guard<std::mutex> lock(*probe->orderMutex);
+      probe->order->push_back(probe);
+    }
+    if (probe->busyMs != 0) {
+      sys_msleep(probe->busyMs);
+    }
+    if (++probe->count < probe->maxCount) {
+      probe->wheel->schedule(probe->timer, probe->rescheduleMs);
+    }
+    probe->running = false;
+  }
+};
+
+template <typename PREDICATE>
+bool waitFor(PREDICATE predicate, uint32_t timeoutMs = MAX_LATENESS_MS * 4) {
+  const uint32_t start = sys_now();
+  while (!predicate()) {
+    if (sys_now() - start > timeoutMs) {
+      return false;
+    }
+    sys_msleep(1);
+  }
+  return true;
+}
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+  TimerWheel wheel;
+
+  void SetUp() override { ASSERT_TRUE(wheel.start()); }
+};
+
+} // namespace
+
+TEST_F(TimerWheelTest, FiresOnceAfterDelay) {
+  Probe probe;
+  const uint32_t scheduledAt = sys_now();
+  wheel.schedule(probe.timer, 50);
+  EXPECT_TRUE(probe.timer.isArmed());
+
+  ASSERT_TRUE(waitFor([&] { return probe.count == 1; }));
+  EXPECT_GE(probe.firedAt - scheduledAt, 50u);
+  EXPECT_LE(probe.firedAt - scheduledAt, 50 + MAX_LATENESS_MS);
+  EXPECT_FALSE(probe.timer.isArmed());
+
+  sys_msleep(100);
+  EXPECT_EQ(probe.count, 1u);
+}
+
+TEST_F(TimerWheelTest, CancelledTimerDoesNotFire) {
+  Probe probe;
+  wheel.schedule(probe.timer, 50);
+  wheel.cancel(probe.timer);
+  EXPECT_FALSE(probe.timer.isArmed());
+
+  sys_msleep(150);
+  EXPECT_EQ(probe.count, 0u);
+}
+
+TEST_F(TimerWheelTest, SchedulingAgainMovesTheDeadline) {
+  Probe early;
+  Probe late;
+  const uint32_t scheduledAt = sys_now();
+  wheel.schedule(early.timer, 2000);
+  wheel.schedule(early.timer, 20);
+  wheel.schedule(late.timer, 20);
+  wheel.schedule(late.timer, 300);
+
+  ASSERT_TRUE(waitFor([&] { return early.count == 1; }));
+  EXPECT_LT(early.firedAt - scheduledAt, 20 + MAX_LATENESS_MS);
+  EXPECT_EQ(late.count, 0u);
+
+  ASSERT_TRUE(waitFor([&] { return late.count == 1; }));
+  EXPECT_GE(late.firedAt - scheduledAt, 300u);
+  sys_msleep(50);
+  EXPECT_EQ(early.count, 1u);
+}
+
+TEST_F(TimerWheelTest, CallbacksMayRescheduleTheirTimer) {
+  Probe probe;
+  probe.wheel = &wheel;
+  probe.rescheduleMs = 5;
+  probe.maxCount = 5;
+  wheel.schedule(probe.timer, 0);
+
+  ASSERT_TRUE(waitFor([&] { return probe.count == 5; }));
+  sys_msleep(50);
+  EXPECT_EQ(probe.count, 5u);
+  EXPECT_FALSE(probe.timer.isArmed());
+}
+
+TEST_F(TimerWheelTest, FiresInOrderOfDeadlines) {
+  constexpr uint32_t tickMs = rtps::Config::TIMER_WHEEL_TICK_MS;
+  const uint32_t delays[] = {8 * tickMs, 2 * tickMs, 5 * tickMs, 11 * tickMs};
+  std::mutex orderMutex;
+  std::vector<Probe *> order;
+  Probe probes[4];
+  for (uint32_t i = 0; i < 4; ++i) {
+    probes[i].orderMutex = &orderMutex;
+    probes[i].order = &order;
+    wheel.schedule(probes[i].timer, delays[i]);
+  }
+
+  ASSERT_TRUE(waitFor([&] {
+    std::lock_guard<std::mutex> lock(orderMutex);
+    return order.size() == 4;
+  }));
+  EXPECT_EQ(order[0], &probes[1]);
+  EXPECT_EQ(order[1], &probes[2]);
+  EXPECT_EQ(order[2], &probes[0]);
+  EXPECT_EQ(order[3], &probes[3]);
+}
+
+TEST_F(TimerWheelTest, TimersBeyondOneRotationWaitForTheirDeadline) {
+  constexpr uint32_t rotationMs =
+      rtps::Config::TIMER_WHEEL_TICK_MS * rtps::Config::TIMER_WHEEL_NUM_SLOTS;
+  Probe near;
+  Probe far;
+  const uint32_t scheduledAt = sys_now();
+  // Both hash into the same slot
+  wheel.schedule(near.timer, 50);
+  wheel.schedule(far.timer, 50 + rotationMs);
+
+  ASSERT_TRUE(waitFor([&] { return near.count == 1; }));
+  EXPECT_EQ(far.count, 0u);
+  ASSERT_TRUE(
+      waitFor([&] { return far.count == 1; }, rotationMs + MAX_LATENESS_MS));
+  EXPECT_GE(far.firedAt - scheduledAt, 50 + rotationMs);
+}
+
+TEST_F(TimerWheelTest, CancelWaitsForRunningCallback) {
+  Probe probe;
+  probe.busyMs = 100;
+  wheel.schedule(probe.timer, 0);
+  ASSERT_TRUE(waitFor([&] { return probe.running.load(); }));
+
+  wheel.cancel(probe.timer);
+  EXPECT_FALSE(probe.running);
+  EXPECT_EQ(probe.count, 1u);
+}
+
+TEST_F(TimerWheelTest, StopReturnsOnceTheThreadExited) {
+  Probe probe;
+  probe.wheel = &wheel;
+  probe.rescheduleMs = 1;
+  probe.maxCount = UINT32_MAX;
+  wheel.schedule(probe.timer, 0);
+  ASSERT_TRUE(waitFor([&] { return probe.count > 3; }));
+
+  wheel.stop();
+  const uint32_t count = probe.count;
+  EXPECT_FALSE(probe.running);
+  sys_msleep(50);
+  EXPECT_EQ(probe.count, count);
+
+  // Armed timers survive a restart
+  probe.maxCount = 0;
+  ASSERT_TRUE(wheel.start());
+  ASSERT_TRUE(waitFor([&] { return probe.count > count; }));
+}
+
+TEST_F(TimerWheelTest, FiresManyTimersOnceEach) {
+  constexpr uint32_t numTimers = 200;
+  std::vector<std::unique_ptr<Probe>> probes;
+  std::vector<uint32_t> deadlines;
+  for (uint32_t i = 0; i < numTimers; ++i) {
+    probes.push_back(std::make_unique<Probe>());
+    const uint32_t delay = (i * 37) % 300;
+    deadlines.push_back(sys_now() + delay);
+    wheel.schedule(probes.back()->timer, delay);
+  }
+  // Cancel every fourth one
+  for (uint32_t i = 0; i < numTimers; i += 4) {
+    wheel.cancel(probes[i]->timer);
+  }
+
+  ASSERT_TRUE(waitFor([&] {
+    uint32_t numFired = 0;
+    for (const auto &probe : probes) {
+      numFired += probe->count;
+    }
+    return numFired == numTimers - numTimers / 4;
+  }));
+  sys_msleep(50);
+  for (uint32_t i = 0; i < numTimers; ++i) {
+    EXPECT_EQ(probes[i]->count, i % 4 == 0 ? 0u : 1u) << i;
+    if (i % 4 != 0) {
+      EXPECT_GE(probes[i]->firedAt, deadlines[i]) << i;
+    }
+  }
+}
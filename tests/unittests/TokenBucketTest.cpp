@@ -0,0 +1,134 @@
+/*
+The MIT License
+Copyright (c) 2019 Lehrstuhl Informatik 11 - RWTH Aachen University
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE
+
+This file is part of embeddedRTPS.
+
+Author: i11 - Embedded Software, RWTH Aachen University
+*/
+
+#include "HostPort.h"
+#include "rtps/communication/TokenBucket.h"
+
+#include <gtest/gtest.h>
+
+using rtps::TokenBucket;
+
+/*
+ * The time is moved forward with hostport::advanceClock. Real time passes as
+ * well, so the checks leave room for a few bytes refilled in between.
+ */
+
+TEST(TokenBucketTest, RateZeroDisablesTheLimit) {
+  TokenBucket bucket(0, 0);
+  EXPECT_FALSE(bucket.isLimited());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(bucket.tryConsume(100000));
+  }
+  EXPECT_EQ(bucket.getWaitTimeMs(100000), 0u);
+}
+
+TEST(TokenBucketTest, AllowsBurstThenLimits) {
+  TokenBucket bucket(1000, 500);
+  EXPECT_TRUE(bucket.isLimited());
+  EXPECT_TRUE(bucket.tryConsume(200));
+  EXPECT_TRUE(bucket.tryConsume(200));
+  EXPECT_FALSE(bucket.tryConsume(200));
+  EXPECT_TRUE(bucket.tryConsume(90));
+  EXPECT_FALSE(bucket.tryConsume(50));
+}
+
+TEST(TokenBucketTest, RefillsWithRate) {
+  TokenBucket bucket(1000, 500);
+  ASSERT_TRUE(bucket.tryConsume(500));
+  EXPECT_FALSE(bucket.tryConsume(50));
+
+  hostport::advanceClock(100);
+  EXPECT_TRUE(bucket.tryConsume(95));
+  EXPECT_FALSE(bucket.tryConsume(50));
+}
+
+TEST(TokenBucketTest, HoldsAtMostTheBurst) {
+  TokenBucket bucket(1000, 500);
+  ASSERT_TRUE(bucket.tryConsume(500));
+
+  hostport::advanceClock(10000);
+  EXPECT_TRUE(bucket.tryConsume(500));
+  EXPECT_FALSE(bucket.tryConsume(50));
+}
+
+TEST(TokenBucketTest, KeepsFractionsOfFrequentRefills) {
+  // 1.5 bytes per millisecond
+  TokenBucket bucket(1500, 10000);
+  ASSERT_TRUE(bucket.tryConsume(10000));
+
+  for (int i = 0; i < 1000; ++i) {
+    hostport::advanceClock(1);
+    EXPECT_FALSE(bucket.tryConsume(5000));
+  }
+  EXPECT_TRUE(bucket.tryConsume(1490));
+  EXPECT_FALSE(bucket.tryConsume(50));
+}
+
+TEST(TokenBucketTest, LargeSamplesGoIntoDebt) {
+  TokenBucket bucket(1000, 500);
+
+  // Only needs a full bucket, not the whole sample
+  EXPECT_TRUE(bucket.tryConsume(2000));
+  EXPECT_FALSE(bucket.tryConsume(1));
+  const uint32_t waitTime = bucket.getWaitTimeMs(1);
+  EXPECT_GE(waitTime, 1490u);
+  EXPECT_LE(waitTime, 1501u);
+
+  // The debt is paid back first
+  hostport::advanceClock(1000);
+  EXPECT_FALSE(bucket.tryConsume(1));
+  hostport::advanceClock(600);
+  EXPECT_TRUE(bucket.tryConsume(90));
+}
+
+TEST(TokenBucketTest, ReportsTimeUntilConsumeSucceeds) {
+  TokenBucket bucket(1000, 500);
+  EXPECT_EQ(bucket.getWaitTimeMs(100), 1u);
+
+  ASSERT_TRUE(bucket.tryConsume(500));
+  uint32_t waitTime = bucket.getWaitTimeMs(250);
+  EXPECT_GE(waitTime, 240u);
+  EXPECT_LE(waitTime, 250u);
+
+  // Waiting for a full bucket is enough for samples larger than the burst
+  waitTime = bucket.getWaitTimeMs(5000);
+  EXPECT_GE(waitTime, 490u);
+  EXPECT_LE(waitTime, 500u);
+
+  hostport::advanceClock(waitTime);
+  EXPECT_TRUE(bucket.tryConsume(5000));
+}
+
+TEST(TokenBucketTest, ConfigureStartsWithFullBucket) {
+  TokenBucket bucket(1000, 500);
+  ASSERT_TRUE(bucket.tryConsume(2000));
+
+  bucket.configure(2000, 100);
+  EXPECT_TRUE(bucket.tryConsume(100));
+  EXPECT_FALSE(bucket.tryConsume(50));
+
+  bucket.configure(0, 0);
+  EXPECT_FALSE(bucket.isLimited());
+  EXPECT_TRUE(bucket.tryConsume(100000));
+}